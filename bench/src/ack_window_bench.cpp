@@ -0,0 +1,272 @@
+// 确认窗口基准：客户端经本地延迟代理（不依赖 netem）向确认端发送私聊消息，
+// 确认端与服务器相同，每处理完一次读入的帧回复一条累计 MESSAGE_ACK。
+// 对比窗口为 1（停等）与更大窗口在 1ms 和 50ms 往返时延下的已确认消息吞吐
+// 用法: ack_window_bench [每组秒数] [内容字节数]
+#include "AckWindow.h"
+#include "ChatEnvelope.h"
+#include "Frame.h"
+#include "FrameDecoder.h"
+#include "FrameWriter.h"
+#include "Message.h"
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/StreamSocket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // 单向延迟管道：读线程给每块数据打上到期时间，写线程到期后原样转发，读到 EOF 后关闭下游写方向
+    class DelayPipe
+    {
+    public:
+        DelayPipe(Poco::Net::StreamSocket from, Poco::Net::StreamSocket to, Clock::duration delay)
+            : from_(from), to_(to), delay_(delay)
+        {
+            reader_ = std::thread(&DelayPipe::readLoop, this);
+            writer_ = std::thread(&DelayPipe::writeLoop, this);
+        }
+
+        ~DelayPipe()
+        {
+            reader_.join();
+            writer_.join();
+        }
+
+    private:
+        struct Chunk
+        {
+            Clock::time_point due;
+            std::string bytes;
+        };
+
+        void readLoop()
+        {
+            std::vector<char> buffer(64 * 1024);
+            while (true)
+            {
+                int n = 0;
+                try
+                {
+                    n = from_.receiveBytes(buffer.data(), static_cast<int>(buffer.size()));
+                }
+                catch (const Poco::Exception &)
+                {
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (n <= 0)
+                {
+                    closed_ = true;
+                    ready_.notify_one();
+                    return;
+                }
+                chunks_.push_back({Clock::now() + delay_, std::string(buffer.data(), static_cast<size_t>(n))});
+                ready_.notify_one();
+            }
+        }
+
+        void writeLoop()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true)
+            {
+                ready_.wait(lock, [this]
+                            { return closed_ || !chunks_.empty(); });
+                if (chunks_.empty())
+                {
+                    break;
+                }
+                Chunk chunk = std::move(chunks_.front());
+                chunks_.pop_front();
+                lock.unlock();
+                std::this_thread::sleep_until(chunk.due);
+                try
+                {
+                    to_.sendBytes(chunk.bytes.data(), static_cast<int>(chunk.bytes.size()));
+                }
+                catch (const Poco::Exception &)
+                {
+                }
+                lock.lock();
+            }
+            try
+            {
+                to_.shutdownSend();
+            }
+            catch (const Poco::Exception &)
+            {
+            }
+        }
+
+        Poco::Net::StreamSocket from_;
+        Poco::Net::StreamSocket to_;
+        Clock::duration delay_;
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::deque<Chunk> chunks_;
+        bool closed_ = false;
+        std::thread reader_;
+        std::thread writer_;
+    };
+
+    // 确认端：与 ChatConnection 相同，缓冲区中的帧全部处理完、再次读取之前才回复一条累计确认
+    void runAckEndpoint(Poco::Net::StreamSocket socket)
+    {
+        FrameDecoder decoder;
+        FrameWriter writer(socket);
+        uint64_t lastReceived = 0;
+        uint64_t lastAcked = 0;
+        try
+        {
+            while (true)
+            {
+                std::string_view payload;
+                while (decoder.nextFrame(payload))
+                {
+                    ChatEnvelope envelope;
+                    if (envelope.parse(payload))
+                    {
+                        lastReceived = std::max(lastReceived, envelope.getClientId());
+                    }
+                }
+                if (lastReceived > lastAcked)
+                {
+                    lastAcked = lastReceived;
+                    writer.enqueue(Frame::create(MessageAck(lastAcked), WireFormat::BINARY));
+                    writer.flush();
+                }
+                if (decoder.readFrom(socket) == FrameDecoder::ReadResult::CLOSED)
+                {
+                    break;
+                }
+            }
+            socket.shutdownSend();
+        }
+        catch (const Poco::Exception &)
+        {
+        }
+    }
+
+    struct Result
+    {
+        uint64_t acked;
+        uint64_t acks;
+        double seconds;
+    };
+
+    Result runClient(const Poco::Net::SocketAddress &address, size_t window, double seconds, const std::string &content)
+    {
+        Poco::Net::StreamSocket socket(address);
+        FrameWriter::configureSocket(socket);
+        AckWindow ackWindow(window);
+        std::atomic<uint64_t> acked{0};
+        std::atomic<uint64_t> acks{0};
+
+        std::thread receiver([&]
+                             {
+            FrameDecoder decoder;
+            try
+            {
+                while (decoder.readFrom(socket) != FrameDecoder::ReadResult::CLOSED)
+                {
+                    std::string_view payload;
+                    while (decoder.nextFrame(payload))
+                    {
+                        auto message = Message::parseMessage(payload);
+                        if (message && message->getType() == MessageType::MESSAGE_ACK)
+                        {
+                            acked += ackWindow.acknowledge(static_cast<MessageAck &>(*message).getAckId());
+                            ++acks;
+                        }
+                    }
+                }
+            }
+            catch (const Poco::Exception &)
+            {
+            } });
+
+        FrameWriter writer(socket);
+        auto start = Clock::now();
+        auto stop = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        while (Clock::now() < stop)
+        {
+            if (!ackWindow.waitForSpace(std::chrono::milliseconds(10)))
+            {
+                continue;
+            }
+            ChatMessage message("bench", "bench", "peer", content);
+            FramePtr frame = Frame::create(message, WireFormat::BINARY);
+            ackWindow.push(message.getId(), frame);
+            writer.enqueue(frame);
+            writer.flush();
+        }
+        Result result{acked.load(), acks.load(), std::chrono::duration<double>(Clock::now() - start).count()};
+
+        // 等待在途消息确认完再关闭，之后整条链路依次收到 EOF
+        auto drainUntil = Clock::now() + std::chrono::seconds(2);
+        while (ackWindow.size() > 0 && Clock::now() < drainUntil)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        socket.shutdownSend();
+        receiver.join();
+        return result;
+    }
+
+    Result runCase(size_t window, Clock::duration rtt, double seconds, const std::string &content)
+    {
+        Poco::Net::ServerSocket endpointListener(Poco::Net::SocketAddress("127.0.0.1", 0));
+        Poco::Net::ServerSocket proxyListener(Poco::Net::SocketAddress("127.0.0.1", 0));
+        std::thread endpoint([&]
+                             { runAckEndpoint(endpointListener.acceptConnection()); });
+
+        Result result{};
+        std::thread client([&]
+                           { result = runClient(proxyListener.address(), window, seconds, content); });
+
+        Poco::Net::StreamSocket downstream = proxyListener.acceptConnection();
+        Poco::Net::StreamSocket upstream(endpointListener.address());
+        FrameWriter::configureSocket(downstream);
+        FrameWriter::configureSocket(upstream);
+        {
+            DelayPipe forward(downstream, upstream, rtt / 2);
+            DelayPipe backward(upstream, downstream, rtt / 2);
+            client.join();
+        }
+        endpoint.join();
+        return result;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc >= 2 ? std::stod(argv[1]) : 3.0;
+    size_t contentBytes = argc >= 3 ? std::stoul(argv[2]) : 64;
+    std::string content(contentBytes, 'x');
+
+    const std::chrono::milliseconds rtts[] = {std::chrono::milliseconds(1), std::chrono::milliseconds(50)};
+    const size_t windows[] = {1, 16, 256, 4096};
+
+    std::printf("%8s %8s %14s %14s %12s\n", "rtt_ms", "window", "acked_msg/s", "msgs_per_ack", "acked");
+    for (auto rtt : rtts)
+    {
+        for (size_t window : windows)
+        {
+            Result result = runCase(window, rtt, seconds, content);
+            std::printf("%8lld %8zu %14.0f %14.1f %12llu\n", static_cast<long long>(rtt.count()), window,
+                        result.acked / result.seconds, result.acks ? double(result.acked) / double(result.acks) : 0.0,
+                        static_cast<unsigned long long>(result.acked));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+// 批量帧基准：模拟写者每次从出站队列取出一批小消息，对比逐帧写出与合并为 BATCH 帧写出时
+// 接收方（FrameDecoder + 完整解析每条消息）的小消息吞吐、每条消息的线路字节数和帧数
+// 用法: batch_frame_bench [消息数] [每批帧数]
+#include "Frame.h"
+#include "FrameDecoder.h"
+#include "FrameWriter.h"
+#include "Message.h"
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/StreamSocket.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Result
+    {
+        double messagesPerSecond;
+        double bytesPerMessage;
+        double framesPerMessage;
+    };
+
+    // 接收端与客户端的 MessageHandler 相同：取出帧，BATCH 帧拆开后逐条完整解析
+    void receive(Poco::Net::StreamSocket &socket, size_t messages, uint64_t &bytes, uint64_t &frames)
+    {
+        FrameDecoder decoder;
+        std::vector<std::string_view> payloads;
+        size_t parsed = 0;
+        while (parsed < messages)
+        {
+            if (decoder.readFrom(socket) == FrameDecoder::ReadResult::CLOSED)
+            {
+                return;
+            }
+            std::string_view payload;
+            while (decoder.nextFrame(payload))
+            {
+                ++frames;
+                bytes += Frame::kHeaderSize + payload.size();
+                if (!Frame::unpackBatch(payload, payloads))
+                {
+                    payloads.assign(1, payload);
+                }
+                for (std::string_view inner : payloads)
+                {
+                    if (Message::parseMessage(inner))
+                    {
+                        ++parsed;
+                    }
+                }
+            }
+        }
+    }
+
+    Result run(Poco::Net::StreamSocket &sender, Poco::Net::StreamSocket &receiver, const FramePtr &frame,
+               size_t messages, size_t burst, bool batching)
+    {
+        uint64_t bytes = 0;
+        uint64_t frames = 0;
+        std::thread drain([&]
+                          { receive(receiver, messages, bytes, frames); });
+
+        auto start = std::chrono::steady_clock::now();
+        FrameWriter writer(sender);
+        std::vector<FramePtr> batch;
+        for (size_t i = 0; i < messages; i += burst)
+        {
+            batch.assign(std::min(burst, messages - i), frame);
+            if (batching)
+            {
+                writer.enqueueBatched(batch);
+            }
+            else
+            {
+                for (const auto &f : batch)
+                {
+                    writer.enqueue(f);
+                }
+            }
+            writer.flush();
+        }
+        drain.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return {messages / seconds, double(bytes) / double(messages), double(frames) / double(messages)};
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc >= 2 ? std::stoul(argv[1]) : 500000;
+    size_t burst = argc >= 3 ? std::stoul(argv[2]) : 32;
+
+    Poco::Net::ServerSocket listener(Poco::Net::SocketAddress("127.0.0.1", 0));
+    Poco::Net::StreamSocket sender(listener.address());
+    Poco::Net::StreamSocket receiver = listener.acceptConnection();
+    FrameWriter::configureSocket(sender);
+
+    std::printf("%-8s %8s %-9s %14s %12s %12s\n", "format", "content", "batching", "msgs/sec", "bytes/msg", "frames/msg");
+    for (WireFormat format : {WireFormat::JSON, WireFormat::BINARY})
+    {
+        for (size_t contentBytes : {16, 128})
+        {
+            FramePtr frame = Frame::create(ChatMessage("123456789", "alice", std::string(contentBytes, 'x')), format);
+            for (bool batching : {false, true})
+            {
+                Result result = run(sender, receiver, frame, messages, burst, batching);
+                std::printf("%-8s %8zu %-9s %14.0f %12.1f %12.3f\n", format == WireFormat::JSON ? "json" : "binary",
+                            contentBytes, batching ? "on" : "off", result.messagesPerSecond, result.bytesPerMessage,
+                            result.framesPerMessage);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// 广播扇出基准：对比逐个接收者序列化与共享预编码帧两种方式的单次广播 CPU 开销
+#include "Frame.h"
+#include "Message.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 模拟每个接收者的待发送队列
+    struct Recipient
+    {
+        std::vector<std::string> ownedFrames;
+        std::vector<FramePtr> sharedFrames;
+    };
+
+    // 旧路径：每个接收者各自序列化并拼装长度头
+    void broadcastSerializeEach(const ChatMessage &message, std::vector<Recipient> &recipients)
+    {
+        for (auto &recipient : recipients)
+        {
+            std::string payload = message.serialize();
+            uint32_t length = static_cast<uint32_t>(payload.size());
+            std::string frame(Frame::kHeaderSize + payload.size(), '\0');
+            frame[0] = static_cast<char>(length >> 24);
+            frame[1] = static_cast<char>(length >> 16);
+            frame[2] = static_cast<char>(length >> 8);
+            frame[3] = static_cast<char>(length);
+            std::memcpy(&frame[Frame::kHeaderSize], payload.data(), payload.size());
+            recipient.ownedFrames.push_back(std::move(frame));
+        }
+    }
+
+    // 新路径：编码一次，接收者只增加引用计数
+    void broadcastSharedFrame(const ChatMessage &message, std::vector<Recipient> &recipients)
+    {
+        FramePtr frame = Frame::create(message, WireFormat::JSON);
+        for (auto &recipient : recipients)
+        {
+            recipient.sharedFrames.push_back(frame);
+        }
+    }
+
+    template <typename Fn>
+    double measureUs(int rounds, std::vector<Recipient> &recipients, Fn fn)
+    {
+        double total = 0;
+        for (int i = 0; i < rounds; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            fn(recipients);
+            total += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            for (auto &recipient : recipients)
+            {
+                recipient.ownedFrames.clear();
+                recipient.sharedFrames.clear();
+            }
+        }
+        return total / rounds;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc >= 2 ? std::stoi(argv[1]) : 50;
+    ChatMessage message("123456789", "alice", std::string(200, 'x'));
+
+    std::printf("%-12s %18s %18s %10s\n", "recipients", "serialize-each us", "shared-frame us", "speedup");
+    for (size_t count : {1000, 10000})
+    {
+        std::vector<Recipient> recipients(count);
+        double each = measureUs(rounds, recipients, [&](std::vector<Recipient> &r)
+                                { broadcastSerializeEach(message, r); });
+        double shared = measureUs(rounds, recipients, [&](std::vector<Recipient> &r)
+                                  { broadcastSharedFrame(message, r); });
+        std::printf("%-12zu %18.1f %18.1f %9.1fx\n", count, each, shared, each / shared);
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+// 帧压缩基准：对聊天文本和随机字符两类内容、不同负载大小和压缩级别，统计压缩后的线路字节、
+// 压缩与解压（FrameDecoder 取帧时解压）的 CPU 开销，以及压缩仍然划算的链路带宽上限；
+// 最后对比广播帧按接收者逐个压缩与只压缩一次的 CPU 开销
+// 用法: compression_bench [每组处理的原始MB] [广播接收者数]
+#include "Compression.h"
+#include "Frame.h"
+#include "FrameDecoder.h"
+#include "Message.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMicros(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    // 由常用词随机拼成的句子，接近真实聊天内容的重复度
+    std::string chatText(size_t bytes, std::mt19937 &rng)
+    {
+        static const char *words[] = {"hello", "today", "meeting", "the", "server", "is", "running", "fine",
+                                      "please", "check", "room", "message", "we", "should", "deploy", "after",
+                                      "lunch", "ok", "thanks", "see", "you", "tomorrow", "build", "failed"};
+        std::uniform_int_distribution<size_t> pick(0, sizeof(words) / sizeof(words[0]) - 1);
+        std::string text;
+        while (text.size() < bytes)
+        {
+            text += words[pick(rng)];
+            text += ' ';
+        }
+        text.resize(bytes);
+        return text;
+    }
+
+    // 随机可打印字符，接近已压缩或加密过的内容，压缩收益很小
+    std::string randomText(size_t bytes, std::mt19937 &rng)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+        std::string text(bytes, ' ');
+        for (char &c : text)
+        {
+            c = alphabet[pick(rng)];
+        }
+        return text;
+    }
+
+    struct Result
+    {
+        size_t rawBytes;
+        size_t wireBytes;
+        double compressMicros;
+        double decompressMicros;
+    };
+
+    Result run(const FramePtr &frame, int level, size_t iterations)
+    {
+        std::string compressed;
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            compressed = Compression::deflate(frame->payload(), level);
+        }
+        double compressMicros = elapsedMicros(start) / double(iterations);
+
+        // 与接收端相同的路径：压缩帧放入解码器缓冲区，nextFrame 时解压
+        std::string wire(Frame::kHeaderSize, '\0');
+        uint32_t header = static_cast<uint32_t>(compressed.size()) | Frame::kCompressedFlag;
+        for (size_t i = 0; i < Frame::kHeaderSize; ++i)
+        {
+            wire[i] = static_cast<char>((header >> (8 * (Frame::kHeaderSize - 1 - i))) & 0xFF);
+        }
+        wire += compressed;
+
+        FrameDecoder decoder;
+        std::string_view payload;
+        start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            decoder.append(wire.data(), wire.size());
+            decoder.nextFrame(payload);
+        }
+        double decompressMicros = elapsedMicros(start) / double(iterations);
+        if (payload != frame->payload())
+        {
+            std::fprintf(stderr, "解压结果与原负载不一致\n");
+        }
+        return {frame->payload().size(), compressed.size(), compressMicros, decompressMicros};
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t megabytes = argc >= 2 ? std::stoul(argv[1]) : 64;
+    size_t recipients = argc >= 3 ? std::stoul(argv[2]) : 1000;
+
+    std::mt19937 rng(42);
+    const size_t sizes[] = {512, 4096, 65536};
+
+    // break_even: 链路带宽低于该值时，压缩省下的传输时间超过双方压缩和解压的 CPU 时间
+    std::printf("%-7s %7s %5s %8s %8s %7s %10s %10s %12s %12s %14s\n", "content", "payload", "level", "raw", "wire",
+                "ratio", "comp_us", "decomp_us", "comp_MB/s", "decomp_MB/s", "break_even_Mb");
+    for (bool text : {true, false})
+    {
+        for (size_t size : sizes)
+        {
+            std::string content = text ? chatText(size, rng) : randomText(size, rng);
+            FramePtr frame = Frame::create(ChatMessage("123456789", "alice", content), WireFormat::JSON);
+            size_t iterations = std::max<size_t>(megabytes * 1024 * 1024 / frame->payload().size(), 1);
+            for (int level : {1, 6})
+            {
+                Result r = run(frame, level, iterations);
+                double saved = double(r.rawBytes) - double(r.wireBytes);
+                double cpuMicros = r.compressMicros + r.decompressMicros;
+                double breakEven = saved > 0 ? saved * 8 / cpuMicros : 0.0; // 比特/微秒即 Mbit/s
+                std::printf("%-7s %7zu %5d %8zu %8zu %7.3f %10.2f %10.2f %12.1f %12.1f %14.1f\n", text ? "text" : "random",
+                            size, level, r.rawBytes, r.wireBytes, double(r.wireBytes) / double(r.rawBytes),
+                            r.compressMicros, r.decompressMicros, r.rawBytes / r.compressMicros,
+                            r.rawBytes / r.decompressMicros, breakEven);
+            }
+        }
+    }
+
+    // 广播：每个接收者的写者各自压缩，对比 Frame::compress 缓存在共享帧上只压缩一次
+    std::printf("\nbroadcast to %zu recipients\n", recipients);
+    std::printf("%7s %16s %16s\n", "payload", "per_recipient_us", "compress_once_us");
+    for (size_t size : sizes)
+    {
+        FramePtr frame = Frame::create(ChatMessage("123456789", "alice", chatText(size, rng)), WireFormat::JSON);
+
+        auto start = Clock::now();
+        for (size_t i = 0; i < recipients; ++i)
+        {
+            Compression::deflate(frame->payload());
+        }
+        double perRecipient = elapsedMicros(start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < recipients; ++i)
+        {
+            Frame::compress(frame);
+        }
+        double once = elapsedMicros(start);
+        std::printf("%7zu %16.0f %16.0f\n", size, perRecipient, once);
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// 帧解码基准：通过回环连接持续接收小消息，对比 逐帧两次 receiveBytes + 每帧分配缓冲区
+// 与 FrameDecoder 批量读取 + 视图解析 的每帧读调用次数和吞吐
+#include "Frame.h"
+#include "FrameDecoder.h"
+#include "Message.h"
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/StreamSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    size_t sink = 0;
+
+    struct Result
+    {
+        double readsPerFrame;
+        double framesPerSecond;
+    };
+
+    bool receiveExactly(Poco::Net::StreamSocket &socket, char *data, size_t length, uint64_t &reads)
+    {
+        size_t received = 0;
+        while (received < length)
+        {
+            int n = socket.receiveBytes(data + received, static_cast<int>(length - received));
+            ++reads;
+            if (n <= 0)
+            {
+                return false;
+            }
+            received += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // 原有实现：先读长度头，再为每帧分配缓冲区读取负载并复制为字符串
+    uint64_t receiveLegacy(Poco::Net::StreamSocket &socket, size_t frames, bool parse)
+    {
+        uint64_t reads = 0;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            unsigned char header[Frame::kHeaderSize];
+            if (!receiveExactly(socket, reinterpret_cast<char *>(header), sizeof(header), reads))
+            {
+                break;
+            }
+            uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+            std::vector<char> buffer(length + 1);
+            if (!receiveExactly(socket, buffer.data(), length, reads))
+            {
+                break;
+            }
+            std::string payload(buffer.data(), length);
+            sink += parse ? Message::parseMessage(payload) != nullptr : payload.size();
+        }
+        return reads;
+    }
+
+    uint64_t receiveDecoder(Poco::Net::StreamSocket &socket, size_t frames, bool parse)
+    {
+        FrameDecoder decoder;
+        uint64_t reads = 0;
+        std::string_view payload;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            while (!decoder.nextFrame(payload))
+            {
+                ++reads;
+                if (decoder.readFrom(socket) != FrameDecoder::ReadResult::DATA)
+                {
+                    return reads;
+                }
+            }
+            sink += parse ? Message::parseMessage(payload) != nullptr : payload.size();
+        }
+        return reads;
+    }
+
+    template <typename ReceiveFn>
+    Result run(Poco::Net::StreamSocket &sender, Poco::Net::StreamSocket &receiver, const std::string &stream, size_t frames, ReceiveFn receive)
+    {
+        std::thread writer([&]
+                           { sender.sendBytes(stream.data(), static_cast<int>(stream.size())); });
+        auto start = std::chrono::steady_clock::now();
+        uint64_t reads = receive(receiver, frames);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        writer.join();
+        return {static_cast<double>(reads) / frames, frames / seconds};
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t frames = argc >= 2 ? std::stoul(argv[1]) : 500000;
+
+    Poco::Net::ServerSocket listener(Poco::Net::SocketAddress("127.0.0.1", 0));
+    Poco::Net::StreamSocket sender(listener.address());
+    Poco::Net::StreamSocket receiver = listener.acceptConnection();
+
+    // 预先拼好全部帧，发送端一次写出，测量只反映接收端的开销
+    FramePtr frame = Frame::create(ChatMessage("123456789", "alice", "hello, everyone"), WireFormat::JSON);
+    std::string stream;
+    stream.reserve(frame->size() * frames);
+    for (size_t i = 0; i < frames; ++i)
+    {
+        stream.append(frame->data(), frame->size());
+    }
+
+    std::printf("frame size: %zu bytes\n", frame->size());
+    std::printf("%-28s %12s %14s\n", "mode", "reads/frame", "frames/sec");
+
+    for (bool parse : {false, true})
+    {
+        Result legacy = run(sender, receiver, stream, frames, [&](Poco::Net::StreamSocket &socket, size_t count)
+                            { return receiveLegacy(socket, count, parse); });
+        std::printf("%-28s %12.3f %14.0f\n", parse ? "per-frame alloc + parse" : "per-frame alloc", legacy.readsPerFrame, legacy.framesPerSecond);
+
+        Result decoder = run(sender, receiver, stream, frames, [&](Poco::Net::StreamSocket &socket, size_t count)
+                             { return receiveDecoder(socket, count, parse); });
+        std::printf("%-28s %12.3f %14.0f\n", parse ? "FrameDecoder + parse" : "FrameDecoder", decoder.readsPerFrame, decoder.framesPerSecond);
+    }
+
+    return sink == 0;
+}
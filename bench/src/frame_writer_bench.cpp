@@ -0,0 +1,108 @@
+// 帧写入基准：对比 长度头+消息体 两次 sendBytes、单帧 writev、多帧合并 writev 三种方式的
+// 每消息系统调用次数与吞吐
+#include "Frame.h"
+#include "FrameWriter.h"
+#include "Message.h"
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/StreamSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Result
+    {
+        double syscallsPerMessage;
+        double messagesPerSecond;
+    };
+
+    // 接收端只负责把数据读空，直到读满预期的字节数
+    std::thread startDrain(Poco::Net::StreamSocket socket, size_t expectedBytes)
+    {
+        return std::thread([socket, expectedBytes]() mutable
+                           {
+            std::vector<char> buffer(256 * 1024);
+            size_t total = 0;
+            while (total < expectedBytes)
+            {
+                int n = socket.receiveBytes(buffer.data(), static_cast<int>(buffer.size()));
+                if (n <= 0)
+                {
+                    break;
+                }
+                total += static_cast<size_t>(n);
+            } });
+    }
+
+    template <typename SendFn>
+    Result run(Poco::Net::StreamSocket &sender, Poco::Net::StreamSocket &receiver, const FramePtr &frame, size_t messages, SendFn send)
+    {
+        std::thread drain = startDrain(receiver, frame->size() * messages);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t syscalls = send(sender, messages);
+        drain.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return {static_cast<double>(syscalls) / messages, messages / seconds};
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc >= 2 ? std::stoul(argv[1]) : 200000;
+    size_t batchSize = argc >= 3 ? std::stoul(argv[2]) : 32;
+
+    Poco::Net::ServerSocket listener(Poco::Net::SocketAddress("127.0.0.1", 0));
+    Poco::Net::StreamSocket sender(listener.address());
+    Poco::Net::StreamSocket receiver = listener.acceptConnection();
+    FrameWriter::configureSocket(sender);
+
+    FramePtr frame = Frame::create(ChatMessage("123456789", "alice", "hello, everyone"), WireFormat::JSON);
+    std::string payload(frame->payload());
+
+    std::printf("%-24s %14s %14s\n", "mode", "syscalls/msg", "msgs/sec");
+
+    Result split = run(sender, receiver, frame, messages, [&](Poco::Net::StreamSocket &socket, size_t count)
+                       {
+        uint64_t syscalls = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            socket.sendBytes(frame->data(), static_cast<int>(Frame::kHeaderSize));
+            socket.sendBytes(payload.data(), static_cast<int>(payload.size()));
+            syscalls += 2;
+        }
+        return syscalls; });
+    std::printf("%-24s %14.3f %14.0f\n", "header+body sendBytes", split.syscallsPerMessage, split.messagesPerSecond);
+
+    Result single = run(sender, receiver, frame, messages, [&](Poco::Net::StreamSocket &socket, size_t count)
+                        {
+        FrameWriter writer(socket);
+        for (size_t i = 0; i < count; ++i)
+        {
+            writer.enqueue(frame);
+            writer.flush();
+        }
+        return writer.syscalls(); });
+    std::printf("%-24s %14.3f %14.0f\n", "writev per frame", single.syscallsPerMessage, single.messagesPerSecond);
+
+    Result coalesced = run(sender, receiver, frame, messages, [&](Poco::Net::StreamSocket &socket, size_t count)
+                           {
+        FrameWriter writer(socket);
+        for (size_t i = 0; i < count; i += batchSize)
+        {
+            for (size_t j = i; j < count && j < i + batchSize; ++j)
+            {
+                writer.enqueue(frame);
+            }
+            writer.flush();
+        }
+        return writer.syscalls(); });
+    std::printf("%-24s %14.3f %14.0f\n", ("writev batch of " + std::to_string(batchSize)).c_str(),
+                coalesced.syscallsPerMessage, coalesced.messagesPerSecond);
+
+    return 0;
+}
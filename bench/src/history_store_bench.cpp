@@ -0,0 +1,106 @@
+// 聊天历史基准：向 K 个会话追加 N 条消息（默认 100 个会话、20 万条），
+// 测量转发线程上的入队耗时、组提交落盘的总耗时、重启后扫描分段重建索引的耗时，
+// 以及取最近 50 条和按 ID 向前翻页的查询耗时
+#include "HistoryStore.h"
+#include "Message.h"
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::string conversationName(size_t index)
+    {
+        return "#room" + std::to_string(index);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t conversations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    size_t contentSize = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+    std::string directory = argc > 4 ? argv[4] : Poco::Path::temp() + "history_store_bench";
+    const size_t queries = 10000;
+    const size_t pageSize = 50;
+
+    Poco::File(directory).createDirectories();
+    {
+        auto store = HistoryStore::create();
+        store->setDirectory(directory);
+        store->setSegmentBytes(16 * 1024 * 1024);
+        if (!store->start())
+        {
+            std::fprintf(stderr, "failed to open %s\n", directory.c_str());
+            return 1;
+        }
+
+        ChatMessage message(MessageType::ROOM_MESSAGE, "100000001", "sender", "", std::string(contentSize, 'x'));
+        auto start = Clock::now();
+        for (size_t i = 0; i < messages; ++i)
+        {
+            message.stamp();
+            message.setSeq(i + 1);
+            store->append(conversationName(i % conversations), message);
+        }
+        double appendMs = elapsedMs(start);
+        store->flush();
+        double commitMs = elapsedMs(start);
+        std::printf("append: %zu messages, %.2f us/message on caller, all committed after %.2f ms (dropped=%llu)\n",
+                    messages, appendMs * 1000 / messages, commitMs, static_cast<unsigned long long>(store->getDroppedCount()));
+        store->stop();
+    }
+
+    // 模拟重启：新实例扫描映射的分段重建索引
+    auto store = HistoryStore::create();
+    store->setDirectory(directory);
+    store->setSegmentBytes(16 * 1024 * 1024);
+    auto start = Clock::now();
+    store->start();
+    std::printf("reload: %.2f ms, %zu conversations\n", elapsedMs(start), store->getConversationCount());
+
+    std::mt19937 random(42);
+    HistoryStore::View view;
+    size_t returned = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < queries; ++i)
+    {
+        returned += store->query(conversationName(random() % conversations), 0, pageSize, view);
+    }
+    double recentMs = elapsedMs(start);
+    std::printf("recent %zu: %.2f us/query (%zu messages returned)\n", pageSize, recentMs * 1000 / queries, returned);
+
+    // 翻页：先取最近一页，再以其中最早一条的 ID 向前取一页
+    returned = 0;
+    double pageMs = 0;
+    for (size_t i = 0; i < queries; ++i)
+    {
+        std::string conversation = conversationName(random() % conversations);
+        store->query(conversation, 0, pageSize, view);
+        auto first = view.messages.empty() ? nullptr : Message::parseMessage(view.messages.front());
+        if (!first)
+        {
+            continue;
+        }
+        auto pageStart = Clock::now();
+        returned += store->query(conversation, first->getId(), pageSize, view);
+        pageMs += elapsedMs(pageStart);
+    }
+    std::printf("before id, %zu: %.2f us/query (%zu messages returned)\n", pageSize, pageMs * 1000 / queries, returned);
+
+    store->stop();
+    Poco::File(directory).remove(true);
+    return 0;
+}
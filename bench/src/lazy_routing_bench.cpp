@@ -0,0 +1,88 @@
+// 路由解码基准：对 1KB 和 64KB 内容的聊天消息，比较服务器转发一条消息的 CPU 时间
+//   full：完整解析为 ChatMessage，改写发送者/ID/序号后重新编码转发帧，并为历史存储编码一次二进制
+//   lazy：ChatEnvelope 只解码路由字段，原始 content 与服务器字段拼接成转发帧，二进制帧同时用于历史存储
+// 接收方与发送方使用同一线路格式
+#include "ChatEnvelope.h"
+#include "Frame.h"
+#include "Message.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+namespace
+{
+    size_t sink = 0;
+
+    double cpuMicros(std::clock_t start)
+    {
+        return double(std::clock() - start) * 1e6 / CLOCKS_PER_SEC;
+    }
+
+    void routeFull(const std::string &payload, WireFormat format, uint64_t seq)
+    {
+        auto message = Message::parseMessage(payload);
+        auto &chat = static_cast<ChatMessage &>(*message);
+        chat.setSender("100000001");
+        chat.setSenderUsername("alice");
+        chat.stamp();
+        chat.setSeq(seq);
+        FramePtr frame = Frame::create(chat, format);
+        std::string history = chat.serializeBinary();
+        sink += frame->size() + history.size();
+    }
+
+    void routeLazy(const std::string &payload, WireFormat format, uint64_t seq)
+    {
+        ChatEnvelope envelope;
+        envelope.parse(payload);
+        envelope.setSender("100000001", "alice");
+        envelope.stamp();
+        envelope.setSeq(seq);
+        FramePtr frame = envelope.frame(format);
+        FramePtr history = envelope.frame(WireFormat::BINARY);
+        sink += frame->size() + history->size();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+
+    std::printf("%-8s %-7s %12s %12s %8s\n", "content", "format", "full us/msg", "lazy us/msg", "speedup");
+    for (size_t contentSize : {size_t(1024), size_t(64 * 1024)})
+    {
+        // 内容含少量需要转义的字符，JSON 路径上更接近真实文本
+        std::string content;
+        while (content.size() < contentSize)
+        {
+            content += "hello, \"world\"\n";
+        }
+        content.resize(contentSize);
+        ChatMessage message("100000001", "alice", "100000002", content);
+
+        for (WireFormat format : {WireFormat::BINARY, WireFormat::JSON})
+        {
+            std::string payload = message.encode(format);
+            size_t rounds = contentSize > 4096 ? messages / 10 : messages;
+
+            std::clock_t start = std::clock();
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                routeFull(payload, format, i + 1);
+            }
+            double full = cpuMicros(start) / rounds;
+
+            start = std::clock();
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                routeLazy(payload, format, i + 1);
+            }
+            double lazy = cpuMicros(start) / rounds;
+
+            std::printf("%-8s %-7s %12.2f %12.2f %7.1fx\n", contentSize > 4096 ? "64KB" : "1KB",
+                        format == WireFormat::BINARY ? "binary" : "json", full, lazy, lazy > 0 ? full / lazy : 0.0);
+        }
+    }
+    return sink == 0;
+}
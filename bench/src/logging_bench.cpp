@@ -0,0 +1,93 @@
+// 日志开销基准：多个线程并发转发私聊消息（按需解码、拼接转发帧），每条消息输出与服务器相同的两行 information 日志，
+// 日志写入文件。比较每秒转发的消息数：
+//   off：级别为 warning，日志宏不做格式化
+//   sync：级别为 information，在调用线程中直接交给 Poco::Logger 写文件（改造前的方式）
+//   async：级别为 information，记录放入环形缓冲区由后台线程写文件
+#include "AsyncLog.h"
+#include "ChatEnvelope.h"
+#include "Frame.h"
+#include "Message.h"
+#include <Poco/AutoPtr.h>
+#include <Poco/File.h>
+#include <Poco/FileChannel.h>
+#include <Poco/Logger.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::atomic<size_t> sink{0};
+
+    void route(const std::string &payload, uint64_t seq)
+    {
+        ChatEnvelope envelope;
+        envelope.parse(payload);
+        envelope.setSender("100000001", "alice");
+        envelope.stamp();
+        envelope.setSeq(seq);
+        FramePtr frame = envelope.frame(WireFormat::BINARY);
+        sink.fetch_add(frame->size(), std::memory_order_relaxed);
+
+        std::string size = " (" + std::to_string(envelope.getContentSize()) + " bytes)";
+        LOG_INFO("ChatConnection", "Private message from 100000001 to " + envelope.getReceiver() + size);
+        LOG_INFO("ConnectionManager", "Sending message to user: " + envelope.getReceiver());
+    }
+
+    double run(const std::string &payload, size_t threads, size_t perThread)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&payload, perThread]()
+                                 {
+                for (size_t i = 0; i < perThread; ++i)
+                {
+                    route(payload, i + 1);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return double(threads * perThread) / seconds;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    size_t perThread = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    std::string path = "logging_bench.log";
+
+    Poco::AutoPtr<Poco::FileChannel> channel = new Poco::FileChannel(path);
+    Poco::Logger::setChannel("", channel);
+
+    ChatMessage message("100000001", "alice", "100000002", std::string(200, 'x'));
+    std::string payload = message.encode(WireFormat::BINARY);
+    auto &log = AsyncLog::getInstance();
+
+    std::printf("%zu 个线程，每线程 %zu 条消息\n", threads, perThread);
+    std::printf("%-6s %14s %10s\n", "mode", "messages/sec", "dropped");
+
+    log.setLevel(Poco::Message::PRIO_WARNING);
+    std::printf("%-6s %14.0f %10s\n", "off", run(payload, threads, perThread), "-");
+
+    log.setLevel(Poco::Message::PRIO_INFORMATION);
+    std::printf("%-6s %14.0f %10s\n", "sync", run(payload, threads, perThread), "-");
+
+    log.start(65536);
+    double async = run(payload, threads, perThread);
+    log.stop();
+    std::printf("%-6s %14.0f %10llu\n", "async", async, static_cast<unsigned long long>(log.getDropped()));
+
+    channel->close();
+    Poco::File(path).remove();
+    return sink == 0;
+}
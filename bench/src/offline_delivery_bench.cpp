@@ -0,0 +1,100 @@
+// 离线消息基准：为一个账号积压 N 条私聊消息（默认 1 万条），
+// 测量逐条入箱的耗时、重启后重建索引的耗时，以及登录时顺序读出全部消息、编码成帧并删除收件箱的耗时
+// （二进制连接直接转发存储的字节，JSON 连接需要解析后重新编码）
+#include "OfflineStore.h"
+#include "Frame.h"
+#include "Message.h"
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void fill(OfflineStore &store, const std::string &account, size_t messages, size_t contentSize)
+    {
+        ChatMessage message("100000002", "sender", account, std::string(contentSize, 'x'));
+        for (size_t i = 0; i < messages; ++i)
+        {
+            message.stamp();
+            message.setSeq(i + 1);
+            store.enqueue(account, message);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t contentSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    std::string directory = argc > 3 ? argv[3] : Poco::Path::temp() + "offline_delivery_bench";
+    const std::string account = "100000001";
+
+    Poco::File(directory).createDirectories();
+    auto store = OfflineStore::create();
+    store->setDirectory(directory);
+    store->setMaxMessagesPerAccount(messages);
+    store->load();
+
+    auto start = Clock::now();
+    fill(*store, account, messages, contentSize);
+    double enqueueMs = elapsedMs(start);
+    std::printf("enqueue: %zu messages, %.2f us/message\n", messages, enqueueMs * 1000 / messages);
+
+    // 模拟重启：新实例扫描目录重建索引
+    auto reloaded = OfflineStore::create();
+    reloaded->setDirectory(directory);
+    reloaded->setMaxMessagesPerAccount(messages);
+    start = Clock::now();
+    reloaded->load();
+    std::printf("reload: %.2f ms, pending=%zu\n", elapsedMs(start), reloaded->getPendingCount(account));
+
+    for (WireFormat format : {WireFormat::BINARY, WireFormat::JSON})
+    {
+        if (reloaded->getPendingCount(account) == 0)
+        {
+            fill(*reloaded, account, messages, contentSize);
+        }
+
+        size_t frames = 0;
+        size_t bytes = 0;
+        start = Clock::now();
+        size_t delivered = reloaded->deliver(account, 256, [&](const std::vector<std::string_view> &batch)
+                                             {
+            for (std::string_view payload : batch)
+            {
+                FramePtr frame;
+                if (format == WireFormat::BINARY)
+                {
+                    frame = Frame::fromPayload(payload, MessageType::PRIVATE_MESSAGE);
+                }
+                else if (auto message = Message::parseMessage(payload))
+                {
+                    frame = Frame::create(*message, format);
+                }
+                if (frame)
+                {
+                    ++frames;
+                    bytes += frame->size();
+                }
+            }
+            return batch.size(); }).delivered;
+        double deliverMs = elapsedMs(start);
+        std::printf("deliver on login (%s): %zu messages in %.2f ms (%.2f us/message, %zu frames, %.1f KB)\n",
+                    format == WireFormat::BINARY ? "binary" : "json", delivered, deliverMs,
+                    delivered ? deliverMs * 1000 / delivered : 0.0, frames, bytes / 1024.0);
+    }
+
+    Poco::File(directory).remove(true);
+    return 0;
+}
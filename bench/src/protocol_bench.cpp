@@ -0,0 +1,70 @@
+// 协议编解码基准：对比 JSON（DOM/流式）与紧凑二进制格式的消息体积和编解码耗时
+#include "Message.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    size_t sink = 0;
+
+    double measureNs(int iterations, const std::function<void()> &fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+
+    void run(const char *name, const Message &message, int iterations)
+    {
+        std::string json = message.encode(WireFormat::JSON);
+        std::string binary = message.encode(WireFormat::BINARY);
+
+        double jsonEncode = measureNs(iterations, [&]
+                                      { sink += message.encode(WireFormat::JSON).size(); });
+        double binaryEncode = measureNs(iterations, [&]
+                                        { sink += message.encode(WireFormat::BINARY).size(); });
+        double domDecode = measureNs(iterations, [&]
+                                     {
+                                         auto parsed = Message::createMessage(message.getType());
+                                         sink += parsed->deserialize(json); });
+        double jsonDecode = measureNs(iterations, [&]
+                                      { sink += Message::parseMessage(json) != nullptr; });
+        double binaryDecode = measureNs(iterations, [&]
+                                        { sink += Message::parseMessage(binary) != nullptr; });
+
+        std::printf("%-22s %8zu %8zu %12.1f %12.1f %12.1f %12.1f %12.1f\n",
+                    name, json.size(), binary.size(), jsonEncode, binaryEncode, domDecode, jsonDecode, binaryDecode);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc >= 2 ? std::stoi(argv[1]) : 100000;
+
+    std::printf("%-22s %8s %8s %12s %12s %12s %12s %12s\n",
+                "message", "json B", "bin B", "json enc ns", "bin enc ns", "dom dec ns", "json dec ns", "bin dec ns");
+
+    run("LoginRequest", LoginRequest("123456789", "secret-password"), iterations);
+    run("LoginResponse", LoginResponse(MessageStatus::SUCCESS, "123456789", "alice", "ok"), iterations);
+    run("ChatMessage/broadcast", ChatMessage("123456789", "alice", "hello, everyone"), iterations);
+    run("ChatMessage/private", ChatMessage("123456789", "alice", "987654321", "see you at five"), iterations);
+    run("ChatMessage/1KB", ChatMessage("123456789", "alice", std::string(1024, 'x')), iterations / 10);
+
+    UserListResponse userList;
+    for (int i = 0; i < 100; ++i)
+    {
+        userList.addUser(std::to_string(100000000 + i));
+    }
+    run("UserListResponse/100", userList, iterations / 10);
+    run("ErrorMessage", ErrorMessage(-1, "unauthorized"), iterations);
+
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+// 事件驱动模式负载测试：建立大量空闲连接，同时让一部分活跃连接持续收发请求，
+// 验证单机能否承载 5 万空闲 + 5 千活跃连接。
+//
+// 用法: reactor_loadtest [hosts] [port] [idle] [active] [seconds] [threads]
+//   hosts 为逗号分隔的目标地址，例如 127.0.0.1,127.0.0.2,127.0.0.3。
+//   单个 (源地址, 目标地址:端口) 组合最多只有约 2.8 万个临时端口，
+//   连接数较多时需要服务器监听 0.0.0.0 并在此处给出多个回环地址。
+#include "Frame.h"
+#include "Message.h"
+#include <Poco/Net/StreamSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/NetException.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<std::string> splitHosts(const std::string &hosts)
+    {
+        std::vector<std::string> result;
+        std::stringstream ss(hosts);
+        std::string host;
+        while (std::getline(ss, host, ','))
+        {
+            if (!host.empty())
+            {
+                result.push_back(host);
+            }
+        }
+        return result;
+    }
+
+    void raiseFileDescriptorLimit()
+    {
+#ifndef _WIN32
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+            std::printf("fd limit: %llu\n", static_cast<unsigned long long>(limit.rlim_cur));
+        }
+#endif
+    }
+
+    bool receiveExactly(Poco::Net::StreamSocket &socket, char *data, size_t length)
+    {
+        size_t received = 0;
+        while (received < length)
+        {
+            int n = socket.receiveBytes(data + received, static_cast<int>(length - received));
+            if (n <= 0)
+            {
+                return false;
+            }
+            received += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool receiveFrame(Poco::Net::StreamSocket &socket, std::string &payload)
+    {
+        unsigned char header[Frame::kHeaderSize];
+        if (!receiveExactly(socket, reinterpret_cast<char *>(header), sizeof(header)))
+        {
+            return false;
+        }
+        uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+        payload.resize(length);
+        return receiveExactly(socket, &payload[0], length);
+    }
+
+    bool sendFrame(Poco::Net::StreamSocket &socket, const FramePtr &frame)
+    {
+        size_t sent = 0;
+        while (sent < frame->size())
+        {
+            int n = socket.sendBytes(frame->data() + sent, static_cast<int>(frame->size() - sent));
+            if (n <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    double percentile(std::vector<double> &samples, double p)
+    {
+        if (samples.empty())
+        {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(p * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> hosts = splitHosts(argc >= 2 ? argv[1] : "127.0.0.1,127.0.0.2,127.0.0.3");
+    int port = argc >= 3 ? std::stoi(argv[2]) : 9999;
+    size_t idleCount = argc >= 4 ? std::stoul(argv[3]) : 50000;
+    size_t activeCount = argc >= 5 ? std::stoul(argv[4]) : 5000;
+    int seconds = argc >= 6 ? std::stoi(argv[5]) : 30;
+    size_t threadCount = argc >= 7 ? std::stoul(argv[6]) : 8;
+
+    raiseFileDescriptorLimit();
+
+    auto connect = [&](size_t index)
+    {
+        Poco::Net::StreamSocket socket;
+        socket.connect(Poco::Net::SocketAddress(hosts[index % hosts.size()], port));
+        socket.setReceiveTimeout(Poco::Timespan(10, 0));
+        return socket;
+    };
+
+    std::vector<Poco::Net::StreamSocket> idle;
+    idle.reserve(idleCount);
+    auto connectStart = Clock::now();
+    try
+    {
+        for (size_t i = 0; i < idleCount; ++i)
+        {
+            idle.push_back(connect(i));
+            if ((i + 1) % 10000 == 0)
+            {
+                std::printf("idle connections: %zu\n", i + 1);
+            }
+        }
+    }
+    catch (const Poco::Exception &e)
+    {
+        std::fprintf(stderr, "connect failed after %zu idle connections: %s\n", idle.size(), e.displayText().c_str());
+        return 1;
+    }
+    double connectSeconds = std::chrono::duration<double>(Clock::now() - connectStart).count();
+
+    // 活跃连接重复发送一个必然失败的登录请求，覆盖完整的 分帧-解析-分发-响应 路径
+    FramePtr request = Frame::create(LoginRequest("000000000", "loadtest"), WireFormat::JSON);
+    std::atomic<size_t> failures{0};
+    std::vector<std::vector<double>> latencies(threadCount);
+    std::vector<std::thread> workers;
+    auto deadline = Clock::now() + std::chrono::seconds(seconds);
+
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&, t]
+                             {
+            std::vector<Poco::Net::StreamSocket> sockets;
+            try
+            {
+                for (size_t i = t; i < activeCount; i += threadCount)
+                {
+                    sockets.push_back(connect(idleCount + i));
+                }
+            }
+            catch (const Poco::Exception &e)
+            {
+                std::fprintf(stderr, "active connect failed: %s\n", e.displayText().c_str());
+                ++failures;
+            }
+
+            std::vector<Clock::time_point> sentAt(sockets.size());
+            std::string payload;
+            while (Clock::now() < deadline && !sockets.empty())
+            {
+                // 先向本线程的所有连接发出请求，再依次收取响应
+                for (size_t i = 0; i < sockets.size(); ++i)
+                {
+                    sentAt[i] = Clock::now();
+                    if (!sendFrame(sockets[i], request))
+                    {
+                        ++failures;
+                    }
+                }
+                for (size_t i = 0; i < sockets.size(); ++i)
+                {
+                    try
+                    {
+                        if (receiveFrame(sockets[i], payload))
+                        {
+                            latencies[t].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt[i]).count());
+                            continue;
+                        }
+                    }
+                    catch (const Poco::Exception &)
+                    {
+                    }
+                    ++failures;
+                }
+            } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    // 空闲连接在测试期间应全部保持打开：可读且读到 0 字节意味着被服务器关闭
+    size_t idleAlive = 0;
+    for (auto &socket : idle)
+    {
+        char byte;
+        if (!socket.poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_READ) || socket.receiveBytes(&byte, 1) > 0)
+        {
+            ++idleAlive;
+        }
+    }
+
+    std::vector<double> all;
+    for (auto &samples : latencies)
+    {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::printf("{\"idle\": %zu, \"idle_alive\": %zu, \"connect_seconds\": %.2f, \"active\": %zu, "
+                "\"round_trips\": %zu, \"failures\": %zu, \"rps\": %.0f, \"p50_us\": %.0f, \"p99_us\": %.0f}\n",
+                idleCount, idleAlive, connectSeconds, activeCount, all.size(), failures.load(),
+                all.size() / static_cast<double>(seconds), percentile(all, 0.50), percentile(all, 0.99));
+    return 0;
+}
@@ -0,0 +1,98 @@
+// 连接表争用基准：32 个线程混合执行登录（插入/替换）、登出（删除）和私聊（按账号查找），
+// 对比单把全局读写锁（1 个分片，即原先的 ConnectionManager）与按账号哈希分片的吞吐
+#include "ShardedRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct FakeConnection
+    {
+        std::atomic<uint64_t> sent{0};
+    };
+
+    double run(size_t shards, size_t threads, size_t accounts, int loginPercent, std::chrono::milliseconds duration)
+    {
+        ShardedRegistry<std::string, FakeConnection *> registry(shards);
+        std::vector<FakeConnection> connections(accounts);
+        std::vector<std::string> names;
+        names.reserve(accounts);
+        for (size_t i = 0; i < accounts; ++i)
+        {
+            names.push_back(std::to_string(100000000 + i));
+            registry.write(names[i], [&](auto &map)
+                           { map[names[i]] = &connections[i]; });
+        }
+
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> operations{0};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]
+                                 {
+                std::mt19937_64 random(t + 1);
+                uint64_t done = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    size_t index = random() % accounts;
+                    const std::string &account = names[index];
+                    int op = static_cast<int>(random() % 100);
+                    if (op < loginPercent / 2)
+                    {
+                        // 登录：插入或替换同账号的旧连接
+                        registry.write(account, [&](auto &map)
+                                       { map[account] = &connections[index]; });
+                    }
+                    else if (op < loginPercent)
+                    {
+                        // 登出/断开
+                        registry.write(account, [&](auto &map)
+                                       { map.erase(account); });
+                    }
+                    else
+                    {
+                        // 私聊：在共享锁内找到接收方并“入队”
+                        registry.read(account, [&](const auto &map)
+                                      {
+                            auto it = map.find(account);
+                            if (it != map.end())
+                            {
+                                it->second->sent.fetch_add(1, std::memory_order_relaxed);
+                            } });
+                    }
+                    ++done;
+                }
+                operations += done; });
+        }
+
+        std::this_thread::sleep_for(duration);
+        stop = true;
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        return operations.load() / std::chrono::duration<double>(duration).count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t threads = argc >= 2 ? std::stoul(argv[1]) : 32;
+    size_t accounts = argc >= 3 ? std::stoul(argv[2]) : 100000;
+    int loginPercent = argc >= 4 ? std::stoi(argv[3]) : 20;
+    std::chrono::milliseconds duration(argc >= 5 ? std::stoi(argv[4]) : 2000);
+
+    std::printf("threads=%zu accounts=%zu login/logout=%d%%\n", threads, accounts, loginPercent);
+    std::printf("%8s %16s\n", "shards", "ops/sec");
+    for (size_t shards : {1, 16, 64, 256})
+    {
+        std::printf("%8zu %16.0f\n", shards, run(shards, threads, accounts, loginPercent, duration));
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+// 房间扇出基准：10 万在线用户各加入 10 个房间，共 1 万个房间、100 万条成员关系，
+// 房间大小呈长尾分布。对比按房间成员索引投递（RoomRegistry）与
+// “遍历全部在线用户再过滤成员”两种方式发送一条房间消息的开销
+#include "RoomRegistry.h"
+#include "SlotMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct FakeConnection
+    {
+        uint64_t received = 0;
+        std::unordered_set<uint32_t> rooms; // 仅供过滤方式使用
+    };
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t users = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t roomCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+    size_t roomsPerUser = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10;
+    size_t messages = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 20000;
+
+    std::vector<FakeConnection> connections(users);
+    ShardedSlotMap<FakeConnection *> slots(64);
+    std::vector<SlotHandle> handles;
+    handles.reserve(users);
+    for (auto &connection : connections)
+    {
+        handles.push_back(slots.insert(&connection));
+    }
+
+    std::vector<std::string> roomNames;
+    roomNames.reserve(roomCount);
+    for (size_t i = 0; i < roomCount; ++i)
+    {
+        roomNames.push_back("room-" + std::to_string(i));
+    }
+
+    // 房间号取 u^2 分布：少数房间很大，多数房间很小
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    auto pickRoom = [&]
+    { return std::min(roomCount - 1, static_cast<size_t>(roomCount * std::pow(uniform(random), 2.0))); };
+
+    auto registry = RoomRegistry::create();
+    auto start = Clock::now();
+    size_t memberships = 0;
+    for (size_t user = 0; user < users; ++user)
+    {
+        auto &joined = connections[user].rooms;
+        while (joined.size() < roomsPerUser && joined.size() < roomCount)
+        {
+            uint32_t room = static_cast<uint32_t>(pickRoom());
+            if (joined.insert(room).second)
+            {
+                registry->join(roomNames[room], handles[user]);
+                ++memberships;
+            }
+        }
+    }
+    double joinMs = elapsedMs(start);
+
+    size_t largestRoom = 0;
+    size_t largestSize = 0;
+    for (size_t i = 0; i < roomCount; ++i)
+    {
+        size_t size = registry->getMemberCount(roomNames[i]);
+        if (size > largestSize)
+        {
+            largestSize = size;
+            largestRoom = i;
+        }
+    }
+
+    std::printf("users=%zu rooms=%zu (non-empty %zu) memberships=%zu largest=%zu\n",
+                users, roomCount, registry->getRoomCount(), memberships, largestSize);
+    std::printf("join: %.1f ms total, %.0f ns/membership\n", joinMs, joinMs * 1e6 / memberships);
+
+    // 成员索引：复制成员句柄，逐个按句柄校验后投递
+    std::vector<size_t> targets(messages);
+    for (auto &target : targets)
+    {
+        target = random() % roomCount;
+    }
+    std::vector<SlotHandle> members;
+    uint64_t delivered = 0;
+    start = Clock::now();
+    for (size_t room : targets)
+    {
+        registry->getMembers(roomNames[room], members);
+        for (SlotHandle member : members)
+        {
+            slots.read(member, [&](FakeConnection *connection)
+                       { ++connection->received; });
+        }
+        delivered += members.size();
+    }
+    double indexedMs = elapsedMs(start);
+    std::printf("indexed fan-out: %zu messages, %.2f us/message, %.1f recipients/message, %.1f ns/recipient\n",
+                messages, indexedMs * 1000 / messages, static_cast<double>(delivered) / messages,
+                delivered ? indexedMs * 1e6 / delivered : 0.0);
+
+    start = Clock::now();
+    const size_t largestRounds = 100;
+    for (size_t i = 0; i < largestRounds; ++i)
+    {
+        registry->getMembers(roomNames[largestRoom], members);
+        for (SlotHandle member : members)
+        {
+            slots.read(member, [&](FakeConnection *connection)
+                       { ++connection->received; });
+        }
+    }
+    std::printf("indexed fan-out, largest room: %.2f us/message\n", elapsedMs(start) * 1000 / largestRounds);
+
+    // 对照：每条消息遍历全部在线用户，检查其是否在房间中
+    size_t scanMessages = std::max<size_t>(1, messages / 100);
+    uint64_t scanned = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < scanMessages; ++i)
+    {
+        uint32_t room = static_cast<uint32_t>(targets[i]);
+        for (auto &connection : connections)
+        {
+            if (connection.rooms.count(room) != 0)
+            {
+                ++connection.received;
+                ++scanned;
+            }
+        }
+    }
+    double scanMs = elapsedMs(start);
+    std::printf("scan-all filter: %zu messages, %.2f us/message\n", scanMessages, scanMs * 1000 / scanMessages);
+
+    return 0;
+}
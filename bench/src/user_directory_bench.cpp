@@ -0,0 +1,144 @@
+// 用户目录基准：分别在 1万 / 10万 / 100万 注册用户下测量登录延迟，
+// 对比原先每次登录重新解析 users.json 的做法与启动时一次性载入的哈希索引目录；
+// 同时测量从 users.json 迁移、重放快照+日志的耗时和注册（追加一条日志记录）的延迟
+#include "UserManager.h"
+#include <Poco/File.h>
+#include <Poco/JSON/Parser.h>
+#include <Poco/Dynamic/Var.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string accountOf(size_t index)
+    {
+        return std::to_string(100000000 + index);
+    }
+
+    void writeUsersFile(const std::string &path, size_t count, const std::string &passwordHash)
+    {
+        std::ofstream out(path);
+        out << "{\"users\":[";
+        for (size_t i = 0; i < count; ++i)
+        {
+            out << (i == 0 ? "" : ",") << "{\"account\":\"" << accountOf(i) << "\",\"password_hash\":\"" << passwordHash
+                << "\",\"username\":\"user" << i << "\"}";
+        }
+        out << "]}";
+    }
+
+    // 原有实现：每次登录都打开文件并解析整个 JSON 文档
+    bool legacyAuthenticate(const std::string &path, const std::string &account, const std::string &passwordHash)
+    {
+        std::ifstream file(path);
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(file);
+        Poco::JSON::Array::Ptr users = result.extract<Poco::JSON::Object::Ptr>()->getArray("users");
+        for (const auto &userVar : *users)
+        {
+            User user = User::fromJson(userVar.extract<Poco::JSON::Object::Ptr>());
+            if (user.account == account)
+            {
+                return user.passwordHash == passwordHash;
+            }
+        }
+        return false;
+    }
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double percentile(std::vector<double> &samples, double p)
+    {
+        size_t index = static_cast<size_t>(p * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t logins = argc >= 2 ? std::stoul(argv[1]) : 10000;
+    size_t registrations = argc >= 3 ? std::stoul(argv[2]) : 1000;
+    std::string path = argc >= 4 ? argv[3] : "user_directory_bench.json";
+    std::string storeDirectory = path + ".store";
+
+    auto &userManager = UserManager::getInstance();
+    const std::string password = "bench-password";
+    const std::string passwordHash = userManager.hashPassword(password);
+    std::mt19937_64 random(42);
+
+    std::printf("%10s %11s %10s %13s %13s %16s %15s %15s\n", "users", "migrate ms", "replay ms", "login p50 us",
+                "login p99 us", "legacy login ms", "register p50 us", "register p99 us");
+
+    for (size_t count : {10000, 100000, 1000000})
+    {
+        writeUsersFile(path, count, passwordHash);
+        if (Poco::File(storeDirectory).exists())
+        {
+            Poco::File(storeDirectory).remove(true);
+        }
+        userManager.setUsersFilePath(path);
+        userManager.setStoreDirectory(storeDirectory);
+
+        // 第一次载入从 users.json 迁移并写出快照，第二次只重放快照
+        auto migrateStart = Clock::now();
+        userManager.load();
+        double migrateMs = elapsedMs(migrateStart);
+
+        auto replayStart = Clock::now();
+        userManager.load();
+        double replayMs = elapsedMs(replayStart);
+
+        std::vector<double> samples;
+        samples.reserve(logins);
+        for (size_t i = 0; i < logins; ++i)
+        {
+            std::string account = accountOf(random() % count);
+            auto start = Clock::now();
+            bool ok = userManager.authenticateUser(account, password);
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            if (!ok)
+            {
+                std::fprintf(stderr, "login failed for %s\n", account.c_str());
+                return 1;
+            }
+        }
+
+        // 旧实现每次登录耗时与用户数成正比，少量采样即可
+        double legacyMs = 0;
+        const int legacySamples = 3;
+        for (int i = 0; i < legacySamples; ++i)
+        {
+            auto start = Clock::now();
+            legacyAuthenticate(path, accountOf(random() % count), passwordHash);
+            legacyMs += elapsedMs(start);
+        }
+
+        std::vector<double> registerSamples;
+        registerSamples.reserve(registrations);
+        for (size_t i = 0; i < registrations; ++i)
+        {
+            auto start = Clock::now();
+            userManager.registerUser("newuser" + std::to_string(i), password);
+            registerSamples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+
+        std::printf("%10zu %11.1f %10.1f %13.2f %13.2f %16.1f %15.1f %15.1f\n", count, migrateMs, replayMs,
+                    percentile(samples, 0.50), percentile(samples, 0.99), legacyMs / legacySamples,
+                    percentile(registerSamples, 0.50), percentile(registerSamples, 0.99));
+    }
+
+    std::remove(path.c_str());
+    Poco::File(storeDirectory).remove(true);
+    return 0;
+}
@@ -5,8 +5,11 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <sstream>
+#include <cstdlib>
 
-ClientApp::ClientApp() : connected_(false), authenticated_(false)
+ClientApp::ClientApp()
+    : ackWindow_(kAckWindowSize), port_(0), heartbeatRunning_(false), heartbeatInterval_(30), connected_(false), authenticated_(false), wireFormat_(WireFormat::JSON)
 {
 }
 
@@ -17,14 +20,74 @@ ClientApp::~ClientApp()
 
 void ClientApp::connectToServer(const std::string &host, int port)
 {
-    socket_ = std::make_shared<Poco::Net::StreamSocket>();
+    auto socket = std::make_shared<Poco::Net::StreamSocket>();
 
     Poco::Net::SocketAddress address(host, port);
-    socket_->connect(address);
+    socket->connect(address);
 
-    socket_->setReceiveTimeout(Poco::Timespan(1, 0));
+    socket->setReceiveTimeout(Poco::Timespan(1, 0));
+    FrameWriter::configureSocket(*socket);
+    {
+        // 心跳线程可能正在写旧连接
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        socket_ = socket;
+        writer_ = std::make_unique<FrameWriter>(*socket_);
+        capabilities_ = 0;
+    }
+    host_ = host;
+    port_ = port;
     connected_ = true;
     std::cout << "连接成功！" << std::endl;
+    // 旧服务器收到不认识的消息类型会断开连接，CAPABILITIES 和 HEARTBEAT 都要等登录响应声明支持后才发送
+}
+
+void ClientApp::reconnect()
+{
+    if (host_.empty())
+    {
+        std::cerr << "尚未连接过服务器" << std::endl;
+        return;
+    }
+
+    // 先停止接收线程再替换套接字，未确认的消息留在发送窗口中
+    MessageHandler::getInstance().stop();
+    if (receiverThread_ && receiverThread_->isRunning())
+    {
+        receiverThread_->join();
+    }
+    if (socket_)
+    {
+        try
+        {
+            socket_->close();
+        }
+        catch (const Poco::Net::NetException &)
+        {
+        }
+    }
+    connected_ = false;
+    authenticated_ = false;
+
+    try
+    {
+        connectToServer(host_, port_);
+    }
+    catch (const Poco::Exception &e)
+    {
+        std::cerr << "重连失败: " << e.displayText() << std::endl;
+        return;
+    }
+    MessageHandler::getInstance().setSocket(socket_);
+    startMessageReceiver();
+
+    if (!account_.empty() && !password_.empty())
+    {
+        login(account_, password_);
+    }
+    else if (ackWindow_.size() > 0)
+    {
+        std::cout << "有 " << ackWindow_.size() << " 条消息未被确认，登录后将重新发送" << std::endl;
+    }
 }
 
 void ClientApp::startMessageReceiver()
@@ -36,6 +99,50 @@ void ClientApp::startMessageReceiver()
     }
     receiverThread_ = std::make_unique<Poco::Thread>();
     receiverThread_->start(MessageHandler::getInstance());
+
+    if (heartbeatInterval_.count() > 0 && !heartbeatThread_.joinable())
+    {
+        heartbeatRunning_ = true;
+        heartbeatThread_ = std::thread(&ClientApp::heartbeatLoop, this);
+    }
+}
+
+// 定期发送心跳，服务器在 server.timeout 内收不到任何数据时会断开连接
+void ClientApp::heartbeatLoop()
+{
+    std::unique_lock<std::mutex> lock(heartbeatMutex_);
+    while (!heartbeatStopped_.wait_for(lock, heartbeatInterval_, [this]
+                                       { return !heartbeatRunning_; }))
+    {
+        std::lock_guard<std::mutex> writerLock(writerMutex_);
+        // 登录前以及未声明 kCapabilityHeartbeat 的服务器上不发送，旧服务器不认识 HEARTBEAT
+        if (!writer_ || !(capabilities_ & kCapabilityHeartbeat))
+        {
+            continue;
+        }
+        try
+        {
+            writer_->enqueue(Frame::create(HeartbeatMessage(), wireFormat_));
+            writer_->flush();
+        }
+        catch (const std::exception &)
+        {
+            // 连接已断开，由接收线程报告
+        }
+    }
+}
+
+void ClientApp::stopHeartbeat()
+{
+    {
+        std::lock_guard<std::mutex> lock(heartbeatMutex_);
+        heartbeatRunning_ = false;
+    }
+    heartbeatStopped_.notify_all();
+    if (heartbeatThread_.joinable())
+    {
+        heartbeatThread_.join();
+    }
 }
 
 void ClientApp::handleUserInput()
@@ -82,6 +189,10 @@ void ClientApp::handleUserInput()
             }
             registerUser(username, password);
         }
+        else if (input == "reconnect")
+        {
+            reconnect();
+        }
         else if (input.substr(0, 6) == "logout")
         {
             logout();
@@ -96,6 +207,26 @@ void ClientApp::handleUserInput()
             sendPrivateMessage(input);
             continue;
         }
+        else if (input.substr(0, 2) == "\\j")
+        {
+            sendRoomRequest(MessageType::ROOM_JOIN, input);
+            continue;
+        }
+        else if (input.substr(0, 2) == "\\l")
+        {
+            sendRoomRequest(MessageType::ROOM_LEAVE, input);
+            continue;
+        }
+        else if (input.substr(0, 2) == "\\r")
+        {
+            sendRoomMessage(input);
+            continue;
+        }
+        else if (input.substr(0, 2) == "\\h")
+        {
+            sendHistoryRequest(input);
+            continue;
+        }
         else if (input.empty())
         {
             continue;
@@ -127,7 +258,7 @@ void ClientApp::sendBroadcastMessage(const std::string &input)
         std::cerr << "消息不能为空" << std::endl;
         return;
     }
-    sendMessage(ChatMessage(this->account_, this->username_, content));
+    sendChatMessage(ChatMessage(this->account_, this->username_, content));
 }
 
 void ClientApp::sendPrivateMessage(const std::string &input)
@@ -154,7 +285,7 @@ void ClientApp::sendPrivateMessage(const std::string &input)
             if (messageStart != std::string::npos)
             {
                 std::string messageContent = command.substr(messageStart);
-                sendMessage(ChatMessage(this->account_, this->username_, receiver, messageContent));
+                sendChatMessage(ChatMessage(this->account_, this->username_, receiver, messageContent));
             }
             else
             {
@@ -172,16 +303,85 @@ void ClientApp::sendPrivateMessage(const std::string &input)
     }
 }
 
+void ClientApp::sendRoomRequest(MessageType type, const std::string &input)
+{
+    if (!authenticated_)
+    {
+        std::cerr << "请先登录或注册账号" << std::endl;
+        return;
+    }
+    std::string room = input.substr(2);
+    size_t first = room.find_first_not_of(" \t");
+    if (first == std::string::npos)
+    {
+        std::cerr << "房间名不能为空" << std::endl;
+        return;
+    }
+    room = room.substr(first, room.find_last_not_of(" \t") - first + 1);
+    sendMessage(RoomRequest(type, room));
+}
+
+void ClientApp::sendRoomMessage(const std::string &input)
+{
+    if (!authenticated_)
+    {
+        std::cerr << "请先登录或注册账号" << std::endl;
+        return;
+    }
+    // 房间消息：\r <房间> <消息>
+    std::string command = input.substr(2);
+    size_t roomStart = command.find_first_not_of(" \t");
+    size_t spacePos = roomStart == std::string::npos ? std::string::npos : command.find(' ', roomStart);
+    size_t messageStart = spacePos == std::string::npos ? std::string::npos : command.find_first_not_of(" \t", spacePos + 1);
+    if (messageStart == std::string::npos)
+    {
+        std::cerr << "房间消息格式错误，请使用 \\r <房间> <消息>" << std::endl;
+        return;
+    }
+    std::string room = command.substr(roomStart, spacePos - roomStart);
+    sendChatMessage(ChatMessage(MessageType::ROOM_MESSAGE, this->account_, this->username_, room, command.substr(messageStart)));
+}
+
+void ClientApp::sendHistoryRequest(const std::string &input)
+{
+    if (!authenticated_)
+    {
+        std::cerr << "请先登录或注册账号" << std::endl;
+        return;
+    }
+    // 历史消息：\h [目标] [条数] [消息ID]，目标省略或为 * 表示广播，#房间 表示房间，否则为私聊对方账号；
+    // 给出消息ID时查看该消息之前的历史
+    std::istringstream command(input.substr(2));
+    std::string target;
+    std::string count;
+    std::string before;
+    command >> target >> count >> before;
+    if (target == "*")
+    {
+        target.clear();
+    }
+    uint32_t limit = 20;
+    if (!count.empty())
+    {
+        limit = static_cast<uint32_t>(std::strtoul(count.c_str(), nullptr, 10));
+        if (limit == 0)
+        {
+            std::cerr << "历史消息格式错误，请使用 \\h [目标] [条数] [消息ID]" << std::endl;
+            return;
+        }
+    }
+    uint64_t beforeId = before.empty() ? 0 : std::strtoull(before.c_str(), nullptr, 10);
+    sendMessage(HistoryRequest(target, limit, beforeId));
+}
+
 void ClientApp::disconnect()
 {
+    stopHeartbeat();
     if (socket_ && socket_->impl()->initialized())
     {
         try
         {
-            std::string jsonData = UserStatusUpdate("leave").serialize();
-            uint32_t messageLength = htonl(static_cast<uint32_t>(jsonData.length()));
-            socket_->sendBytes(&messageLength, sizeof(messageLength));
-            socket_->sendBytes(jsonData.c_str(), jsonData.length());
+            writeFrame(Frame::create(UserStatusUpdate("leave"), wireFormat_));
         }
         catch (const std::exception &e)
         {
@@ -218,29 +418,112 @@ void ClientApp::sendMessage(const Message &message)
 
     try
     {
-        std::string jsonData = message.serialize();
-        uint32_t messageLength = htonl(static_cast<uint32_t>(jsonData.length()));
+        writeFrame(Frame::create(message, wireFormat_));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+}
 
-        int sent = socket_->sendBytes(&messageLength, sizeof(messageLength));
-        if (sent != sizeof(messageLength))
-        {
-            throw std::runtime_error("发送消息长度失败");
-        }
+void ClientApp::sendChatMessage(const ChatMessage &message)
+{
+    if (!connected_ || !socket_)
+    {
+        std::cerr << "未连接到服务器，无法发送消息" << std::endl;
+        return;
+    }
+    if (!ackWindow_.waitForSpace(std::chrono::seconds(5)))
+    {
+        std::cerr << "已有 " << ackWindow_.size() << " 条消息等待服务器确认，请稍后再发" << std::endl;
+        return;
+    }
+
+    // 帧只编码一次，重发时原样写出，消息 ID 保持不变；另备一份带重发标记的编码，
+    // 重连后的服务器支持时用它重发，服务器据此识别已经转发过的消息
+    FramePtr frame = Frame::create(message, wireFormat_);
+    ChatMessage marked = message;
+    marked.setRetransmit(true);
+    ackWindow_.push(message.getId(), frame, Frame::create(marked, wireFormat_));
+    try
+    {
+        writeFrame(frame);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "（消息将在重连后重新发送）" << std::endl;
+    }
+}
 
-        sent = socket_->sendBytes(jsonData.c_str(), jsonData.length());
-        if (sent != jsonData.length())
+void ClientApp::handleAck(uint64_t ackId)
+{
+    ackWindow_.acknowledge(ackId);
+}
+
+void ClientApp::retransmitPending()
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    // 不支持重发标记的服务器也不去重，原样重发，至少一次投递
+    std::vector<FramePtr> frames = ackWindow_.pending((capabilities_ & kCapabilityRetransmit) != 0);
+    if (frames.empty() || !writer_)
+    {
+        return;
+    }
+    // 未协商 BATCH 的服务器不认识批量帧，逐帧写出
+    if (capabilities_ & kCapabilityBatch)
+    {
+        writer_->enqueueBatched(frames);
+    }
+    else
+    {
+        for (const auto &frame : frames)
         {
-            throw std::runtime_error("发送消息内容不完整");
+            writer_->enqueue(frame);
         }
     }
-    catch (const std::exception &e)
+    writer_->flush();
+    std::cout << "已重新发送 " << frames.size() << " 条未确认的消息" << std::endl;
+}
+
+void ClientApp::applyCapabilities(uint32_t capabilities)
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    if (!writer_)
     {
-        std::cerr << e.what() << std::endl;
+        return;
+    }
+    capabilities_ = capabilities;
+    writer_->setCompressionThreshold((capabilities & kCapabilityCompression) ? kCompressionThreshold : 0);
+}
+
+void ClientApp::applyServerCapabilities(uint32_t advertised)
+{
+    // 旧服务器不声明任何能力，也不认识 CAPABILITIES
+    uint32_t capabilities = advertised & kClientCapabilities;
+    applyCapabilities(capabilities);
+    if (capabilities != 0)
+    {
+        // 服务器回复双方都支持的部分后才对本连接启用压缩和批量帧
+        writeFrame(Frame::create(CapabilitiesMessage(kClientCapabilities), wireFormat_));
+    }
+}
+
+// 长度头与消息体通过一次系统调用写出
+void ClientApp::writeFrame(const FramePtr &frame)
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    if (!writer_)
+    {
+        return;
     }
+    writer_->enqueue(frame);
+    writer_->flush();
 }
 
 void ClientApp::login(const std::string &account, const std::string &password)
 {
+    account_ = account;
+    password_ = password;
     LoginRequest loginRequest(account, password);
     sendMessage(loginRequest);
 }
@@ -263,6 +546,12 @@ void ClientApp::logout()
 
     authenticated_ = false;
     account_.clear();
+    password_.clear();
+    size_t discarded = ackWindow_.clear();
+    if (discarded > 0)
+    {
+        std::cout << "放弃 " << discarded << " 条未确认的消息" << std::endl;
+    }
     std::cout << "已登出" << std::endl;
 }
 
@@ -272,8 +561,13 @@ void ClientApp::showHelp()
     std::cout << "  login     - 登录系统\n";
     std::cout << "  register  - 注册新账号\n";
     std::cout << "  logout    - 登出系统\n";
+    std::cout << "  reconnect - 重新连接并自动登录，重发未确认的消息\n";
     std::cout << "  \\b <message>        - 发送广播消息\n";
     std::cout << "  \\p <account> <message> - 发送私聊消息\n";
+    std::cout << "  \\j <room>           - 加入房间\n";
+    std::cout << "  \\l <room>           - 离开房间\n";
+    std::cout << "  \\r <room> <message> - 发送房间消息\n";
+    std::cout << "  \\h [target] [count] [id] - 查看历史消息（target: * 广播、#房间 或账号；id: 查看该消息之前的历史）\n";
     std::cout << "  help      - 显示帮助信息\n";
     std::cout << "  quit - 退出程序\n";
 }
\ No newline at end of file
@@ -1,10 +1,17 @@
 #pragma once
 
+#include "AckWindow.h"
 #include "Message.h"
+#include "FrameWriter.h"
 #include <Poco/Net/StreamSocket.h>
 #include <Poco/Thread.h>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 class MessageHandler;
 
@@ -23,30 +30,70 @@ public:
     void setAuthenticated(bool authenticated) { authenticated_ = authenticated; }
     void setConnected(bool connected) { connected_ = connected; }
     void setUsername(const std::string &username) { username_ = username; }
+    void setWireFormat(WireFormat format) { wireFormat_ = format; }
+    // 心跳间隔须小于服务器的 server.timeout，0 表示不发送心跳
+    void setHeartbeatInterval(std::chrono::seconds interval) { heartbeatInterval_ = interval; }
 
     const std::string &getAccount() const { return account_; }
     const std::string &getUsername() const { return username_; }
 
     void connectToServer(const std::string &host, int port);
+    // 重新连接同一服务器，之前登录过时用同一账号自动登录
+    void reconnect();
     std::shared_ptr<Poco::Net::StreamSocket> getSocket() const { return socket_; }
     void startMessageReceiver();
     void handleUserInput();
     void disconnect();
 
+    // 接收线程调用：累计确认发送窗口中的聊天消息
+    void handleAck(uint64_t ackId);
+    // 接收线程在登录成功、允许继续发送之前调用，按原顺序重发上一个连接未确认的消息
+    void retransmitPending();
+    // 接收线程调用：按服务器回复的能力位启用压缩等可选特性
+    void applyCapabilities(uint32_t capabilities);
+    // 接收线程在登录成功、重发之前调用：按登录响应中服务器声明的能力启用可选特性，并向其声明客户端的能力
+    void applyServerCapabilities(uint32_t advertised);
+
 private:
     void login(const std::string &account, const std::string &password);
     void logout();
     void registerUser(const std::string &username, const std::string &password);
     void sendBroadcastMessage(const std::string &input);
     void sendPrivateMessage(const std::string &input);
+    void sendRoomRequest(MessageType type, const std::string &input);
+    void sendRoomMessage(const std::string &input);
+    void sendHistoryRequest(const std::string &input);
     void showHelp();
     void sendMessage(const Message &message);
+    // 聊天消息先登记到发送窗口再发出，窗口满时等待服务器确认
+    void sendChatMessage(const ChatMessage &message);
+    void writeFrame(const FramePtr &frame);
+    void heartbeatLoop();
+    void stopHeartbeat();
+
+    static constexpr size_t kAckWindowSize = 256;
+    // 与服务器默认值相同，较小的消息压缩收益抵不过 CPU 开销
+    static constexpr size_t kCompressionThreshold = 1024;
+    static constexpr uint32_t kClientCapabilities = kCapabilityCompression | kCapabilityRetransmit | kCapabilityBatch | kCapabilityHeartbeat;
 
     std::unordered_map<std::string, std::string> userMap_;
+    AckWindow ackWindow_;
+    std::string host_;
+    int port_;
+    std::string password_; // 重连后自动登录
     std::shared_ptr<Poco::Net::StreamSocket> socket_;
+    std::unique_ptr<FrameWriter> writer_;
+    uint32_t capabilities_ = 0; // 与当前连接协商的能力位，和 writer_ 一起由 writerMutex_ 保护
+    std::mutex writerMutex_;
     std::unique_ptr<Poco::Thread> receiverThread_;
+    std::thread heartbeatThread_;
+    std::mutex heartbeatMutex_;
+    std::condition_variable heartbeatStopped_;
+    bool heartbeatRunning_;
+    std::chrono::seconds heartbeatInterval_;
     std::string username_;
     std::string account_;
     bool connected_;
     bool authenticated_;
+    WireFormat wireFormat_;
 };
@@ -16,6 +16,16 @@ void MessageHandler::initialize(std::shared_ptr<Poco::Net::StreamSocket> socket,
 {
     socket_ = socket;
     clientApp_ = clientApp;
+    decoder_ = FrameDecoder();
+    batched_.clear();
+    running_ = true;
+}
+
+void MessageHandler::setSocket(std::shared_ptr<Poco::Net::StreamSocket> socket)
+{
+    socket_ = socket;
+    decoder_ = FrameDecoder();
+    batched_.clear();
     running_ = true;
 }
 
@@ -48,8 +58,27 @@ void MessageHandler::run()
                 break;
             case MessageType::BROADCAST_MESSAGE:
             case MessageType::PRIVATE_MESSAGE:
+            case MessageType::ROOM_MESSAGE:
                 handleChatMessage(static_cast<ChatMessage &>(*message));
                 break;
+            case MessageType::ROOM_RESPONSE:
+                handleRoomResponse(static_cast<RoomResponse &>(*message));
+                break;
+            case MessageType::HISTORY_RESPONSE:
+                handleHistoryResponse(static_cast<HistoryResponse &>(*message));
+                break;
+            case MessageType::MESSAGE_ACK:
+                if (auto clientApp = clientApp_.lock())
+                {
+                    clientApp->handleAck(static_cast<MessageAck &>(*message).getAckId());
+                }
+                break;
+            case MessageType::CAPABILITIES:
+                if (auto clientApp = clientApp_.lock())
+                {
+                    clientApp->applyCapabilities(static_cast<CapabilitiesMessage &>(*message).getCapabilities());
+                }
+                break;
             default:
                 std::cerr << "未知消息类型: " << static_cast<int>(type) << std::endl;
                 break;
@@ -81,6 +110,9 @@ void MessageHandler::handleLoginResponse(const LoginResponse &response)
     {
         if (response.getStatus() == MessageStatus::SUCCESS)
         {
+            // 重发是否带标记、能否合并取决于服务器声明的能力；重发先于新消息写出，服务器按 ID 顺序收到全部消息
+            clientApp->applyServerCapabilities(response.getCapabilities());
+            clientApp->retransmitPending();
             clientApp->setAuthenticated(true);
             clientApp->setAccount(response.getAccount());
             clientApp->setUsername(response.getUsername());
@@ -119,8 +151,8 @@ void MessageHandler::handleChatMessage(const ChatMessage &message)
             std::tuple{message.getSender(), message.getSenderUsername(), message.getContent(),
                        message.getTimestamp(), message.isPrivateMessage()};
 
-        // 处理时间戳
-        auto timePoint = std::chrono::system_clock::time_point{std::chrono::seconds{timestamp}};
+        // 处理时间戳（毫秒）
+        auto timePoint = std::chrono::system_clock::time_point{std::chrono::milliseconds{timestamp}};
         auto tm = std::chrono::system_clock::to_time_t(timePoint);
         std::tm localTime = *std::localtime(&tm);
 
@@ -131,6 +163,10 @@ void MessageHandler::handleChatMessage(const ChatMessage &message)
         {
             ss << "[私信] ";
         }
+        else if (message.isRoomMessage())
+        {
+            ss << "[房间 " << message.getRoom() << "] ";
+        }
         else
         {
             ss << "[广播] ";
@@ -143,9 +179,50 @@ void MessageHandler::handleChatMessage(const ChatMessage &message)
     }
 }
 
+void MessageHandler::handleRoomResponse(const RoomResponse &response)
+{
+    if (response.getStatus() == MessageStatus::SUCCESS)
+    {
+        std::cout << response.getMessage() << std::endl;
+    }
+    else
+    {
+        std::cerr << response.getMessage() << std::endl;
+    }
+}
+
+void MessageHandler::handleHistoryResponse(const HistoryResponse &response)
+{
+    const std::string target = response.getTarget().empty() ? "广播" : response.getTarget();
+    if (response.getStatus() != MessageStatus::SUCCESS)
+    {
+        std::cerr << "无法查看 " << target << " 的历史消息" << std::endl;
+        return;
+    }
+    std::cout << "---- " << target << " 的历史消息（" << response.getMessages().size() << " 条）----" << std::endl;
+    for (const auto &message : response.getMessages())
+    {
+        handleChatMessage(message);
+    }
+    if (response.hasMore() && !response.getMessages().empty())
+    {
+        // 响应受帧大小限制只包含较新的消息
+        std::cout << "---- 更早的消息未全部返回，可用 \\h " << (response.getTarget().empty() ? "*" : response.getTarget())
+                  << " <条数> " << response.getMessages().front().getId() << " 继续查看 ----" << std::endl;
+    }
+    std::cout << "---- 历史消息结束 ----" << std::endl;
+}
+
 // 接受消息并返回一个 Message 对象
 std::unique_ptr<Message> MessageHandler::receiveMessage()
 {
+    if (!batched_.empty())
+    {
+        auto message = std::move(batched_.front());
+        batched_.pop_front();
+        return message;
+    }
+
     auto clientApp = clientApp_.lock();
     if (!clientApp || !socket_ || !clientApp->isConnected())
     {
@@ -153,61 +230,45 @@ std::unique_ptr<Message> MessageHandler::receiveMessage()
     }
     try
     {
-        // 接收4字节的消息长度
-        uint32_t messageLength = 0;
-        int bytesRead = 0;
-
-        // 确保读取完整的4字节长度
-        while (bytesRead < 4)
+        // 接收超时不会丢失已读入的部分数据，下次调用继续拼帧
+        std::string_view payload;
+        while (!decoder_.nextFrame(payload))
         {
-            int received = socket_->receiveBytes(
-                reinterpret_cast<char *>(&messageLength) + bytesRead,
-                4 - bytesRead);
-
-            if (received <= 0)
+            if (decoder_.readFrom(*socket_) == FrameDecoder::ReadResult::CLOSED)
             {
-                if (bytesRead == 0 && received == 0)
+                if (decoder_.buffered() > 0)
                 {
-                    return nullptr;
+                    throw std::runtime_error("连接中断，无法接收完整的消息");
                 }
-                throw std::runtime_error("连接中断，无法接收完整的消息长度");
+                return nullptr;
             }
-
-            bytesRead += received;
         }
 
-        messageLength = ntohl(messageLength);
-
-        if (messageLength == 0)
+        if (!Frame::isBatch(payload))
         {
-            return nullptr; // 空消息
+            return Message::parseMessage(payload);
         }
 
-        if (messageLength > 10 * 1024 * 1024) // 10MB上限
+        // 内嵌负载指向接收缓冲区，下次读取前全部解析出来
+        std::vector<std::string_view> payloads;
+        if (!Frame::unpackBatch(payload, payloads))
         {
-            throw std::runtime_error("消息过大: " + std::to_string(messageLength) + " 字节");
+            return nullptr;
         }
-
-        std::vector<char> buffer(messageLength + 1);
-        bytesRead = 0;
-
-        while (bytesRead < messageLength)
+        for (std::string_view inner : payloads)
         {
-            int received = socket_->receiveBytes(
-                buffer.data() + bytesRead,
-                messageLength - bytesRead);
-
-            if (received <= 0)
+            if (auto message = Message::parseMessage(inner))
             {
-                throw std::runtime_error("连接中断，无法接收完整的消息");
+                batched_.push_back(std::move(message));
             }
-
-            bytesRead += received;
         }
-        buffer[messageLength] = '\0';
-        std::string jsonData(buffer.data(), messageLength);
-
-        return Message::parseMessage(jsonData);
+        if (batched_.empty())
+        {
+            return nullptr;
+        }
+        auto message = std::move(batched_.front());
+        batched_.pop_front();
+        return message;
     }
     catch (const Poco::TimeoutException &e)
     {
@@ -1,16 +1,20 @@
 #pragma once
 
 #include "ClientApp.h"
+#include "FrameDecoder.h"
 #include <Poco/Runnable.h>
 #include <Poco/Net/StreamSocket.h>
 #include <memory>
 #include <atomic>
+#include <deque>
 
 class MessageHandler : public Poco::Runnable
 {
 public:
     static MessageHandler &getInstance();
     void initialize(std::shared_ptr<Poco::Net::StreamSocket> socket, std::shared_ptr<ClientApp> clientApp);
+    // 重连后换用新套接字，须在接收线程停止后调用
+    void setSocket(std::shared_ptr<Poco::Net::StreamSocket> socket);
     ~MessageHandler();
 
     void run() override;
@@ -25,9 +29,14 @@ private:
     void handleLoginResponse(const LoginResponse &response);
     void handleRegisterResponse(const RegisterResponse &response);
     void handleChatMessage(const ChatMessage &message);
+    void handleRoomResponse(const RoomResponse &response);
+    void handleHistoryResponse(const HistoryResponse &response);
 
+    // 每次返回一条消息；收到 BATCH 帧时全部解析后依次返回
     std::unique_ptr<Message> receiveMessage();
+    std::deque<std::unique_ptr<Message>> batched_;
     std::shared_ptr<Poco::Net::StreamSocket> socket_;
+    FrameDecoder decoder_;
     std::atomic<bool> running_;
     std::weak_ptr<ClientApp> clientApp_;
 };
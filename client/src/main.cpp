@@ -39,11 +39,32 @@ int main(int argc, char **argv)
             return 1;
         }
     }
+    // 第三个参数为 binary 时使用紧凑二进制编码
+    bool useBinary = argc >= 4 && std::string(argv[3]) == "binary";
+    // 第四个参数为心跳间隔（秒），0 表示不发送心跳
+    int heartbeatSeconds = 30;
+    if (argc >= 5)
+    {
+        try
+        {
+            heartbeatSeconds = std::stoi(argv[4]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "无效的心跳间隔: " << argv[4] << std::endl;
+            return 1;
+        }
+    }
 
     std::cout << "欢迎来到聊天室，输入 'help' 查看可用命令" << std::endl;
     std::cout << "正在连接到服务器 " << host << ":" << port << "..." << std::endl;
 
     auto clientApp = std::make_shared<ClientApp>();
+    if (useBinary)
+    {
+        clientApp->setWireFormat(WireFormat::BINARY);
+    }
+    clientApp->setHeartbeatInterval(std::chrono::seconds(heartbeatSeconds));
     try
     {
         clientApp->connectToServer(host, port);
@@ -0,0 +1,71 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram() : buckets_(kBuckets, 0)
+{
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t micros)
+{
+    if (micros < kSubBuckets)
+    {
+        return static_cast<size_t>(micros);
+    }
+    unsigned magnitude = 0;
+    while ((micros >> magnitude) > 1)
+    {
+        ++magnitude;
+    }
+    size_t sub = static_cast<size_t>((micros >> (magnitude - kSubBucketBits)) - kSubBuckets);
+    size_t bucket = kSubBuckets + (magnitude - kSubBucketBits) * kSubBuckets + sub;
+    return std::min(bucket, kBuckets - 1);
+}
+
+uint64_t LatencyHistogram::upperBound(size_t bucket)
+{
+    if (bucket < kSubBuckets)
+    {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>((bucket - kSubBuckets) / kSubBuckets);
+    uint64_t sub = (bucket - kSubBuckets) % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros)
+{
+    ++buckets_[bucketOf(micros)];
+    ++count_;
+    sum_ += micros;
+    max_ = std::max(max_, micros);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (size_t i = 0; i < kBuckets; ++i)
+    {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (count_ == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * double(count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i)
+    {
+        seen += buckets_[i];
+        if (seen >= rank)
+        {
+            return std::min(upperBound(i), max_);
+        }
+    }
+    return max_;
+}
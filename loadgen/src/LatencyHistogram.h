@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HDR 式对数-线性直方图（微秒）：每个 2 的幂区间分为 32 个线性子桶，相对误差约 3%，
+// 内存固定，长时间压测也不需要保存每个样本。单线程写入，结束后合并
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+    void merge(const LatencyHistogram &other);
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? double(sum_) / double(count_) : 0.0; }
+    // q 取 0~1，返回所在桶的上界
+    uint64_t percentile(double q) const;
+
+private:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    static constexpr size_t kBuckets = kSubBuckets * 40;
+
+    static size_t bucketOf(uint64_t micros);
+    static uint64_t upperBound(size_t bucket);
+
+    std::vector<uint64_t> buckets_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
@@ -0,0 +1,548 @@
+#include "LoadGenerator.h"
+#include <Poco/Exception.h>
+#include <Poco/Net/SocketAddress.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+    // 收尾阶段：停止发送后继续接收一段时间，让在途消息到达
+    constexpr auto kDrainTime = std::chrono::seconds(2);
+    // 接收等待的上限，保证发送节奏不被长时间阻塞
+    constexpr auto kMaxPollWait = std::chrono::milliseconds(2);
+
+    uint64_t toMicros(std::chrono::steady_clock::time_point time)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count());
+    }
+
+    // 注册成功的回复只在提示文字中给出账号，取其中最后一段数字
+    std::string extractAccount(const std::string &message)
+    {
+        size_t end = message.find_last_of("0123456789");
+        if (end == std::string::npos)
+        {
+            return "";
+        }
+        size_t begin = message.find_last_not_of("0123456789", end);
+        begin = begin == std::string::npos ? 0 : begin + 1;
+        return message.substr(begin, end - begin + 1);
+    }
+
+    bool parseSize(const std::string &value, size_t &out)
+    {
+        char *end = nullptr;
+        unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0')
+        {
+            return false;
+        }
+        out = static_cast<size_t>(parsed);
+        return true;
+    }
+}
+
+bool LoadOptions::parse(int argc, char **argv, LoadOptions &options, std::string &error)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || equals == std::string::npos)
+        {
+            error = "无法识别的参数: " + arg;
+            return false;
+        }
+        std::string key = arg.substr(2, equals - 2);
+        std::string value = arg.substr(equals + 1);
+        size_t number = 0;
+
+        if (key == "host")
+        {
+            options.host = value;
+        }
+        else if (key == "password")
+        {
+            options.password = value;
+        }
+        else if (key == "accounts")
+        {
+            options.accountsFile = value;
+        }
+        else if (key == "output")
+        {
+            options.output = value;
+        }
+        else if (key == "format")
+        {
+            if (value != "binary" && value != "json")
+            {
+                error = "format 只能是 binary 或 json";
+                return false;
+            }
+            options.format = value == "binary" ? WireFormat::BINARY : WireFormat::JSON;
+        }
+        else if (key == "rate")
+        {
+            options.rate = std::atof(value.c_str());
+        }
+        else if (!parseSize(value, number))
+        {
+            error = "参数 " + key + " 需要非负整数";
+            return false;
+        }
+        else if (key == "port")
+        {
+            options.port = static_cast<int>(number);
+        }
+        else if (key == "clients")
+        {
+            options.clients = number;
+        }
+        else if (key == "threads")
+        {
+            options.threads = number;
+        }
+        else if (key == "seconds")
+        {
+            options.seconds = static_cast<int>(number);
+        }
+        else if (key == "broadcast")
+        {
+            options.broadcastPercent = static_cast<int>(number);
+        }
+        else if (key == "content")
+        {
+            options.contentBytes = number;
+        }
+        else
+        {
+            error = "未知参数: " + key;
+            return false;
+        }
+    }
+
+    if (options.clients < 2)
+    {
+        error = "clients 至少为 2";
+        return false;
+    }
+    if (options.rate <= 0 || options.seconds <= 0 || options.broadcastPercent > 100)
+    {
+        error = "rate 和 seconds 必须为正数，broadcast 不超过 100";
+        return false;
+    }
+    options.threads = std::max<size_t>(1, std::min(options.threads, options.clients));
+    return true;
+}
+
+LoadGenerator::LoadGenerator(const LoadOptions &options) : options_(options), stats_(options.threads)
+{
+    // 运行标识写入每条消息，用于忽略上一次压测留下的离线消息
+    runId_ = std::random_device{}();
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    for (auto &client : clients_)
+    {
+        try
+        {
+            client->socket.close();
+        }
+        catch (const Poco::Exception &)
+        {
+        }
+    }
+}
+
+bool LoadGenerator::setup(std::string &error)
+{
+    for (size_t i = 0; i < options_.clients; ++i)
+    {
+        clients_.push_back(std::make_unique<Client>());
+    }
+    loadAccounts();
+
+    std::mutex errorMutex;
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < options_.threads; ++t)
+    {
+        workers.emplace_back([&, t]()
+                             {
+            for (size_t i = t; i < clients_.size() && !failed; i += options_.threads)
+            {
+                std::string clientError;
+                if (!setupClient(i, clientError))
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!failed.exchange(true))
+                    {
+                        error = "客户端 " + std::to_string(i) + ": " + clientError;
+                    }
+                }
+            } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    saveAccounts();
+    return !failed;
+}
+
+bool LoadGenerator::setupClient(size_t index, std::string &error)
+{
+    Client &client = *clients_[index];
+    try
+    {
+        client.socket.connect(Poco::Net::SocketAddress(options_.host, static_cast<Poco::UInt16>(options_.port)));
+        client.socket.setNoDelay(true);
+        client.socket.setReceiveTimeout(Poco::Timespan(10, 0));
+
+        if (client.account.empty())
+        {
+            if (!sendFrame(client, Frame::create(RegisterRequest("loadgen" + std::to_string(index), options_.password), options_.format)))
+            {
+                error = "发送注册请求失败";
+                return false;
+            }
+            auto response = waitForResponse(client, MessageType::REGISTER_RESPONSE);
+            auto *registerResponse = static_cast<RegisterResponse *>(response.get());
+            if (!registerResponse || registerResponse->getStatus() != MessageStatus::SUCCESS)
+            {
+                error = "注册失败";
+                return false;
+            }
+            client.account = extractAccount(registerResponse->getMessage());
+            client.registered = true;
+        }
+
+        if (!sendFrame(client, Frame::create(LoginRequest(client.account, options_.password), options_.format)))
+        {
+            error = "发送登录请求失败";
+            return false;
+        }
+        auto response = waitForResponse(client, MessageType::LOGIN_RESPONSE);
+        auto *loginResponse = static_cast<LoginResponse *>(response.get());
+        if (!loginResponse || loginResponse->getStatus() != MessageStatus::SUCCESS)
+        {
+            error = "账号 " + client.account + " 登录失败";
+            return false;
+        }
+        // 与随客户端一起发布的行为一致：服务器在登录响应中声明支持后，声明能解包 BATCH 帧，服务器才会合并小消息
+        if ((loginResponse->getCapabilities() & kCapabilityBatch) &&
+            !sendFrame(client, Frame::create(CapabilitiesMessage(kCapabilityBatch), options_.format)))
+        {
+            error = "发送能力声明失败";
+            return false;
+        }
+        return true;
+    }
+    catch (const Poco::Exception &e)
+    {
+        error = e.displayText();
+        return false;
+    }
+}
+
+std::unique_ptr<Message> LoadGenerator::waitForResponse(Client &client, MessageType type)
+{
+    std::string_view payload;
+    std::vector<std::string_view> payloads;
+    while (true)
+    {
+        while (client.decoder.nextFrame(payload))
+        {
+            // 登录结果可能和随后补发的离线消息合并在同一个 BATCH 帧中
+            if (!Frame::unpackBatch(payload, payloads))
+            {
+                payloads.assign(1, payload);
+            }
+            for (std::string_view inner : payloads)
+            {
+                auto message = Message::parseMessage(inner);
+                if (message && message->getType() == type)
+                {
+                    return message;
+                }
+            }
+        }
+        // 阻塞套接字上超时会抛出 Poco::TimeoutException
+        if (client.decoder.readFrom(client.socket) != FrameDecoder::ReadResult::DATA)
+        {
+            return nullptr;
+        }
+    }
+}
+
+void LoadGenerator::run()
+{
+    auto start = Clock::now();
+    auto stop = start + std::chrono::seconds(options_.seconds);
+    auto drainUntil = stop + kDrainTime;
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < options_.threads; ++t)
+    {
+        workers.emplace_back(&LoadGenerator::workerLoop, this, t, start, stop, drainUntil);
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    elapsedSeconds_ = std::chrono::duration<double>(stop - start).count();
+}
+
+void LoadGenerator::workerLoop(size_t worker, Clock::time_point start, Clock::time_point stop, Clock::time_point drainUntil)
+{
+    std::vector<size_t> own;
+    for (size_t i = worker; i < clients_.size(); i += options_.threads)
+    {
+        own.push_back(i);
+    }
+
+    std::mt19937_64 random(std::random_device{}() + worker);
+    // 每个线程承担总速率的 1/threads，按固定间隔排定发送时刻
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(double(options_.threads) / options_.rate));
+    auto next = start;
+    size_t cursor = 0;
+
+    while (true)
+    {
+        auto now = Clock::now();
+        if (now >= drainUntil)
+        {
+            break;
+        }
+
+        while (next <= now && next < stop)
+        {
+            size_t sender = own[cursor++ % own.size()];
+            bool broadcast = static_cast<int>(random() % 100) < options_.broadcastPercent;
+            size_t receiver = random() % (clients_.size() - 1);
+            if (receiver >= sender)
+            {
+                ++receiver;
+            }
+            sendOne(worker, *clients_[sender], broadcast, receiver, next);
+            next += interval;
+        }
+
+        auto wake = next < stop ? next : drainUntil;
+        auto wait = std::max(Clock::duration::zero(), std::min<Clock::duration>(wake - Clock::now(), kMaxPollWait));
+        receiveAvailable(worker, wait);
+    }
+}
+
+void LoadGenerator::sendOne(size_t worker, Client &client, bool broadcast, size_t receiver, Clock::time_point scheduled)
+{
+    WorkerStats &stats = stats_[worker];
+    if (!client.open)
+    {
+        ++stats.errors;
+        return;
+    }
+
+    // 内容为 "<运行标识>:<计划发送时刻>|" 加填充，总长为 contentBytes
+    std::string content = std::to_string(runId_) + ":" + std::to_string(toMicros(scheduled)) + "|";
+    content.resize(std::max(content.size(), options_.contentBytes), 'x');
+    FramePtr frame = broadcast
+                         ? Frame::create(ChatMessage(client.account, "", content), options_.format)
+                         : Frame::create(ChatMessage(client.account, "", clients_[receiver]->account, content), options_.format);
+    if (!sendFrame(client, frame))
+    {
+        client.open = false;
+        ++stats.errors;
+        return;
+    }
+    ++(broadcast ? stats.broadcasts : stats.privates);
+}
+
+void LoadGenerator::receiveAvailable(size_t worker, Clock::duration timeout)
+{
+    WorkerStats &stats = stats_[worker];
+    Poco::Net::Socket::SocketList readList;
+    Poco::Net::Socket::SocketList writeList;
+    Poco::Net::Socket::SocketList exceptList;
+    std::unordered_map<const Poco::Net::SocketImpl *, Client *> bySocket;
+    for (size_t i = worker; i < clients_.size(); i += options_.threads)
+    {
+        Client &client = *clients_[i];
+        if (client.open)
+        {
+            readList.push_back(client.socket);
+            bySocket[client.socket.impl()] = &client;
+        }
+    }
+    if (readList.empty())
+    {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+    if (Poco::Net::Socket::select(readList, writeList, exceptList, Poco::Timespan(micros)) <= 0)
+    {
+        return;
+    }
+
+    for (auto &socket : readList)
+    {
+        Client &client = *bySocket[socket.impl()];
+        try
+        {
+            if (client.decoder.readFrom(client.socket) == FrameDecoder::ReadResult::CLOSED)
+            {
+                client.open = false;
+                ++stats.errors;
+                continue;
+            }
+            auto now = Clock::now();
+            std::string_view payload;
+            while (client.decoder.nextFrame(payload))
+            {
+                handlePayload(stats, payload, now);
+            }
+        }
+        catch (const Poco::Exception &)
+        {
+            client.open = false;
+            ++stats.errors;
+        }
+    }
+}
+
+void LoadGenerator::handlePayload(WorkerStats &stats, std::string_view payload, Clock::time_point now)
+{
+    if (Frame::isBatch(payload))
+    {
+        std::vector<std::string_view> payloads;
+        if (Frame::unpackBatch(payload, payloads))
+        {
+            for (std::string_view inner : payloads)
+            {
+                handlePayload(stats, inner, now);
+            }
+        }
+        return;
+    }
+
+    auto message = Message::parseMessage(payload);
+    if (!message || (message->getType() != MessageType::BROADCAST_MESSAGE && message->getType() != MessageType::PRIVATE_MESSAGE))
+    {
+        return;
+    }
+
+    const std::string &content = static_cast<ChatMessage &>(*message).getContent();
+    char *end = nullptr;
+    unsigned long long runId = std::strtoull(content.c_str(), &end, 10);
+    if (runId != runId_ || *end != ':')
+    {
+        return;
+    }
+    uint64_t scheduled = std::strtoull(end + 1, nullptr, 10);
+    uint64_t received = toMicros(now);
+    stats.latency.record(received > scheduled ? received - scheduled : 0);
+    ++stats.delivered;
+}
+
+bool LoadGenerator::sendFrame(Client &client, const FramePtr &frame)
+{
+    try
+    {
+        size_t sent = 0;
+        while (sent < frame->size())
+        {
+            int n = client.socket.sendBytes(frame->data() + sent, static_cast<int>(frame->size() - sent));
+            if (n <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+    catch (const Poco::Exception &)
+    {
+        return false;
+    }
+}
+
+void LoadGenerator::loadAccounts()
+{
+    std::ifstream file(options_.accountsFile);
+    std::string account;
+    size_t index = 0;
+    while (index < clients_.size() && file >> account)
+    {
+        clients_[index++]->account = account;
+    }
+}
+
+void LoadGenerator::saveAccounts() const
+{
+    // 只追加新注册的账号，下次运行直接复用
+    std::ofstream file(options_.accountsFile, std::ios::app);
+    for (const auto &client : clients_)
+    {
+        if (client->registered)
+        {
+            file << client->account << "\n";
+        }
+    }
+}
+
+std::string LoadGenerator::resultJSON() const
+{
+    LatencyHistogram latency;
+    uint64_t broadcasts = 0;
+    uint64_t privates = 0;
+    uint64_t delivered = 0;
+    uint64_t errors = 0;
+    for (const auto &stats : stats_)
+    {
+        latency.merge(stats.latency);
+        broadcasts += stats.broadcasts;
+        privates += stats.privates;
+        delivered += stats.delivered;
+        errors += stats.errors;
+    }
+    size_t registered = 0;
+    for (const auto &client : clients_)
+    {
+        registered += client->registered ? 1 : 0;
+    }
+
+    // 服务器不把广播回送给发送者
+    uint64_t expected = broadcasts * (clients_.size() - 1) + privates;
+    double seconds = elapsedSeconds_ > 0 ? elapsedSeconds_ : 1;
+
+    char buffer[1024];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"host\":\"%s\",\"port\":%d,\"clients\":%zu,\"threads\":%zu,\"seconds\":%d,\"target_rate\":%.0f,"
+                  "\"broadcast_percent\":%d,\"content_bytes\":%zu,\"format\":\"%s\",\"registered\":%zu,"
+                  "\"sent\":%llu,\"broadcasts\":%llu,\"privates\":%llu,\"send_rate\":%.1f,"
+                  "\"expected_deliveries\":%llu,\"delivered\":%llu,\"delivery_rate\":%.1f,\"errors\":%llu,"
+                  "\"latency_us\":{\"mean\":%.1f,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}}",
+                  options_.host.c_str(), options_.port, options_.clients, options_.threads, options_.seconds, options_.rate,
+                  options_.broadcastPercent, options_.contentBytes, options_.format == WireFormat::BINARY ? "binary" : "json", registered,
+                  static_cast<unsigned long long>(broadcasts + privates), static_cast<unsigned long long>(broadcasts),
+                  static_cast<unsigned long long>(privates), double(broadcasts + privates) / seconds,
+                  static_cast<unsigned long long>(expected), static_cast<unsigned long long>(delivered), double(delivered) / seconds,
+                  static_cast<unsigned long long>(errors), latency.mean(),
+                  static_cast<unsigned long long>(latency.percentile(0.50)), static_cast<unsigned long long>(latency.percentile(0.90)),
+                  static_cast<unsigned long long>(latency.percentile(0.99)), static_cast<unsigned long long>(latency.percentile(0.999)),
+                  static_cast<unsigned long long>(latency.max()));
+    return buffer;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "FrameDecoder.h"
+#include "Frame.h"
+#include "LatencyHistogram.h"
+#include "Message.h"
+#include <Poco/Net/StreamSocket.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct LoadOptions
+{
+    std::string host = "127.0.0.1";
+    int port = 9999;
+    size_t clients = 100;
+    size_t threads = 4;
+    int seconds = 30;
+    double rate = 1000;        // 所有客户端合计每秒发送的消息数
+    int broadcastPercent = 10; // 其余为私聊，接收方随机
+    size_t contentBytes = 64;
+    WireFormat format = WireFormat::BINARY;
+    std::string password = "loadgen-pass";
+    std::string accountsFile = "loadgen_accounts.txt";
+    std::string output; // 为空时结果输出到标准输出
+
+    // 参数形如 --clients=200，出错时返回 false 并给出原因
+    static bool parse(int argc, char **argv, LoadOptions &options, std::string &error);
+};
+
+// 多客户端负载生成器：复用（或注册）一批账号并全部登录，之后按目标速率发送广播和私聊，
+// 每条消息的内容以计划发送时刻开头，接收方据此计算端到端投递延迟。
+// 发送按计划时刻而不是实际时刻计时，服务器变慢导致的发送滞后同样计入延迟
+class LoadGenerator
+{
+public:
+    explicit LoadGenerator(const LoadOptions &options);
+    ~LoadGenerator();
+
+    // 建立连接、补齐账号并登录，任一客户端失败时返回 false
+    bool setup(std::string &error);
+    void run();
+    std::string resultJSON() const;
+
+    LoadGenerator(const LoadGenerator &) = delete;
+    LoadGenerator &operator=(const LoadGenerator &) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Client
+    {
+        Poco::Net::StreamSocket socket;
+        FrameDecoder decoder;
+        std::string account;
+        bool registered = false; // 本次运行新注册的账号
+        bool open = true;
+    };
+
+    struct WorkerStats
+    {
+        uint64_t broadcasts = 0;
+        uint64_t privates = 0;
+        uint64_t delivered = 0;
+        uint64_t errors = 0;
+        LatencyHistogram latency;
+    };
+
+    bool setupClient(size_t index, std::string &error);
+    std::unique_ptr<Message> waitForResponse(Client &client, MessageType type);
+    void workerLoop(size_t worker, Clock::time_point start, Clock::time_point stop, Clock::time_point drainUntil);
+    void sendOne(size_t worker, Client &client, bool broadcast, size_t receiver, Clock::time_point scheduled);
+    // 等待至多 timeout，把本线程所有可读连接中已到达的帧处理完
+    void receiveAvailable(size_t worker, Clock::duration timeout);
+    void handlePayload(WorkerStats &stats, std::string_view payload, Clock::time_point now);
+    bool sendFrame(Client &client, const FramePtr &frame);
+
+    void loadAccounts();
+    void saveAccounts() const;
+
+    LoadOptions options_;
+    std::vector<std::unique_ptr<Client>> clients_;
+    std::vector<WorkerStats> stats_;
+    uint32_t runId_ = 0;
+    double elapsedSeconds_ = 0;
+};
@@ -0,0 +1,45 @@
+// chat_loadgen：多客户端负载生成器，结果以一行 JSON 输出，便于比较不同构建的运行结果。
+//
+// 用法: chat_loadgen [--host=127.0.0.1] [--port=9999] [--clients=100] [--threads=4] [--seconds=30]
+//                    [--rate=1000] [--broadcast=10] [--content=64] [--format=binary|json]
+//                    [--password=loadgen-pass] [--accounts=loadgen_accounts.txt] [--output=result.json]
+//   rate 为所有客户端合计每秒发送的消息数，broadcast 为广播所占百分比，其余为随机接收方的私聊。
+//   账号文件中不足 clients 个账号时自动注册并追加到文件，之后的运行直接登录复用。
+#include "LoadGenerator.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    std::string error;
+    if (!LoadOptions::parse(argc, argv, options, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    LoadGenerator generator(options);
+    std::fprintf(stderr, "正在登录 %zu 个客户端...\n", options.clients);
+    if (!generator.setup(error))
+    {
+        std::fprintf(stderr, "准备客户端失败: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::fprintf(stderr, "开始发送，持续 %d 秒，目标速率 %.0f 条/秒\n", options.seconds, options.rate);
+    generator.run();
+
+    std::string result = generator.resultJSON();
+    if (options.output.empty())
+    {
+        std::printf("%s\n", result.c_str());
+    }
+    else
+    {
+        std::ofstream(options.output) << result << "\n";
+        std::fprintf(stderr, "结果已写入 %s\n", options.output.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "AckWindow.h"
+#include <algorithm>
+
+AckWindow::AckWindow(size_t capacity) : capacity_(std::max<size_t>(capacity, 1))
+{
+}
+
+bool AckWindow::waitForSpace(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return space_.wait_for(lock, timeout, [this]
+                           { return entries_.size() < capacity_; });
+}
+
+void AckWindow::push(uint64_t id, FramePtr frame, FramePtr retransmit)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({id, std::move(frame), std::move(retransmit)});
+}
+
+size_t AckWindow::acknowledge(uint64_t ackId)
+{
+    size_t removed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!entries_.empty() && entries_.front().id <= ackId)
+        {
+            entries_.pop_front();
+            ++removed;
+        }
+    }
+    if (removed > 0)
+    {
+        space_.notify_all();
+    }
+    return removed;
+}
+
+std::vector<FramePtr> AckWindow::pending(bool marked) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FramePtr> frames;
+    frames.reserve(entries_.size());
+    for (const auto &entry : entries_)
+    {
+        frames.push_back(marked && entry.retransmit ? entry.retransmit : entry.frame);
+    }
+    return frames;
+}
+
+size_t AckWindow::clear()
+{
+    size_t removed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        removed = entries_.size();
+        entries_.clear();
+    }
+    space_.notify_all();
+    return removed;
+}
+
+size_t AckWindow::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Frame.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// 发送窗口：保存已发出但尚未被 MESSAGE_ACK 确认的帧。消息 ID 在同一客户端内单调递增，
+// 按发送顺序追加即保持有序，累计确认从队头弹出。窗口满时发送方等待确认腾出空间，
+// 不满时可以连续发送而不必等待每条消息的往返；重连并重新登录后按原顺序重发剩余的帧（至少一次投递）。
+// 发送线程和接收线程可以同时使用
+class AckWindow
+{
+public:
+    explicit AckWindow(size_t capacity);
+
+    // 等待窗口出现空位，超时返回 false
+    bool waitForSpace(std::chrono::milliseconds timeout);
+    // 发送前登记，id 必须大于已登记的所有 id；retransmit 为同一消息带重发标记的编码，可以为空
+    void push(uint64_t id, FramePtr frame, FramePtr retransmit = nullptr);
+    // 累计确认：移除 id 不大于 ackId 的帧，返回移除的数量
+    size_t acknowledge(uint64_t ackId);
+    // 未确认的帧，按发送顺序排列；marked 为 true 时优先取带重发标记的编码
+    std::vector<FramePtr> pending(bool marked = false) const;
+    // 放弃所有未确认的帧（例如登出后），返回放弃的数量
+    size_t clear();
+
+    size_t size() const;
+    size_t capacity() const { return capacity_; }
+
+    AckWindow(const AckWindow &) = delete;
+    AckWindow &operator=(const AckWindow &) = delete;
+
+private:
+    struct Entry
+    {
+        uint64_t id;
+        FramePtr frame;
+        FramePtr retransmit;
+    };
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable space_;
+    std::deque<Entry> entries_;
+};
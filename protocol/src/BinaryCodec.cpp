@@ -0,0 +1,101 @@
+#include "BinaryCodec.h"
+
+void BinaryWriter::writeVarUInt(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out_.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::writeVarInt(int64_t value)
+{
+    // ZigZag 编码，使小的负数同样只占少量字节
+    writeVarUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void BinaryWriter::writeString(const std::string &value)
+{
+    writeVarUInt(value.size());
+    out_.append(value);
+}
+
+bool BinaryReader::readByte(uint8_t &value)
+{
+    if (!ok_ || data_ == end_)
+    {
+        return fail();
+    }
+    value = static_cast<uint8_t>(*data_++);
+    return true;
+}
+
+bool BinaryReader::readVarUInt(uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        uint8_t byte = 0;
+        if (!readByte(byte))
+        {
+            return false;
+        }
+        // 第10个字节只剩最低位可用，更高的位超出64位，不能静默截断
+        if (shift == 63 && byte > 1)
+        {
+            return fail();
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    // 超过10个字节的变长整数视为格式错误
+    return fail();
+}
+
+bool BinaryReader::readVarInt(int64_t &value)
+{
+    uint64_t raw = 0;
+    if (!readVarUInt(raw))
+    {
+        return false;
+    }
+    value = static_cast<int64_t>((raw >> 1) ^ (~(raw & 1) + 1));
+    return true;
+}
+
+bool BinaryReader::readString(std::string &value)
+{
+    uint64_t length = 0;
+    if (!readVarUInt(length))
+    {
+        return false;
+    }
+    if (length > remaining())
+    {
+        return fail();
+    }
+    value.assign(data_, static_cast<size_t>(length));
+    data_ += length;
+    return true;
+}
+
+bool BinaryReader::readString(std::string_view &value)
+{
+    uint64_t length = 0;
+    if (!readVarUInt(length))
+    {
+        return false;
+    }
+    if (length > remaining())
+    {
+        return fail();
+    }
+    value = std::string_view(data_, static_cast<size_t>(length));
+    data_ += length;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 二进制编码的首字节，JSON 负载总是以 '{' 或空白开头，不会与之冲突
+constexpr uint8_t kBinaryMagic = 0xB1;
+
+// 紧凑二进制编码写入器：整数使用 LEB128 变长编码，字符串为 长度+字节
+class BinaryWriter
+{
+public:
+    explicit BinaryWriter(std::string &out) : out_(out) {}
+
+    void writeByte(uint8_t value) { out_.push_back(static_cast<char>(value)); }
+    void writeVarUInt(uint64_t value);
+    void writeVarInt(int64_t value);
+    void writeString(const std::string &value);
+    void writeBytes(const char *data, size_t length) { out_.append(data, length); }
+
+private:
+    std::string &out_;
+};
+
+// 紧凑二进制编码读取器，直接在输入缓冲区上解码，任何越界都会使 ok() 变为 false
+class BinaryReader
+{
+public:
+    BinaryReader(const char *data, size_t length) : data_(data), end_(data + length) {}
+
+    bool readByte(uint8_t &value);
+    bool readVarUInt(uint64_t &value);
+    bool readVarInt(int64_t &value);
+    bool readString(std::string &value);
+    // 不拷贝，value 指向输入缓冲区
+    bool readString(std::string_view &value);
+
+    bool ok() const { return ok_; }
+    bool atEnd() const { return data_ == end_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - data_); }
+
+private:
+    bool fail()
+    {
+        ok_ = false;
+        return false;
+    }
+
+    const char *data_;
+    const char *end_;
+    bool ok_ = true;
+};
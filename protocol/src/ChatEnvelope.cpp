@@ -0,0 +1,260 @@
+#include "ChatEnvelope.h"
+#include "BinaryCodec.h"
+#include "IdGenerator.h"
+#include "JsonReader.h"
+#include <cstdio>
+
+namespace
+{
+    bool isChatType(uint64_t type)
+    {
+        return type == static_cast<uint64_t>(MessageType::BROADCAST_MESSAGE) ||
+               type == static_cast<uint64_t>(MessageType::PRIVATE_MESSAGE) ||
+               type == static_cast<uint64_t>(MessageType::ROOM_MESSAGE);
+    }
+
+    void appendJSONString(std::string &out, const std::string &value)
+    {
+        out.push_back('"');
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                }
+                else
+                {
+                    out.push_back(c);
+                }
+                break;
+            }
+        }
+        out.push_back('"');
+    }
+}
+
+bool ChatEnvelope::parse(std::string_view payload)
+{
+    format_ = Message::detectFormat(payload);
+    frames_[0].reset();
+    frames_[1].reset();
+    return format_ == WireFormat::BINARY ? parseBinary(payload) : parseJSON(payload);
+}
+
+bool ChatEnvelope::parseBinary(std::string_view payload)
+{
+    BinaryReader reader(payload.data() + 1, payload.size() - 1);
+    uint8_t type = 0;
+    uint64_t clientId = 0;
+    uint64_t ignored = 0;
+    std::string_view sender;
+    std::string_view senderUsername;
+    std::string_view receiver;
+    if (!reader.readByte(type) || !isChatType(type) || !reader.readVarUInt(clientId) || !reader.readVarUInt(ignored) ||
+        !reader.readString(sender) || !reader.readString(senderUsername) || !reader.readString(receiver))
+    {
+        return false;
+    }
+
+    // content 连同长度前缀原样保留
+    size_t contentStart = payload.size() - reader.remaining();
+    std::string_view content;
+    if (!reader.readString(content))
+    {
+        return false;
+    }
+    size_t contentEnd = payload.size() - reader.remaining();
+    uint64_t flags = 0;
+    if (!reader.readVarUInt(ignored) || (!reader.atEnd() && !reader.readVarUInt(flags)) || !reader.atEnd())
+    {
+        return false;
+    }
+
+    type_ = static_cast<MessageType>(type);
+    clientId_ = clientId;
+    retransmit_ = (flags & kChatFlagRetransmit) != 0;
+    receiver_.assign(receiver.data(), receiver.size());
+    content_ = payload.substr(contentStart, contentEnd - contentStart);
+    return true;
+}
+
+bool ChatEnvelope::parseJSON(std::string_view payload)
+{
+    JsonReader reader(payload);
+    if (!reader.beginObject())
+    {
+        return false;
+    }
+
+    bool hasType = false;
+    clientId_ = 0;
+    retransmit_ = false;
+    receiver_.clear();
+    content_ = std::string_view();
+    std::string_view key;
+    while (reader.nextKey(key))
+    {
+        if (key == "type")
+        {
+            int64_t type = 0;
+            if (!reader.readInt(type) || type < 0 || !isChatType(static_cast<uint64_t>(type)) ||
+                (hasType && static_cast<MessageType>(type) != type_))
+            {
+                return false;
+            }
+            type_ = static_cast<MessageType>(type);
+            hasType = true;
+        }
+        else if (key == "id")
+        {
+            if (!reader.readUInt(clientId_))
+            {
+                return false;
+            }
+        }
+        else if (key == "retransmit")
+        {
+            uint64_t retransmit = 0;
+            if (!reader.readUInt(retransmit))
+            {
+                return false;
+            }
+            retransmit_ = retransmit != 0;
+        }
+        else if (key == "receiver")
+        {
+            if (!reader.readString(receiver_))
+            {
+                return false;
+            }
+        }
+        else if (key == "content")
+        {
+            if (!reader.readRawString(content_))
+            {
+                return false;
+            }
+        }
+        else if (!reader.skipValue())
+        {
+            return false;
+        }
+    }
+    return hasType && reader.finished();
+}
+
+void ChatEnvelope::setSender(const std::string &sender, const std::string &senderUsername)
+{
+    sender_ = sender;
+    senderUsername_ = senderUsername;
+    frames_[0].reset();
+    frames_[1].reset();
+}
+
+void ChatEnvelope::setSeq(uint64_t seq)
+{
+    seq_ = seq;
+    frames_[0].reset();
+    frames_[1].reset();
+}
+
+void ChatEnvelope::stamp()
+{
+    id_ = IdGenerator::getInstance().next();
+    timestamp_ = IdGenerator::timestampOf(id_);
+    frames_[0].reset();
+    frames_[1].reset();
+}
+
+void ChatEnvelope::encodeBinary(std::string &out) const
+{
+    out.reserve(out.size() + 32 + sender_.size() + senderUsername_.size() + receiver_.size() + content_.size());
+    BinaryWriter writer(out);
+    writer.writeByte(kBinaryMagic);
+    writer.writeByte(static_cast<uint8_t>(type_));
+    writer.writeVarUInt(id_);
+    writer.writeVarUInt(timestamp_);
+    writer.writeString(sender_);
+    writer.writeString(senderUsername_);
+    writer.writeString(receiver_);
+    writer.writeBytes(content_.data(), content_.size());
+    writer.writeVarUInt(seq_);
+}
+
+void ChatEnvelope::encodeJSON(std::string &out) const
+{
+    // 与 Poco 的输出一致，键按字母序排列
+    out.reserve(out.size() + 160 + sender_.size() + senderUsername_.size() + receiver_.size() + content_.size());
+    out += "{\"content\":";
+    if (content_.empty())
+    {
+        out += "\"\"";
+    }
+    else
+    {
+        out.append(content_.data(), content_.size());
+    }
+    out += ",\"id\":" + std::to_string(id_);
+    out += ",\"receiver\":";
+    appendJSONString(out, receiver_);
+    out += ",\"sender\":";
+    appendJSONString(out, sender_);
+    out += ",\"sender_username\":";
+    appendJSONString(out, senderUsername_);
+    out += ",\"seq\":" + std::to_string(seq_);
+    out += ",\"timestamp\":" + std::to_string(timestamp_);
+    out += ",\"type\":" + std::to_string(static_cast<int>(type_)) + "}";
+}
+
+FramePtr ChatEnvelope::frame(WireFormat format) const
+{
+    FramePtr &frame = frames_[static_cast<size_t>(format)];
+    if (frame)
+    {
+        return frame;
+    }
+
+    if (format == format_)
+    {
+        std::string bytes(Frame::kHeaderSize, '\0');
+        if (format == WireFormat::BINARY)
+        {
+            encodeBinary(bytes);
+        }
+        else
+        {
+            encodeJSON(bytes);
+        }
+        frame = Frame::fromBuffer(std::move(bytes), type_);
+    }
+    else if (auto message = toMessage())
+    {
+        frame = Frame::create(*message, format);
+    }
+    return frame;
+}
+
+std::unique_ptr<Message> ChatEnvelope::toMessage() const
+{
+    return Message::parseMessage(frame(format_)->payload());
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Frame.h"
+#include "Message.h"
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 只为路由解码的聊天消息：从收到的负载中取出类型和接收方，content 保留为原始字节
+// （二进制为 长度+字节，JSON 为带引号的原样字符串），客户端填写的发送者、ID、时间戳和序号直接忽略。
+// 转发时把服务器分配的 ID、时间戳、会话序号和会话中的发送者身份与原始 content 拼接成新负载，
+// content 既不解码也不重新转义；只有接收方的线路格式与来源不同时才完整解析后重新编码。
+// 原始字节指向接收缓冲区，只在处理这一帧期间有效
+class ChatEnvelope
+{
+public:
+    ChatEnvelope() = default;
+
+    // 负载不是聊天消息或格式错误时返回 false
+    bool parse(std::string_view payload);
+
+    MessageType getType() const { return type_; }
+    WireFormat getFormat() const { return format_; }
+    const std::string &getReceiver() const { return receiver_; }
+    const std::string &getRoom() const { return receiver_; }
+    const std::string &getSender() const { return sender_; }
+    uint64_t getId() const { return id_; }
+    uint64_t getSeq() const { return seq_; }
+    // 客户端填写的消息 ID（同一客户端内单调递增），服务器按连接对它做累计确认
+    uint64_t getClientId() const { return clientId_; }
+    // 客户端重发未确认消息时带的标记，只有带标记的消息可能已经转发过
+    bool isRetransmit() const { return retransmit_; }
+    // content 的原始字节数（含长度前缀或引号），用于日志和统计
+    size_t getContentSize() const { return content_.size(); }
+
+    bool isPrivateMessage() const { return type_ == MessageType::PRIVATE_MESSAGE; }
+    bool isBroadcastMessage() const { return type_ == MessageType::BROADCAST_MESSAGE; }
+    bool isRoomMessage() const { return type_ == MessageType::ROOM_MESSAGE; }
+
+    // 以下设置需在生成帧之前完成
+    void setSender(const std::string &sender, const std::string &senderUsername);
+    void setSeq(uint64_t seq);
+    // 分配本节点的消息 ID 和时间戳
+    void stamp();
+
+    // 按接收方格式取帧，每种格式只编码一次，所有接收者共享
+    FramePtr frame(WireFormat format) const;
+    // 完整解析为 ChatMessage，供跨格式转发等少数路径使用
+    std::unique_ptr<Message> toMessage() const;
+
+    ChatEnvelope(const ChatEnvelope &) = delete;
+    ChatEnvelope &operator=(const ChatEnvelope &) = delete;
+
+private:
+    bool parseBinary(std::string_view payload);
+    bool parseJSON(std::string_view payload);
+    // 以来源格式拼接负载，追加到 out
+    void encodeBinary(std::string &out) const;
+    void encodeJSON(std::string &out) const;
+
+    MessageType type_ = MessageType::BROADCAST_MESSAGE;
+    WireFormat format_ = WireFormat::JSON;
+    std::string receiver_;
+    std::string_view content_;
+    std::string sender_;
+    std::string senderUsername_;
+    uint64_t id_ = 0;
+    uint64_t clientId_ = 0;
+    uint64_t timestamp_ = 0;
+    uint64_t seq_ = 0;
+    bool retransmit_ = false;
+    mutable FramePtr frames_[2];
+};
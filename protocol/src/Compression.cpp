@@ -0,0 +1,59 @@
+#include "Compression.h"
+#include <Poco/DeflatingStream.h>
+#include <Poco/Exception.h>
+#include <Poco/InflatingStream.h>
+#include <Poco/MemoryStream.h>
+#include <sstream>
+
+std::string Compression::deflate(std::string_view data, int level)
+{
+    std::ostringstream compressed;
+    Poco::DeflatingOutputStream deflater(compressed, Poco::DeflatingStreamBuf::STREAM_ZLIB, level);
+    deflater.write(data.data(), static_cast<std::streamsize>(data.size()));
+    deflater.close();
+    return compressed.str();
+}
+
+void Compression::inflate(std::string_view data, size_t maxSize, std::string &out)
+{
+    out.clear();
+    try
+    {
+        Poco::MemoryInputStream source(data.data(), static_cast<std::streamsize>(data.size()));
+        Poco::InflatingInputStream inflater(source, Poco::InflatingStreamBuf::STREAM_ZLIB);
+        // 流缓冲区中的 zlib 错误默认只会置 badbit，让它原样抛出
+        inflater.exceptions(std::ios::badbit);
+        // 按块读取并随时检查上限，伪造的高压缩比数据不会撑爆内存
+        char chunk[16 * 1024];
+        while (inflater)
+        {
+            inflater.read(chunk, sizeof(chunk));
+            std::streamsize n = inflater.gcount();
+            if (n <= 0)
+            {
+                break;
+            }
+            if (out.size() + static_cast<size_t>(n) > maxSize)
+            {
+                throw Poco::DataFormatException("解压后的消息过大");
+            }
+            out.append(chunk, static_cast<size_t>(n));
+        }
+    }
+    catch (const Poco::DataFormatException &)
+    {
+        throw;
+    }
+    catch (const Poco::Exception &e)
+    {
+        throw Poco::DataFormatException("无法解压消息: " + e.displayText());
+    }
+    catch (const std::exception &e)
+    {
+        throw Poco::DataFormatException("无法解压消息: " + std::string(e.what()));
+    }
+    if (out.empty())
+    {
+        throw Poco::DataFormatException("压缩消息为空");
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 帧负载的 zlib 压缩，基于 Poco Foundation 的压缩流。
+// 默认使用最快一档：聊天 JSON 的重复度高，快档已能拿到大部分压缩率，CPU 开销最小
+class Compression
+{
+public:
+    static constexpr int kDefaultLevel = 1;
+
+    static std::string deflate(std::string_view data, int level = kDefaultLevel);
+    // 解压到 out（覆盖原内容）；数据损坏或解压后超过 maxSize 时抛出 Poco::DataFormatException
+    static void inflate(std::string_view data, size_t maxSize, std::string &out);
+};
@@ -0,0 +1,175 @@
+#include "Frame.h"
+#include "BinaryCodec.h"
+#include "Compression.h"
+#include "JsonReader.h"
+#include <cstring>
+
+namespace
+{
+    void writeHeader(std::string &bytes, size_t payloadLength, uint32_t flags = 0)
+    {
+        uint32_t length = static_cast<uint32_t>(payloadLength) | flags;
+        bytes[0] = static_cast<char>((length >> 24) & 0xFF);
+        bytes[1] = static_cast<char>((length >> 16) & 0xFF);
+        bytes[2] = static_cast<char>((length >> 8) & 0xFF);
+        bytes[3] = static_cast<char>(length & 0xFF);
+    }
+
+    // JSON 批量帧总是以类型开头，接收方不必解析就能识别
+    constexpr std::string_view kJSONBatchPrefix = "{\"type\":32,";
+}
+
+FramePtr Frame::create(const Message &message, WireFormat format)
+{
+    return fromPayload(message.encode(format), message.getType());
+}
+
+FramePtr Frame::fromPayload(std::string_view payload, MessageType type)
+{
+    // 长度头与负载连续存放，发送时只需一次写入
+    std::string bytes(kHeaderSize + payload.size(), '\0');
+    std::memcpy(&bytes[kHeaderSize], payload.data(), payload.size());
+    writeHeader(bytes, payload.size());
+    return FramePtr(new Frame(std::move(bytes), type));
+}
+
+FramePtr Frame::fromBuffer(std::string bytes, MessageType type)
+{
+    writeHeader(bytes, bytes.size() - kHeaderSize);
+    return FramePtr(new Frame(std::move(bytes), type));
+}
+
+FramePtr Frame::batch(const FramePtr *frames, size_t count)
+{
+    size_t payloadBytes = 0;
+    bool allJSON = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        payloadBytes += frames[i]->size();
+        allJSON = allJSON && frames[i]->getFormat() == WireFormat::JSON;
+    }
+
+    std::string bytes(kHeaderSize, '\0');
+    bytes.reserve(kHeaderSize + payloadBytes + 32);
+    if (allJSON)
+    {
+        bytes += kJSONBatchPrefix;
+        bytes += "\"messages\":[";
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i > 0)
+            {
+                bytes.push_back(',');
+            }
+            std::string_view payload = frames[i]->payload();
+            bytes.append(payload.data(), payload.size());
+        }
+        bytes += "]}";
+    }
+    else
+    {
+        BinaryWriter writer(bytes);
+        writer.writeByte(kBinaryMagic);
+        writer.writeByte(static_cast<uint8_t>(MessageType::BATCH));
+        writer.writeVarUInt(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string_view payload = frames[i]->payload();
+            writer.writeVarUInt(payload.size());
+            writer.writeBytes(payload.data(), payload.size());
+        }
+    }
+    return fromBuffer(std::move(bytes), MessageType::BATCH);
+}
+
+bool Frame::isBatch(std::string_view payload)
+{
+    if (payload.size() >= 2 && static_cast<uint8_t>(payload[0]) == kBinaryMagic)
+    {
+        return static_cast<uint8_t>(payload[1]) == static_cast<uint8_t>(MessageType::BATCH);
+    }
+    return payload.substr(0, kJSONBatchPrefix.size()) == kJSONBatchPrefix;
+}
+
+bool Frame::unpackBatch(std::string_view payload, std::vector<std::string_view> &payloads)
+{
+    payloads.clear();
+    if (!isBatch(payload))
+    {
+        return false;
+    }
+
+    if (Message::detectFormat(payload) == WireFormat::BINARY)
+    {
+        BinaryReader reader(payload.data() + 2, payload.size() - 2);
+        uint64_t count = 0;
+        // 每条内嵌负载至少占两个字节，借此拒绝伪造的超大数量
+        if (!reader.readVarUInt(count) || count > reader.remaining() / 2)
+        {
+            return false;
+        }
+        payloads.reserve(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            std::string_view inner;
+            if (!reader.readString(inner) || inner.empty())
+            {
+                return false;
+            }
+            payloads.push_back(inner);
+        }
+        if (!reader.atEnd())
+        {
+            return false;
+        }
+    }
+    else
+    {
+        JsonReader reader(payload);
+        if (!reader.beginObject())
+        {
+            return false;
+        }
+        std::string_view key;
+        while (reader.nextKey(key))
+        {
+            bool ok = key == "messages" ? reader.readObjectArray(payloads) : reader.skipValue();
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        if (!reader.finished())
+        {
+            return false;
+        }
+    }
+
+    for (std::string_view inner : payloads)
+    {
+        if (isBatch(inner))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+FramePtr Frame::compress(const FramePtr &frame)
+{
+    if (frame->compressed_)
+    {
+        return frame;
+    }
+    std::call_once(frame->compressOnce_, [&frame]
+                   {
+        std::string payload = Compression::deflate(frame->payload());
+        if (payload.size() < frame->payload().size())
+        {
+            std::string bytes(kHeaderSize, '\0');
+            bytes += payload;
+            writeHeader(bytes, payload.size(), kCompressedFlag);
+            frame->compressedFrame_ = FramePtr(new Frame(std::move(bytes), frame->type_, true));
+        } });
+    return frame->compressedFrame_ ? frame->compressedFrame_ : frame;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Message.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Frame;
+using FramePtr = std::shared_ptr<const Frame>;
+
+// 预编码的帧：4字节网络序长度头 + 负载。创建后不可变，广播时在所有接收者之间共享。
+// 帧同时记下负载的消息类型，发送方按类型统计时无需再解析负载。
+// 长度头的最高位表示负载经过 zlib 压缩，其余 31 位为线路上的负载长度（消息上限 10MB，最高位原本总为 0）
+class Frame
+{
+public:
+    static constexpr size_t kHeaderSize = 4;
+    static constexpr uint32_t kCompressedFlag = 0x80000000u;
+    // 负载不超过该大小的帧才会被合并，大帧合并只会多一次复制
+    static constexpr size_t kMaxBatchedPayload = 4 * 1024;
+    // 单个批量帧的负载上限
+    static constexpr size_t kMaxBatchPayload = 64 * 1024;
+
+    static FramePtr create(const Message &message, WireFormat format);
+    static FramePtr fromPayload(std::string_view payload, MessageType type);
+    // bytes 的前 kHeaderSize 字节为预留的长度头，其后为已编码的负载，直接接管而不复制
+    static FramePtr fromBuffer(std::string bytes, MessageType type);
+
+    // 把多个帧的负载原样拼接为一个 BATCH 帧，不重新编码。全部为 JSON 时生成
+    // {"type":32,"messages":[消息,...]}，否则为 0xB1 BATCH 条数 (长度 负载)...，内嵌负载保持各自的格式
+    static FramePtr batch(const FramePtr *frames, size_t count);
+    static bool isBatch(std::string_view payload);
+    // 拆出内嵌消息的负载，视图指向 payload；格式错误或内嵌了 BATCH 时返回 false
+    static bool unpackBatch(std::string_view payload, std::vector<std::string_view> &payloads);
+
+    // 取帧的压缩形式：第一次调用时压缩并缓存在帧上，广播帧无论有多少接收者只压缩一次；
+    // 压缩后不能变小时返回原帧。压缩帧只用于写出，其 payload() 为压缩后的字节
+    static FramePtr compress(const FramePtr &frame);
+    bool isCompressed() const { return compressed_; }
+
+    // 含长度头的完整字节序列，可直接写入套接字
+    const char *data() const { return bytes_.data(); }
+    size_t size() const { return bytes_.size(); }
+
+    std::string_view payload() const { return std::string_view(bytes_).substr(kHeaderSize); }
+    WireFormat getFormat() const { return Message::detectFormat(payload()); }
+    MessageType getType() const { return type_; }
+
+private:
+    Frame(std::string bytes, MessageType type, bool compressed = false)
+        : bytes_(std::move(bytes)), type_(type), compressed_(compressed) {}
+
+    std::string bytes_;
+    MessageType type_;
+    bool compressed_;
+    mutable std::once_flag compressOnce_;
+    mutable FramePtr compressedFrame_; // 为空表示压缩后没有变小
+};
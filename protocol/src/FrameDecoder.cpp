@@ -0,0 +1,141 @@
+#include "FrameDecoder.h"
+#include "Compression.h"
+#include "Frame.h"
+#include <Poco/Exception.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // 每次读取前至少保留的空闲空间
+    constexpr size_t kMinReadSpace = 4 * 1024;
+    // 为大消息扩容过的缓冲区在读空后缩回初始大小，避免空闲连接长期占用内存
+    constexpr size_t kShrinkThreshold = 256 * 1024;
+    // 连续读满缓冲区说明内核中积压了更多数据，逐步加大单次读取量直到这个上限
+    constexpr size_t kMaxAdaptiveRead = 256 * 1024;
+
+    uint32_t readLength(const char *header)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(header);
+        return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+    }
+
+    uint32_t payloadLength(uint32_t header)
+    {
+        return header & ~Frame::kCompressedFlag;
+    }
+}
+
+FrameDecoder::FrameDecoder(size_t initialCapacity)
+    : initialCapacity_(std::max(initialCapacity, kMinReadSpace))
+{
+}
+
+FrameDecoder::ReadResult FrameDecoder::readFrom(Poco::Net::StreamSocket &socket)
+{
+    // 已知下一帧长度时一次把空间留够，大消息只扩容一次
+    size_t wanted = kMinReadSpace;
+    if (lastReadFilled_)
+    {
+        wanted = std::min(capacity_, kMaxAdaptiveRead);
+    }
+    if (buffered() >= kHeaderSize)
+    {
+        size_t frameSize = kHeaderSize + std::min(payloadLength(readLength(buffer_.get() + readPos_)), kMaxFrameLength);
+        if (frameSize > buffered())
+        {
+            wanted = std::max(wanted, frameSize - buffered());
+        }
+    }
+    reserve(wanted);
+
+    size_t space = capacity_ - writePos_;
+    int received = socket.receiveBytes(buffer_.get() + writePos_, static_cast<int>(space));
+    lastReadFilled_ = received > 0 && static_cast<size_t>(received) == space;
+    if (received > 0)
+    {
+        writePos_ += static_cast<size_t>(received);
+        return ReadResult::DATA;
+    }
+    return received == 0 ? ReadResult::CLOSED : ReadResult::WOULD_BLOCK;
+}
+
+void FrameDecoder::append(const char *data, size_t length)
+{
+    reserve(length);
+    std::memcpy(buffer_.get() + writePos_, data, length);
+    writePos_ += length;
+}
+
+bool FrameDecoder::nextFrame(std::string_view &payload)
+{
+    if (buffered() < kHeaderSize)
+    {
+        return false;
+    }
+
+    uint32_t header = readLength(buffer_.get() + readPos_);
+    uint32_t length = payloadLength(header);
+    if (length == 0)
+    {
+        throw Poco::DataFormatException("空消息");
+    }
+    if (length > kMaxFrameLength)
+    {
+        throw Poco::DataFormatException("消息过大: " + std::to_string(length) + " 字节");
+    }
+    if (buffered() - kHeaderSize < length)
+    {
+        return false;
+    }
+
+    payload = std::string_view(buffer_.get() + readPos_ + kHeaderSize, length);
+    readPos_ += kHeaderSize + length;
+    if (header & Frame::kCompressedFlag)
+    {
+        Compression::inflate(payload, kMaxFrameLength, inflated_);
+        payload = inflated_;
+    }
+    return true;
+}
+
+void FrameDecoder::reserve(size_t minSpace)
+{
+    if (readPos_ == writePos_)
+    {
+        readPos_ = writePos_ = 0;
+        if (capacity_ > kShrinkThreshold && minSpace <= initialCapacity_)
+        {
+            buffer_.reset();
+            capacity_ = 0;
+        }
+        if (inflated_.capacity() > kShrinkThreshold)
+        {
+            std::string().swap(inflated_);
+        }
+    }
+    if (capacity_ - writePos_ >= minSpace)
+    {
+        return;
+    }
+
+    size_t pending = buffered();
+    if (capacity_ - pending >= minSpace)
+    {
+        // 剩余的只是一个不完整帧，移动它的代价远小于重新分配
+        std::memmove(buffer_.get(), buffer_.get() + readPos_, pending);
+    }
+    else
+    {
+        size_t newCapacity = std::max({initialCapacity_, capacity_ * 2, pending + minSpace});
+        std::unique_ptr<char[]> grown(new char[newCapacity]);
+        if (pending > 0)
+        {
+            std::memcpy(grown.get(), buffer_.get() + readPos_, pending);
+        }
+        buffer_ = std::move(grown);
+        capacity_ = newCapacity;
+    }
+    readPos_ = 0;
+    writePos_ = pending;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Poco/Net/StreamSocket.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 帧解码器：每个连接一个可增长的接收缓冲区。每次尽量把内核中已有的数据一次读完，
+// 再逐个取出完整的 长度头+负载 帧，负载以视图形式交给解析器，不为单帧分配内存。
+// 长度头带压缩标志的帧先解压到内部缓冲区，交出的仍是原始负载。
+// 取出的视图在下一次 nextFrame()/readFrom()/append() 之前有效。
+class FrameDecoder
+{
+public:
+    static constexpr size_t kHeaderSize = 4;
+    static constexpr uint32_t kMaxFrameLength = 10 * 1024 * 1024; // 10MB上限
+
+    enum class ReadResult
+    {
+        DATA,
+        WOULD_BLOCK, // 非阻塞套接字上暂无数据
+        CLOSED       // 对端已关闭
+    };
+
+    explicit FrameDecoder(size_t initialCapacity = 8 * 1024);
+
+    // 一次 receiveBytes 读满缓冲区剩余空间；阻塞套接字上的接收超时会抛出 Poco::TimeoutException
+    ReadResult readFrom(Poco::Net::StreamSocket &socket);
+    void append(const char *data, size_t length);
+
+    // 取出下一个完整帧；数据不足时返回 false。长度为 0、超过上限或无法解压的帧抛出 Poco::DataFormatException
+    bool nextFrame(std::string_view &payload);
+
+    // 尚未取出的字节数，非零表示有不完整的帧
+    size_t buffered() const { return writePos_ - readPos_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    // 保证尾部至少有 minSpace 字节可写：先把未取出的数据移到开头，仍不够时再扩容
+    void reserve(size_t minSpace);
+
+    std::unique_ptr<char[]> buffer_;
+    size_t initialCapacity_;
+    size_t capacity_ = 0;
+    size_t readPos_ = 0;
+    size_t writePos_ = 0;
+    bool lastReadFilled_ = false;
+    std::string inflated_; // 最近一个压缩帧解压后的负载
+};
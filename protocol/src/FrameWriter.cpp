@@ -0,0 +1,227 @@
+#include "FrameWriter.h"
+#include <Poco/Net/NetException.h>
+#include <Poco/Exception.h>
+#include <algorithm>
+#include <cerrno>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <climits>
+#endif
+
+namespace
+{
+#if defined(_WIN32)
+    constexpr size_t kMaxIov = 64;
+#elif defined(IOV_MAX)
+    constexpr size_t kMaxIov = IOV_MAX < 256 ? IOV_MAX : 256;
+#else
+    constexpr size_t kMaxIov = 64;
+#endif
+}
+
+FrameWriter::FrameWriter(Poco::Net::StreamSocket &socket) : socket_(socket)
+{
+}
+
+void FrameWriter::configureSocket(Poco::Net::StreamSocket &socket)
+{
+    socket.setNoDelay(true);
+}
+
+void FrameWriter::enqueue(const FramePtr &frame)
+{
+    if (compressionThreshold_ > 0 && frame->payload().size() >= compressionThreshold_)
+    {
+        pending_.push_back(Frame::compress(frame));
+    }
+    else
+    {
+        pending_.push_back(frame);
+    }
+}
+
+void FrameWriter::enqueueBatched(const std::vector<FramePtr> &frames)
+{
+    size_t batchLimit = Frame::kMaxBatchedPayload;
+    if (compressionThreshold_ > 0)
+    {
+        batchLimit = std::min(batchLimit, compressionThreshold_ - 1);
+    }
+    size_t first = 0;
+    while (first < frames.size())
+    {
+        // 从 first 开始取尽量多的小帧，直到遇到大帧或批量帧达到上限
+        size_t last = first;
+        size_t payloadBytes = 0;
+        while (last < frames.size() && frames[last]->payload().size() <= batchLimit &&
+               payloadBytes + frames[last]->size() <= Frame::kMaxBatchPayload)
+        {
+            payloadBytes += frames[last]->size();
+            ++last;
+        }
+
+        if (last - first >= 2)
+        {
+            enqueue(Frame::batch(&frames[first], last - first));
+            first = last;
+        }
+        else
+        {
+            enqueue(frames[first]);
+            ++first;
+        }
+    }
+}
+
+FrameWriter::FlushResult FrameWriter::flush()
+{
+    // 一次装不下的批量数据会分成多次系统调用，期间用 TCP_CORK 让内核按满包发送
+    bool corked = pending_.size() > kMaxIov;
+    if (corked)
+    {
+        setCork(true);
+    }
+
+    FlushResult result = FlushResult::COMPLETE;
+    try
+    {
+        while (!pending_.empty())
+        {
+            long written = writeOnce();
+            if (written < 0)
+            {
+                if (socket_.getBlocking())
+                {
+                    // 阻塞套接字只有在发送超时后才会返回 EAGAIN
+                    throw Poco::TimeoutException("发送超时");
+                }
+                result = FlushResult::WOULD_BLOCK;
+                break;
+            }
+            consume(static_cast<size_t>(written));
+        }
+    }
+    catch (...)
+    {
+        if (corked)
+        {
+            setCork(false);
+        }
+        throw;
+    }
+
+    if (corked)
+    {
+        setCork(false);
+    }
+    return result;
+}
+
+long FrameWriter::writeOnce()
+{
+    size_t count = std::min(pending_.size(), kMaxIov);
+    ++syscalls_;
+
+#ifdef _WIN32
+    WSABUF buffers[kMaxIov];
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t skip = i == 0 ? offset_ : 0;
+        buffers[i].buf = const_cast<char *>(pending_[i]->data() + skip);
+        buffers[i].len = static_cast<ULONG>(pending_[i]->size() - skip);
+    }
+
+    DWORD sent = 0;
+    if (WSASend(socket_.impl()->sockfd(), buffers, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+    {
+        int error = WSAGetLastError();
+        if (error == WSAEWOULDBLOCK || error == WSAETIMEDOUT)
+        {
+            return -1;
+        }
+        if (error == WSAECONNRESET || error == WSAECONNABORTED)
+        {
+            throw Poco::Net::ConnectionResetException("WSASend", error);
+        }
+        throw Poco::Net::NetException("WSASend", error);
+    }
+    return static_cast<long>(sent);
+#else
+    iovec buffers[kMaxIov];
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t skip = i == 0 ? offset_ : 0;
+        buffers[i].iov_base = const_cast<char *>(pending_[i]->data() + skip);
+        buffers[i].iov_len = pending_[i]->size() - skip;
+    }
+
+    msghdr message{};
+    message.msg_iov = buffers;
+    message.msg_iovlen = count;
+
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL; // 对端已关闭时返回 EPIPE 而不是触发 SIGPIPE
+#endif
+
+    while (true)
+    {
+        ssize_t sent = ::sendmsg(socket_.impl()->sockfd(), &message, flags);
+        if (sent >= 0)
+        {
+            return static_cast<long>(sent);
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return -1;
+        }
+        if (errno == EPIPE || errno == ECONNRESET)
+        {
+            throw Poco::Net::ConnectionResetException("sendmsg", errno);
+        }
+        throw Poco::Net::NetException("sendmsg", errno);
+    }
+#endif
+}
+
+void FrameWriter::consume(size_t bytes)
+{
+    while (bytes > 0 && !pending_.empty())
+    {
+        size_t remaining = pending_.front()->size() - offset_;
+        if (bytes < remaining)
+        {
+            offset_ += bytes;
+            return;
+        }
+        bytes -= remaining;
+        pending_.pop_front();
+        offset_ = 0;
+        ++framesWritten_;
+    }
+}
+
+void FrameWriter::setCork(bool enabled)
+{
+#ifdef TCP_CORK
+    try
+    {
+        socket_.setOption(IPPROTO_TCP, TCP_CORK, enabled ? 1 : 0);
+    }
+    catch (const Poco::Exception &)
+    {
+        // 非 TCP 套接字不支持 TCP_CORK，忽略即可
+    }
+#else
+    (void)enabled;
+#endif
+}
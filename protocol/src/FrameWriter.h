@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Frame.h"
+#include <Poco/Net/StreamSocket.h>
+#include <cstdint>
+#include <deque>
+
+// 分散-聚集帧写入器：把同一套接字上所有待发送的帧合并为一次 writev/WSASend 系统调用。
+// 阻塞套接字上 flush() 会写完全部数据；非阻塞套接字上发送缓冲区满时返回 WOULD_BLOCK，
+// 已写出一部分的帧会在下次 flush() 时从断点继续。
+class FrameWriter
+{
+public:
+    enum class FlushResult
+    {
+        COMPLETE,
+        WOULD_BLOCK
+    };
+
+    explicit FrameWriter(Poco::Net::StreamSocket &socket);
+
+    // 显式关闭 Nagle 算法：帧总是整帧写出，不需要内核再攒包
+    static void configureSocket(Poco::Net::StreamSocket &socket);
+
+    // 负载不小于压缩阈值的帧以压缩形式入队，小帧直接跳过压缩器
+    void enqueue(const FramePtr &frame);
+    // 依次入队，连续的小帧合并为 BATCH 帧：少了每帧的长度头，接收方也只需取出一个帧。
+    // 达到压缩阈值的帧不参与合并，单独压缩，广播时各接收者共用同一份压缩结果；
+    // 合并后的 BATCH 帧达到压缩阈值时整体压缩，接收方先解压再拆开。只能用于协商过 BATCH 的对端
+    void enqueueBatched(const std::vector<FramePtr> &frames);
+    // 双方协商启用压缩后设置，0 表示不压缩
+    void setCompressionThreshold(size_t threshold) { compressionThreshold_ = threshold; }
+    FlushResult flush();
+    bool hasPending() const { return !pending_.empty(); }
+
+    uint64_t syscalls() const { return syscalls_; }
+    uint64_t framesWritten() const { return framesWritten_; }
+
+private:
+    // 一次系统调用，返回写出的字节数，发送缓冲区已满时返回 -1
+    long writeOnce();
+    void consume(size_t bytes);
+    void setCork(bool enabled);
+
+    Poco::Net::StreamSocket &socket_;
+    std::deque<FramePtr> pending_;
+    size_t offset_ = 0; // 队首帧已写出的字节数
+    size_t compressionThreshold_ = 0;
+    uint64_t syscalls_ = 0;
+    uint64_t framesWritten_ = 0;
+};
@@ -0,0 +1,38 @@
+#include "IdGenerator.h"
+#include <chrono>
+
+IdGenerator &IdGenerator::getInstance()
+{
+    static IdGenerator instance;
+    return instance;
+}
+
+void IdGenerator::setNodeId(uint16_t nodeId)
+{
+    nodeId_.store(nodeId & kMaxNodeId, std::memory_order_relaxed);
+}
+
+uint64_t IdGenerator::nowMs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+}
+
+uint64_t IdGenerator::next()
+{
+    uint64_t now = nowMs() - kEpochMs;
+    uint64_t current = state_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do
+    {
+        // 状态字整体递增即可：序号溢出时自然进位到毫秒部分
+        uint64_t fresh = now << kSequenceBits;
+        next = fresh > current ? fresh : current + 1;
+    } while (!state_.compare_exchange_weak(current, next, std::memory_order_relaxed));
+
+    uint64_t timestamp = next >> kSequenceBits;
+    uint64_t sequence = next & ((1u << kSequenceBits) - 1);
+    return (timestamp << (kNodeBits + kSequenceBits)) |
+           (static_cast<uint64_t>(getNodeId()) << kSequenceBits) | sequence;
+}
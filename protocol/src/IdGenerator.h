@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// 64位消息ID：1位保留 | 41位毫秒时间戳（自 kEpochMs 起，约69年）| 10位节点ID | 12位序号。
+// 同一节点内严格递增：状态字 (毫秒, 序号) 通过 CAS 无锁推进，
+// 同一毫秒内序号用尽或时钟回拨时借用下一毫秒，不会阻塞等待。
+class IdGenerator
+{
+public:
+    static constexpr uint64_t kEpochMs = 1704067200000ULL; // 2024-01-01T00:00:00Z
+    static constexpr int kNodeBits = 10;
+    static constexpr int kSequenceBits = 12;
+    static constexpr uint16_t kMaxNodeId = (1u << kNodeBits) - 1;
+
+    static IdGenerator &getInstance();
+
+    void setNodeId(uint16_t nodeId);
+    uint16_t getNodeId() const { return nodeId_.load(std::memory_order_relaxed); }
+
+    uint64_t next();
+
+    // 从ID中还原生成时的 Unix 毫秒时间戳和节点ID
+    static uint64_t timestampOf(uint64_t id) { return (id >> (kNodeBits + kSequenceBits)) + kEpochMs; }
+    static uint16_t nodeOf(uint64_t id) { return static_cast<uint16_t>((id >> kSequenceBits) & kMaxNodeId); }
+
+    static uint64_t nowMs();
+
+private:
+    IdGenerator() = default;
+    IdGenerator(const IdGenerator &) = delete;
+    IdGenerator &operator=(const IdGenerator &) = delete;
+
+    std::atomic<uint16_t> nodeId_{0};
+    std::atomic<uint64_t> state_{0}; // 最近一次分配的 (毫秒 << kSequenceBits) | 序号
+};
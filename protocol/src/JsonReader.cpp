@@ -0,0 +1,574 @@
+#include "JsonReader.h"
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    bool readHex4(const char *&p, const char *end, uint32_t &value)
+    {
+        if (end - p < 4)
+        {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            int digit = hexValue(*p++);
+            if (digit < 0)
+            {
+                return false;
+            }
+            value = (value << 4) | static_cast<uint32_t>(digit);
+        }
+        return true;
+    }
+
+    void appendUtf8(std::string &out, uint32_t cp)
+    {
+        if (cp < 0x80)
+        {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+}
+
+void JsonReader::skipWhitespace()
+{
+    while (pos_ < input_.size() && isWhitespace(input_[pos_]))
+    {
+        ++pos_;
+    }
+}
+
+bool JsonReader::expect(char c)
+{
+    skipWhitespace();
+    if (pos_ >= input_.size() || input_[pos_] != c)
+    {
+        return fail();
+    }
+    ++pos_;
+    return true;
+}
+
+bool JsonReader::beginObject()
+{
+    firstKey_ = true;
+    closed_ = false;
+    return ok_ && expect('{');
+}
+
+bool JsonReader::nextKey(std::string_view &key)
+{
+    if (!ok_ || closed_)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == '}')
+    {
+        ++pos_;
+        closed_ = true;
+        return false;
+    }
+
+    // 逗号之后必须紧跟下一个键，{"a":1,} 会在 scanString 处失败
+    if (!firstKey_ && !expect(','))
+    {
+        return false;
+    }
+    firstKey_ = false;
+
+    skipWhitespace();
+    return scanString(key) && expect(':');
+}
+
+bool JsonReader::scanString(std::string_view &raw)
+{
+    if (pos_ >= input_.size() || input_[pos_] != '"')
+    {
+        return fail();
+    }
+
+    size_t start = ++pos_;
+    while (pos_ < input_.size())
+    {
+        char c = input_[pos_];
+        if (c == '"')
+        {
+            raw = input_.substr(start, pos_ - start);
+            ++pos_;
+            return true;
+        }
+        pos_ += (c == '\\') ? 2 : 1;
+    }
+    return fail();
+}
+
+bool JsonReader::appendCodePoint(std::string &out, const char *&p, const char *end)
+{
+    uint32_t cp = 0;
+    if (!readHex4(p, end, cp))
+    {
+        return false;
+    }
+
+    // UTF-16 代理对
+    if (cp >= 0xD800 && cp <= 0xDBFF)
+    {
+        uint32_t low = 0;
+        if (end - p < 6 || p[0] != '\\' || p[1] != 'u')
+        {
+            return false;
+        }
+        p += 2;
+        if (!readHex4(p, end, low) || low < 0xDC00 || low > 0xDFFF)
+        {
+            return false;
+        }
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    }
+    else if (cp >= 0xDC00 && cp <= 0xDFFF)
+    {
+        return false;
+    }
+
+    appendUtf8(out, cp);
+    return true;
+}
+
+bool JsonReader::readString(std::string &value)
+{
+    skipWhitespace();
+    std::string_view raw;
+    if (!scanString(raw))
+    {
+        return false;
+    }
+
+    // 绝大多数字符串不含转义，直接整体复制
+    if (std::memchr(raw.data(), '\\', raw.size()) == nullptr)
+    {
+        value.assign(raw.data(), raw.size());
+        return true;
+    }
+
+    value.clear();
+    value.reserve(raw.size());
+    const char *p = raw.data();
+    const char *end = p + raw.size();
+    while (p < end)
+    {
+        char c = *p++;
+        if (c != '\\')
+        {
+            value.push_back(c);
+            continue;
+        }
+        if (p == end)
+        {
+            return fail();
+        }
+        switch (*p++)
+        {
+        case '"':
+            value.push_back('"');
+            break;
+        case '\\':
+            value.push_back('\\');
+            break;
+        case '/':
+            value.push_back('/');
+            break;
+        case 'b':
+            value.push_back('\b');
+            break;
+        case 'f':
+            value.push_back('\f');
+            break;
+        case 'n':
+            value.push_back('\n');
+            break;
+        case 'r':
+            value.push_back('\r');
+            break;
+        case 't':
+            value.push_back('\t');
+            break;
+        case 'u':
+            if (!appendCodePoint(value, p, end))
+            {
+                return fail();
+            }
+            break;
+        default:
+            return fail();
+        }
+    }
+    return true;
+}
+
+bool JsonReader::readRawString(std::string_view &raw)
+{
+    skipWhitespace();
+    size_t start = pos_;
+    std::string_view contents;
+    if (!scanString(contents))
+    {
+        return false;
+    }
+
+    // 不含转义时无需解码；含转义时完整解码一遍校验，结果丢弃
+    std::string_view quoted = input_.substr(start, pos_ - start);
+    if (std::memchr(contents.data(), '\\', contents.size()) != nullptr)
+    {
+        JsonReader check(quoted);
+        std::string scratch;
+        if (!check.readString(scratch))
+        {
+            return fail();
+        }
+    }
+    raw = quoted;
+    return true;
+}
+
+bool JsonReader::readInt(int64_t &value)
+{
+    skipWhitespace();
+    bool negative = pos_ < input_.size() && input_[pos_] == '-';
+    size_t start = pos_;
+    if (negative)
+    {
+        ++pos_;
+    }
+
+    uint64_t magnitude = 0;
+    size_t digits = 0;
+    while (pos_ < input_.size() && input_[pos_] >= '0' && input_[pos_] <= '9')
+    {
+        uint64_t digit = static_cast<uint64_t>(input_[pos_] - '0');
+        if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+        {
+            return fail();
+        }
+        magnitude = magnitude * 10 + digit;
+        ++pos_;
+        ++digits;
+    }
+    if (digits == 0)
+    {
+        return fail();
+    }
+
+    // 带小数或指数的数字按浮点解析后截断，与 Poco 的数值转换保持一致
+    if (pos_ < input_.size() && (input_[pos_] == '.' || input_[pos_] == 'e' || input_[pos_] == 'E'))
+    {
+        pos_ = start;
+        if (!skipNumber())
+        {
+            return false;
+        }
+        std::string text(input_.substr(start, pos_ - start));
+        value = static_cast<int64_t>(std::strtod(text.c_str(), nullptr));
+        return true;
+    }
+
+    if (negative)
+    {
+        if (magnitude > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1)
+        {
+            return fail();
+        }
+        value = static_cast<int64_t>(~magnitude + 1);
+    }
+    else
+    {
+        if (magnitude > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+        {
+            return fail();
+        }
+        value = static_cast<int64_t>(magnitude);
+    }
+    return true;
+}
+
+bool JsonReader::readUInt(uint64_t &value)
+{
+    skipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == '-')
+    {
+        return fail();
+    }
+
+    size_t start = pos_;
+    value = 0;
+    while (pos_ < input_.size() && input_[pos_] >= '0' && input_[pos_] <= '9')
+    {
+        uint64_t digit = static_cast<uint64_t>(input_[pos_] - '0');
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+        {
+            return fail();
+        }
+        value = value * 10 + digit;
+        ++pos_;
+    }
+    if (pos_ == start)
+    {
+        return fail();
+    }
+
+    if (pos_ < input_.size() && (input_[pos_] == '.' || input_[pos_] == 'e' || input_[pos_] == 'E'))
+    {
+        pos_ = start;
+        if (!skipNumber())
+        {
+            return false;
+        }
+        std::string text(input_.substr(start, pos_ - start));
+        value = static_cast<uint64_t>(std::strtod(text.c_str(), nullptr));
+    }
+    return true;
+}
+
+bool JsonReader::readStringArray(std::vector<std::string> &values)
+{
+    values.clear();
+    if (!expect('['))
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == ']')
+    {
+        ++pos_;
+        return true;
+    }
+
+    while (true)
+    {
+        std::string value;
+        if (!readString(value))
+        {
+            return false;
+        }
+        values.push_back(std::move(value));
+
+        skipWhitespace();
+        if (pos_ >= input_.size())
+        {
+            return fail();
+        }
+        char c = input_[pos_++];
+        if (c == ']')
+        {
+            return true;
+        }
+        if (c != ',')
+        {
+            return fail();
+        }
+    }
+}
+
+bool JsonReader::readObjectArray(std::vector<std::string_view> &objects)
+{
+    objects.clear();
+    if (!expect('['))
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == ']')
+    {
+        ++pos_;
+        return true;
+    }
+
+    while (true)
+    {
+        skipWhitespace();
+        if (pos_ >= input_.size() || input_[pos_] != '{')
+        {
+            return fail();
+        }
+        size_t start = pos_;
+        if (!skipContainer('{', '}'))
+        {
+            return false;
+        }
+        objects.push_back(input_.substr(start, pos_ - start));
+
+        skipWhitespace();
+        if (pos_ >= input_.size())
+        {
+            return fail();
+        }
+        char c = input_[pos_++];
+        if (c == ']')
+        {
+            return true;
+        }
+        if (c != ',')
+        {
+            return fail();
+        }
+    }
+}
+
+bool JsonReader::skipNumber()
+{
+    size_t start = pos_;
+    if (pos_ < input_.size() && input_[pos_] == '-')
+    {
+        ++pos_;
+    }
+    while (pos_ < input_.size())
+    {
+        char c = input_[pos_];
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+        {
+            ++pos_;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return pos_ > start ? true : fail();
+}
+
+bool JsonReader::skipLiteral(std::string_view literal)
+{
+    if (input_.substr(pos_, literal.size()) != literal)
+    {
+        return fail();
+    }
+    pos_ += literal.size();
+    return true;
+}
+
+bool JsonReader::skipContainer(char open, char close)
+{
+    int depth = 0;
+    while (pos_ < input_.size())
+    {
+        char c = input_[pos_];
+        if (c == '"')
+        {
+            std::string_view ignored;
+            if (!scanString(ignored))
+            {
+                return false;
+            }
+            continue;
+        }
+        ++pos_;
+        if (c == open)
+        {
+            ++depth;
+        }
+        else if (c == close && --depth == 0)
+        {
+            return true;
+        }
+    }
+    return fail();
+}
+
+bool JsonReader::skipValue(std::string_view *raw)
+{
+    skipWhitespace();
+    if (pos_ >= input_.size())
+    {
+        return fail();
+    }
+
+    size_t start = pos_;
+    bool skipped = false;
+    std::string_view ignored;
+    switch (input_[pos_])
+    {
+    case '"':
+        skipped = scanString(ignored);
+        break;
+    case '{':
+        skipped = skipContainer('{', '}');
+        break;
+    case '[':
+        skipped = skipContainer('[', ']');
+        break;
+    case 't':
+        skipped = skipLiteral("true");
+        break;
+    case 'f':
+        skipped = skipLiteral("false");
+        break;
+    case 'n':
+        skipped = skipLiteral("null");
+        break;
+    default:
+        skipped = skipNumber();
+        break;
+    }
+
+    if (skipped && raw)
+    {
+        *raw = input_.substr(start, pos_ - start);
+    }
+    return skipped;
+}
+
+bool JsonReader::finished() const
+{
+    if (!ok_ || !closed_)
+    {
+        return false;
+    }
+    for (size_t i = pos_; i < input_.size(); ++i)
+    {
+        if (!isWhitespace(input_[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 流式 JSON 读取器：直接在输入缓冲区上按顺序读取对象的键值，不构建 DOM。
+// 只支持消息协议需要的子集：顶层对象、字符串、整数、字符串数组以及对象数组，其余值可被跳过。
+class JsonReader
+{
+public:
+    explicit JsonReader(std::string_view input) : input_(input) {}
+
+    // 读取对象起始的 '{'
+    bool beginObject();
+    // 读取下一个键，遇到 '}' 或出错时返回 false；键以原始形式返回（不处理转义）
+    bool nextKey(std::string_view &key);
+
+    bool readString(std::string &value);
+    // 读取字符串但不解码，raw 为带引号的原样字节；含转义时会校验其合法性
+    bool readRawString(std::string_view &raw);
+    bool readInt(int64_t &value);
+    bool readUInt(uint64_t &value);
+    bool readStringArray(std::vector<std::string> &values);
+    // 读取对象数组，返回每个对象的原始字节范围，由调用方再逐个解析
+    bool readObjectArray(std::vector<std::string_view> &objects);
+    // 跳过任意一个 JSON 值，并返回其原始字节范围
+    bool skipValue(std::string_view *raw = nullptr);
+
+    // 对象已结束且之后只剩空白
+    bool finished() const;
+    bool ok() const { return ok_; }
+
+private:
+    bool fail()
+    {
+        ok_ = false;
+        return false;
+    }
+
+    void skipWhitespace();
+    bool expect(char c);
+    bool scanString(std::string_view &raw);
+    bool skipNumber();
+    bool skipLiteral(std::string_view literal);
+    bool skipContainer(char open, char close);
+    bool appendCodePoint(std::string &out, const char *&p, const char *end);
+
+    std::string_view input_;
+    size_t pos_ = 0;
+    bool firstKey_ = true;
+    bool closed_ = false;
+    bool ok_ = true;
+};
@@ -1,55 +1,35 @@
 #include "Message.h"
-#include <chrono>
-#include <random>
+#include "BinaryCodec.h"
+#include "IdGenerator.h"
+#include "JsonReader.h"
 #include <Poco/JSON/Parser.h>
 #include <Poco/JSON/Stringifier.h>
 #include <Poco/Dynamic/Var.h>
 #include <sstream>
 
-struct IDTimestamp
+// Message基类实现
+Message::Message(MessageType type) : type_(type), id_(0), timestamp_(0)
 {
-    uint32_t id;
-    uint64_t timestamp_sec;
-};
+}
 
-class IDGenerator
+void Message::ensureStamped() const
 {
-public:
-    static IDTimestamp generate()
-    {
-        static thread_local std::random_device rd;
-        static thread_local std::mt19937 gen(rd());
-        static thread_local std::uniform_int_distribution<uint32_t> dis(1, UINT32_MAX);
-
-        // 获取当前时间戳
-        auto now_sec = std::chrono::duration_cast<std::chrono::seconds>(
-                           std::chrono::system_clock::now().time_since_epoch())
-                           .count();
-
-        // 生成ID：时间戳(24位) + 随机数(8位)
-        uint32_t timestamp_part = (static_cast<uint32_t>(now_sec) & 0xFFFFFF) << 8;
-        uint32_t random_part = dis(gen) & 0xFF;
-        uint32_t id = timestamp_part | random_part;
-
-        return {id, static_cast<uint64_t>(now_sec)};
-    }
-
-    static uint32_t generateID()
+    if (id_ == 0)
     {
-        return generate().id;
+        id_ = IdGenerator::getInstance().next();
+        timestamp_ = IdGenerator::timestampOf(id_);
     }
-};
+}
 
-// Message基类实现
-Message::Message(MessageType type) : type_(type)
+void Message::stamp()
 {
-    auto [id, timestamp] = IDGenerator::generate();
-    id_ = id;
-    timestamp_ = timestamp;
+    id_ = 0;
+    ensureStamped();
 }
 
 Poco::JSON::Object::Ptr Message::toJSON() const
 {
+    ensureStamped();
     Poco::JSON::Object::Ptr json = new Poco::JSON::Object();
     json->set("type", static_cast<int>(type_));
     json->set("id", id_);
@@ -62,7 +42,7 @@ bool Message::fromJSON(const Poco::JSON::Object::Ptr &json)
     try
     {
         type_ = static_cast<MessageType>(json->getValue<int>("type"));
-        id_ = json->getValue<uint32_t>("id");
+        id_ = json->getValue<uint64_t>("id");
         timestamp_ = json->getValue<uint64_t>("timestamp");
         return true;
     }
@@ -72,6 +52,68 @@ bool Message::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
+void Message::encodeBinary(BinaryWriter &writer) const
+{
+    ensureStamped();
+    writer.writeByte(static_cast<uint8_t>(type_));
+    writer.writeVarUInt(id_);
+    writer.writeVarUInt(timestamp_);
+}
+
+bool Message::decodeBinary(BinaryReader &reader)
+{
+    uint8_t type = 0;
+    if (!reader.readByte(type) || !reader.readVarUInt(id_) || !reader.readVarUInt(timestamp_))
+    {
+        return false;
+    }
+    type_ = static_cast<MessageType>(type);
+    return true;
+}
+
+bool Message::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "type")
+    {
+        // 具体类型已按第一个 "type" 构造，重复的 "type" 只能与之相同，否则会被当作另一种消息处理
+        int64_t type = 0;
+        return reader.readInt(type) && type == static_cast<int64_t>(type_);
+    }
+    if (key == "id")
+    {
+        return reader.readUInt(id_);
+    }
+    if (key == "timestamp")
+    {
+        return reader.readUInt(timestamp_);
+    }
+    return reader.skipValue();
+}
+
+std::string Message::serializeBinary() const
+{
+    std::string data;
+    BinaryWriter writer(data);
+    writer.writeByte(kBinaryMagic);
+    encodeBinary(writer);
+    encodeBinaryTrailer(writer);
+    return data;
+}
+
+std::string Message::encode(WireFormat format) const
+{
+    return format == WireFormat::BINARY ? serializeBinary() : serialize();
+}
+
+WireFormat Message::detectFormat(std::string_view data)
+{
+    if (!data.empty() && static_cast<uint8_t>(data[0]) == kBinaryMagic)
+    {
+        return WireFormat::BINARY;
+    }
+    return WireFormat::JSON;
+}
+
 // RegisterRequest实现
 RegisterRequest::RegisterRequest() : Message(MessageType::REGISTER_REQUEST), username_(""), password_("")
 {
@@ -132,6 +174,31 @@ bool RegisterRequest::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
+void RegisterRequest::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeString(username_);
+    writer.writeString(password_);
+}
+
+bool RegisterRequest::decodeBinary(BinaryReader &reader)
+{
+    return Message::decodeBinary(reader) && reader.readString(username_) && reader.readString(password_);
+}
+
+bool RegisterRequest::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "username")
+    {
+        return reader.readString(username_);
+    }
+    if (key == "password")
+    {
+        return reader.readString(password_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
 // RegisterResponse实现
 RegisterResponse::RegisterResponse() : Message(MessageType::REGISTER_RESPONSE), status_(MessageStatus::SUCCESS), message_("注册成功")
 {
@@ -192,6 +259,43 @@ bool RegisterResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
+void RegisterResponse::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeByte(static_cast<uint8_t>(status_));
+    writer.writeString(message_);
+}
+
+bool RegisterResponse::decodeBinary(BinaryReader &reader)
+{
+    uint8_t status = 0;
+    if (!Message::decodeBinary(reader) || !reader.readByte(status))
+    {
+        return false;
+    }
+    status_ = static_cast<MessageStatus>(status);
+    return reader.readString(message_);
+}
+
+bool RegisterResponse::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "status")
+    {
+        int64_t value = 0;
+        if (!reader.readInt(value))
+        {
+            return false;
+        }
+        status_ = static_cast<MessageStatus>(value);
+        return true;
+    }
+    if (key == "message")
+    {
+        return reader.readString(message_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
 // LoginRequest实现
 LoginRequest::LoginRequest() : Message(MessageType::LOGIN_REQUEST), account_(""), password_("")
 {
@@ -252,6 +356,31 @@ bool LoginRequest::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
+void LoginRequest::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeString(account_);
+    writer.writeString(password_);
+}
+
+bool LoginRequest::decodeBinary(BinaryReader &reader)
+{
+    return Message::decodeBinary(reader) && reader.readString(account_) && reader.readString(password_);
+}
+
+bool LoginRequest::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "account")
+    {
+        return reader.readString(account_);
+    }
+    if (key == "password")
+    {
+        return reader.readString(password_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
 // LoginResponse实现
 LoginResponse::LoginResponse() : Message(MessageType::LOGIN_RESPONSE), status_(MessageStatus::SUCCESS), message_("登录成功")
 {
@@ -292,6 +421,10 @@ Poco::JSON::Object::Ptr LoginResponse::toJSON() const
     json->set("status", static_cast<int>(status_));
     json->set("username", username_);
     json->set("message", message_);
+    if (capabilities_ != 0)
+    {
+        json->set("capabilities", capabilities_);
+    }
     return json;
 }
 
@@ -308,6 +441,7 @@ bool LoginResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
         status_ = static_cast<MessageStatus>(json->getValue<int>("status"));
         username_ = json->getValue<std::string>("username");
         message_ = json->getValue<std::string>("message");
+        capabilities_ = json->has("capabilities") ? json->getValue<uint32_t>("capabilities") : 0;
         return true;
     }
     catch (const std::exception &)
@@ -316,18 +450,100 @@ bool LoginResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
+void LoginResponse::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeByte(static_cast<uint8_t>(status_));
+    writer.writeString(account_);
+    writer.writeString(username_);
+    writer.writeString(message_);
+}
+
+bool LoginResponse::decodeBinary(BinaryReader &reader)
+{
+    uint8_t status = 0;
+    if (!Message::decodeBinary(reader) || !reader.readByte(status))
+    {
+        return false;
+    }
+    status_ = static_cast<MessageStatus>(status);
+    return reader.readString(account_) && reader.readString(username_) && reader.readString(message_);
+}
+
+void LoginResponse::encodeBinaryTrailer(BinaryWriter &writer) const
+{
+    // 不声明能力的响应保持原来的编码
+    if (capabilities_ != 0)
+    {
+        writer.writeVarUInt(capabilities_);
+    }
+}
+
+bool LoginResponse::decodeBinaryTrailer(BinaryReader &reader)
+{
+    uint64_t capabilities = 0;
+    if (!reader.atEnd() && !reader.readVarUInt(capabilities))
+    {
+        return false;
+    }
+    capabilities_ = static_cast<uint32_t>(capabilities);
+    return true;
+}
+
+bool LoginResponse::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "account")
+    {
+        return reader.readString(account_);
+    }
+    if (key == "status")
+    {
+        int64_t value = 0;
+        if (!reader.readInt(value))
+        {
+            return false;
+        }
+        status_ = static_cast<MessageStatus>(value);
+        return true;
+    }
+    if (key == "username")
+    {
+        return reader.readString(username_);
+    }
+    if (key == "message")
+    {
+        return reader.readString(message_);
+    }
+    if (key == "capabilities")
+    {
+        uint64_t capabilities = 0;
+        if (!reader.readUInt(capabilities))
+        {
+            return false;
+        }
+        capabilities_ = static_cast<uint32_t>(capabilities);
+        return true;
+    }
+    return Message::readJSONField(key, reader);
+}
+
 // ChatMessage实现
-ChatMessage::ChatMessage() : Message(MessageType::BROADCAST_MESSAGE), sender_(""), sender_username_(""), receiver_(""), content_("")
+ChatMessage::ChatMessage() : Message(MessageType::BROADCAST_MESSAGE), sender_(""), sender_username_(""), receiver_(""), content_(""), seq_(0)
 {
 }
 
 ChatMessage::ChatMessage(const std::string &sender, const std::string &sender_username, const std::string &content)
-    : Message(MessageType::BROADCAST_MESSAGE), sender_(sender), sender_username_(sender_username), receiver_(""), content_(content)
+    : Message(MessageType::BROADCAST_MESSAGE), sender_(sender), sender_username_(sender_username), receiver_(""), content_(content), seq_(0)
 {
 }
 
 ChatMessage::ChatMessage(const std::string &sender, const std::string &sender_username, const std::string &receiver, const std::string &content)
-    : Message(MessageType::PRIVATE_MESSAGE), sender_(sender), sender_username_(sender_username), receiver_(receiver), content_(content)
+    : Message(MessageType::PRIVATE_MESSAGE), sender_(sender), sender_username_(sender_username), receiver_(receiver), content_(content), seq_(0)
+{
+}
+
+ChatMessage::ChatMessage(MessageType type, const std::string &sender, const std::string &sender_username, const std::string &receiver, const std::string &content)
+    : Message(type), sender_(sender), sender_username_(sender_username), receiver_(receiver), content_(content), seq_(0)
 {
 }
 
@@ -364,6 +580,14 @@ Poco::JSON::Object::Ptr ChatMessage::toJSON() const
     {
         json->set("receiver", receiver_);
     }
+    if (seq_ != 0)
+    {
+        json->set("seq", seq_);
+    }
+    if (retransmit_)
+    {
+        json->set("retransmit", 1);
+    }
     return json;
 }
 
@@ -389,6 +613,8 @@ bool ChatMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
         {
             receiver_.clear();
         }
+        seq_ = json->has("seq") ? json->getValue<uint64_t>("seq") : 0;
+        retransmit_ = json->has("retransmit") && json->getValue<int>("retransmit") != 0;
 
         return true;
     }
@@ -398,80 +624,88 @@ bool ChatMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
-// UserListResponse实现
-UserListResponse::UserListResponse() : Message(MessageType::USER_LIST_RESPONSE)
+void ChatMessage::encodeBinary(BinaryWriter &writer) const
 {
+    Message::encodeBinary(writer);
+    writer.writeString(sender_);
+    writer.writeString(sender_username_);
+    writer.writeString(receiver_);
+    writer.writeString(content_);
+    writer.writeVarUInt(seq_);
 }
 
-std::string UserListResponse::serialize() const
+bool ChatMessage::decodeBinary(BinaryReader &reader)
 {
-    auto json = toJSON();
-    std::ostringstream oss;
-    Poco::JSON::Stringifier::stringify(json, oss);
-    return oss.str();
+    return Message::decodeBinary(reader) && reader.readString(sender_) && reader.readString(sender_username_) &&
+           reader.readString(receiver_) && reader.readString(content_) && reader.readVarUInt(seq_);
 }
 
-bool UserListResponse::deserialize(const std::string &data)
+void ChatMessage::encodeBinaryTrailer(BinaryWriter &writer) const
 {
-    try
-    {
-        Poco::JSON::Parser parser;
-        Poco::Dynamic::Var result = parser.parse(data);
-        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
-        return fromJSON(json);
-    }
-    catch (const std::exception &)
+    // 不带标志的消息保持原来的编码
+    if (retransmit_)
     {
-        return false;
+        writer.writeVarUInt(kChatFlagRetransmit);
     }
 }
 
-Poco::JSON::Object::Ptr UserListResponse::toJSON() const
+bool ChatMessage::decodeBinaryTrailer(BinaryReader &reader)
 {
-    auto json = Message::toJSON();
-    Poco::JSON::Array::Ptr usersArray = new Poco::JSON::Array;
-    for (const auto &user : users_)
+    uint64_t flags = 0;
+    if (!reader.atEnd() && !reader.readVarUInt(flags))
     {
-        usersArray->add(user);
+        return false;
     }
-    json->set("users", usersArray);
-    return json;
+    retransmit_ = (flags & kChatFlagRetransmit) != 0;
+    return true;
 }
 
-bool UserListResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
+bool ChatMessage::readJSONField(std::string_view key, JsonReader &reader)
 {
-    if (!Message::fromJSON(json))
+    if (key == "sender")
     {
-        return false;
+        return reader.readString(sender_);
     }
-
-    try
+    if (key == "sender_username")
     {
-        Poco::JSON::Array::Ptr usersArray = json->getArray("users");
-        users_.clear();
-        for (size_t i = 0; i < usersArray->size(); ++i)
+        return reader.readString(sender_username_);
+    }
+    if (key == "content")
+    {
+        return reader.readString(content_);
+    }
+    if (key == "receiver")
+    {
+        return reader.readString(receiver_);
+    }
+    if (key == "seq")
+    {
+        return reader.readUInt(seq_);
+    }
+    if (key == "retransmit")
+    {
+        uint64_t retransmit = 0;
+        if (!reader.readUInt(retransmit))
         {
-            users_.push_back(usersArray->getElement<std::string>(i));
+            return false;
         }
+        retransmit_ = retransmit != 0;
         return true;
     }
-    catch (const std::exception &)
-    {
-        return false;
-    }
+    return Message::readJSONField(key, reader);
 }
 
-// UserStatusUpdate实现
-UserStatusUpdate::UserStatusUpdate() : Message(MessageType::USER_STATUS_UPDATE), action_("")
+// HistoryRequest实现
+HistoryRequest::HistoryRequest() : Message(MessageType::HISTORY_REQUEST), target_(""), limit_(20), beforeId_(0)
 {
 }
 
-UserStatusUpdate::UserStatusUpdate(const std::string &action)
-    : Message(MessageType::USER_STATUS_UPDATE), action_(action)
+HistoryRequest::HistoryRequest(const std::string &target, uint32_t limit, uint64_t beforeId)
+    : Message(MessageType::HISTORY_REQUEST), target_(target), limit_(limit), beforeId_(beforeId)
 {
 }
 
-std::string UserStatusUpdate::serialize() const
+std::string HistoryRequest::serialize() const
 {
     auto json = toJSON();
     std::ostringstream oss;
@@ -479,7 +713,7 @@ std::string UserStatusUpdate::serialize() const
     return oss.str();
 }
 
-bool UserStatusUpdate::deserialize(const std::string &data)
+bool HistoryRequest::deserialize(const std::string &data)
 {
     try
     {
@@ -494,14 +728,19 @@ bool UserStatusUpdate::deserialize(const std::string &data)
     }
 }
 
-Poco::JSON::Object::Ptr UserStatusUpdate::toJSON() const
+Poco::JSON::Object::Ptr HistoryRequest::toJSON() const
 {
     auto json = Message::toJSON();
-    json->set("action", action_);
+    json->set("target", target_);
+    json->set("limit", limit_);
+    if (beforeId_ != 0)
+    {
+        json->set("before_id", beforeId_);
+    }
     return json;
 }
 
-bool UserStatusUpdate::fromJSON(const Poco::JSON::Object::Ptr &json)
+bool HistoryRequest::fromJSON(const Poco::JSON::Object::Ptr &json)
 {
     if (!Message::fromJSON(json))
     {
@@ -510,7 +749,9 @@ bool UserStatusUpdate::fromJSON(const Poco::JSON::Object::Ptr &json)
 
     try
     {
-        action_ = json->getValue<std::string>("action");
+        target_ = json->getValue<std::string>("target");
+        limit_ = json->getValue<uint32_t>("limit");
+        beforeId_ = json->has("before_id") ? json->getValue<uint64_t>("before_id") : 0;
         return true;
     }
     catch (const std::exception &)
@@ -519,17 +760,59 @@ bool UserStatusUpdate::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
-// ErrorMessage实现
-ErrorMessage::ErrorMessage() : Message(MessageType::ERROR_MESSAGE), error_code_(0), error_message_("")
+void HistoryRequest::encodeBinary(BinaryWriter &writer) const
 {
+    Message::encodeBinary(writer);
+    writer.writeString(target_);
+    writer.writeVarUInt(limit_);
+    writer.writeVarUInt(beforeId_);
 }
 
-ErrorMessage::ErrorMessage(int error_code, const std::string &error_message)
-    : Message(MessageType::ERROR_MESSAGE), error_code_(error_code), error_message_(error_message)
+bool HistoryRequest::decodeBinary(BinaryReader &reader)
 {
+    uint64_t limit = 0;
+    if (!Message::decodeBinary(reader) || !reader.readString(target_) || !reader.readVarUInt(limit) || limit > UINT32_MAX)
+    {
+        return false;
+    }
+    limit_ = static_cast<uint32_t>(limit);
+    return reader.readVarUInt(beforeId_);
 }
 
-std::string ErrorMessage::serialize() const
+bool HistoryRequest::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "target")
+    {
+        return reader.readString(target_);
+    }
+    if (key == "limit")
+    {
+        uint64_t value = 0;
+        if (!reader.readUInt(value) || value > UINT32_MAX)
+        {
+            return false;
+        }
+        limit_ = static_cast<uint32_t>(value);
+        return true;
+    }
+    if (key == "before_id")
+    {
+        return reader.readUInt(beforeId_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// HistoryResponse实现
+HistoryResponse::HistoryResponse() : Message(MessageType::HISTORY_RESPONSE), status_(MessageStatus::SUCCESS), target_(""), hasMore_(false)
+{
+}
+
+HistoryResponse::HistoryResponse(MessageStatus status, const std::string &target)
+    : Message(MessageType::HISTORY_RESPONSE), status_(status), target_(target), hasMore_(false)
+{
+}
+
+std::string HistoryResponse::serialize() const
 {
     auto json = toJSON();
     std::ostringstream oss;
@@ -537,7 +820,7 @@ std::string ErrorMessage::serialize() const
     return oss.str();
 }
 
-bool ErrorMessage::deserialize(const std::string &data)
+bool HistoryResponse::deserialize(const std::string &data)
 {
     try
     {
@@ -552,15 +835,25 @@ bool ErrorMessage::deserialize(const std::string &data)
     }
 }
 
-Poco::JSON::Object::Ptr ErrorMessage::toJSON() const
+Poco::JSON::Object::Ptr HistoryResponse::toJSON() const
 {
     auto json = Message::toJSON();
-    json->set("error_code", error_code_);
-    json->set("error_message", error_message_);
+    json->set("status", static_cast<int>(status_));
+    json->set("target", target_);
+    Poco::JSON::Array::Ptr messagesArray = new Poco::JSON::Array;
+    for (const auto &message : messages_)
+    {
+        messagesArray->add(message.toJSON());
+    }
+    json->set("messages", messagesArray);
+    if (hasMore_)
+    {
+        json->set("has_more", 1);
+    }
     return json;
 }
 
-bool ErrorMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
+bool HistoryResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
 {
     if (!Message::fromJSON(json))
     {
@@ -569,8 +862,20 @@ bool ErrorMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
 
     try
     {
-        error_code_ = json->getValue<int>("error_code");
-        error_message_ = json->getValue<std::string>("error_message");
+        status_ = static_cast<MessageStatus>(json->getValue<int>("status"));
+        target_ = json->getValue<std::string>("target");
+        Poco::JSON::Array::Ptr messagesArray = json->getArray("messages");
+        messages_.clear();
+        for (size_t i = 0; i < messagesArray->size(); ++i)
+        {
+            ChatMessage message;
+            if (!message.fromJSON(messagesArray->getObject(i)))
+            {
+                return false;
+            }
+            messages_.push_back(std::move(message));
+        }
+        hasMore_ = json->has("has_more") && json->getValue<int>("has_more") != 0;
         return true;
     }
     catch (const std::exception &)
@@ -579,110 +884,902 @@ bool ErrorMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
     }
 }
 
-// 工厂方法实现
-std::unique_ptr<Message> Message::createMessage(MessageType type)
+void HistoryResponse::encodeBinary(BinaryWriter &writer) const
 {
-    switch (type)
+    Message::encodeBinary(writer);
+    writer.writeByte(static_cast<uint8_t>(status_));
+    writer.writeString(target_);
+    writer.writeVarUInt(messages_.size());
+    for (const auto &message : messages_)
     {
-    case MessageType::REGISTER_REQUEST:
-        return std::make_unique<RegisterRequest>();
-    case MessageType::REGISTER_RESPONSE:
-        return std::make_unique<RegisterResponse>();
-    case MessageType::LOGIN_REQUEST:
-        return std::make_unique<LoginRequest>();
-    case MessageType::LOGIN_RESPONSE:
-        return std::make_unique<LoginResponse>();
-    case MessageType::BROADCAST_MESSAGE:
-    case MessageType::PRIVATE_MESSAGE:
-        return std::make_unique<ChatMessage>();
-    case MessageType::USER_LIST_RESPONSE:
-        return std::make_unique<UserListResponse>();
-    case MessageType::USER_STATUS_UPDATE:
-        return std::make_unique<UserStatusUpdate>();
-    case MessageType::ERROR_MESSAGE:
-        return std::make_unique<ErrorMessage>();
-    default:
-        return nullptr;
+        message.encodeBinary(writer);
     }
+    writer.writeByte(hasMore_ ? 1 : 0);
 }
 
-std::unique_ptr<Message> Message::parseMessage(const std::string &data)
+bool HistoryResponse::decodeBinary(BinaryReader &reader)
 {
-    try
+    uint8_t status = 0;
+    uint64_t count = 0;
+    if (!Message::decodeBinary(reader) || !reader.readByte(status) || !reader.readString(target_) || !reader.readVarUInt(count))
     {
-        Poco::JSON::Parser parser;
-        Poco::Dynamic::Var result = parser.parse(data);
+        return false;
+    }
+    // 每条内嵌消息至少占若干字节，借此拒绝伪造的超大数量
+    if (count > reader.remaining())
+    {
+        return false;
+    }
+    status_ = static_cast<MessageStatus>(status);
+    messages_.clear();
+    messages_.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        ChatMessage message;
+        if (!message.decodeBinary(reader))
+        {
+            return false;
+        }
+        messages_.push_back(std::move(message));
+    }
+    uint8_t hasMore = 0;
+    if (!reader.readByte(hasMore))
+    {
+        return false;
+    }
+    hasMore_ = hasMore != 0;
+    return true;
+}
+
+bool HistoryResponse::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "status")
+    {
+        int64_t value = 0;
+        if (!reader.readInt(value))
+        {
+            return false;
+        }
+        status_ = static_cast<MessageStatus>(value);
+        return true;
+    }
+    if (key == "target")
+    {
+        return reader.readString(target_);
+    }
+    if (key == "messages")
+    {
+        std::vector<std::string_view> objects;
+        if (!reader.readObjectArray(objects))
+        {
+            return false;
+        }
+        messages_.clear();
+        messages_.reserve(objects.size());
+        for (std::string_view object : objects)
+        {
+            auto message = Message::parseMessage(object);
+            if (!message || (message->getType() != MessageType::BROADCAST_MESSAGE && message->getType() != MessageType::PRIVATE_MESSAGE &&
+                             message->getType() != MessageType::ROOM_MESSAGE))
+            {
+                return false;
+            }
+            messages_.push_back(std::move(static_cast<ChatMessage &>(*message)));
+        }
+        return true;
+    }
+    if (key == "has_more")
+    {
+        int64_t value = 0;
+        if (!reader.readInt(value))
+        {
+            return false;
+        }
+        hasMore_ = value != 0;
+        return true;
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// RoomRequest实现
+RoomRequest::RoomRequest() : Message(MessageType::ROOM_JOIN), room_("")
+{
+}
+
+RoomRequest::RoomRequest(MessageType type, const std::string &room) : Message(type), room_(room)
+{
+}
+
+std::string RoomRequest::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool RoomRequest::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+Poco::JSON::Object::Ptr RoomRequest::toJSON() const
+{
+    auto json = Message::toJSON();
+    json->set("room", room_);
+    return json;
+}
+
+bool RoomRequest::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        room_ = json->getValue<std::string>("room");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void RoomRequest::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeString(room_);
+}
+
+bool RoomRequest::decodeBinary(BinaryReader &reader)
+{
+    return Message::decodeBinary(reader) && reader.readString(room_);
+}
+
+bool RoomRequest::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "room")
+    {
+        return reader.readString(room_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// RoomResponse实现
+RoomResponse::RoomResponse() : Message(MessageType::ROOM_RESPONSE), status_(MessageStatus::SUCCESS), room_(""), message_("")
+{
+}
+
+RoomResponse::RoomResponse(MessageStatus status, const std::string &room, const std::string &message)
+    : Message(MessageType::ROOM_RESPONSE), status_(status), room_(room), message_(message)
+{
+}
+
+std::string RoomResponse::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool RoomResponse::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+Poco::JSON::Object::Ptr RoomResponse::toJSON() const
+{
+    auto json = Message::toJSON();
+    json->set("status", static_cast<int>(status_));
+    json->set("room", room_);
+    json->set("message", message_);
+    return json;
+}
+
+bool RoomResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        status_ = static_cast<MessageStatus>(json->getValue<int>("status"));
+        room_ = json->getValue<std::string>("room");
+        message_ = json->getValue<std::string>("message");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void RoomResponse::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeByte(static_cast<uint8_t>(status_));
+    writer.writeString(room_);
+    writer.writeString(message_);
+}
+
+bool RoomResponse::decodeBinary(BinaryReader &reader)
+{
+    uint8_t status = 0;
+    if (!Message::decodeBinary(reader) || !reader.readByte(status))
+    {
+        return false;
+    }
+    status_ = static_cast<MessageStatus>(status);
+    return reader.readString(room_) && reader.readString(message_);
+}
+
+bool RoomResponse::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "status")
+    {
+        int64_t value = 0;
+        if (!reader.readInt(value))
+        {
+            return false;
+        }
+        status_ = static_cast<MessageStatus>(value);
+        return true;
+    }
+    if (key == "room")
+    {
+        return reader.readString(room_);
+    }
+    if (key == "message")
+    {
+        return reader.readString(message_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// UserListResponse实现
+UserListResponse::UserListResponse() : Message(MessageType::USER_LIST_RESPONSE)
+{
+}
+
+std::string UserListResponse::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool UserListResponse::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+Poco::JSON::Object::Ptr UserListResponse::toJSON() const
+{
+    auto json = Message::toJSON();
+    Poco::JSON::Array::Ptr usersArray = new Poco::JSON::Array;
+    for (const auto &user : users_)
+    {
+        usersArray->add(user);
+    }
+    json->set("users", usersArray);
+    return json;
+}
+
+bool UserListResponse::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        Poco::JSON::Array::Ptr usersArray = json->getArray("users");
+        users_.clear();
+        for (size_t i = 0; i < usersArray->size(); ++i)
+        {
+            users_.push_back(usersArray->getElement<std::string>(i));
+        }
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void UserListResponse::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeVarUInt(users_.size());
+    for (const auto &user : users_)
+    {
+        writer.writeString(user);
+    }
+}
+
+bool UserListResponse::decodeBinary(BinaryReader &reader)
+{
+    uint64_t count = 0;
+    if (!Message::decodeBinary(reader) || !reader.readVarUInt(count))
+    {
+        return false;
+    }
+    // 每个字符串至少占1字节长度前缀，借此拒绝伪造的超大数量
+    if (count > reader.remaining())
+    {
+        return false;
+    }
+    users_.clear();
+    users_.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        std::string user;
+        if (!reader.readString(user))
+        {
+            return false;
+        }
+        users_.push_back(std::move(user));
+    }
+    return true;
+}
+
+bool UserListResponse::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "users")
+    {
+        return reader.readStringArray(users_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// UserStatusUpdate实现
+UserStatusUpdate::UserStatusUpdate() : Message(MessageType::USER_STATUS_UPDATE), action_("")
+{
+}
+
+UserStatusUpdate::UserStatusUpdate(const std::string &action)
+    : Message(MessageType::USER_STATUS_UPDATE), action_(action)
+{
+}
+
+std::string UserStatusUpdate::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool UserStatusUpdate::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+Poco::JSON::Object::Ptr UserStatusUpdate::toJSON() const
+{
+    auto json = Message::toJSON();
+    json->set("action", action_);
+    return json;
+}
+
+bool UserStatusUpdate::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        action_ = json->getValue<std::string>("action");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void UserStatusUpdate::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeString(action_);
+}
+
+bool UserStatusUpdate::decodeBinary(BinaryReader &reader)
+{
+    return Message::decodeBinary(reader) && reader.readString(action_);
+}
+
+bool UserStatusUpdate::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "action")
+    {
+        return reader.readString(action_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// MessageAck实现
+MessageAck::MessageAck() : Message(MessageType::MESSAGE_ACK), ackId_(0)
+{
+}
+
+MessageAck::MessageAck(uint64_t ackId) : Message(MessageType::MESSAGE_ACK), ackId_(ackId)
+{
+}
+
+std::string MessageAck::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool MessageAck::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+Poco::JSON::Object::Ptr MessageAck::toJSON() const
+{
+    auto json = Message::toJSON();
+    json->set("ack_id", ackId_);
+    return json;
+}
+
+bool MessageAck::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        ackId_ = json->getValue<uint64_t>("ack_id");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void MessageAck::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeVarUInt(ackId_);
+}
+
+bool MessageAck::decodeBinary(BinaryReader &reader)
+{
+    return Message::decodeBinary(reader) && reader.readVarUInt(ackId_);
+}
+
+bool MessageAck::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "ack_id")
+    {
+        return reader.readUInt(ackId_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// CapabilitiesMessage实现
+CapabilitiesMessage::CapabilitiesMessage() : Message(MessageType::CAPABILITIES), capabilities_(0)
+{
+}
+
+CapabilitiesMessage::CapabilitiesMessage(uint32_t capabilities)
+    : Message(MessageType::CAPABILITIES), capabilities_(capabilities)
+{
+}
+
+std::string CapabilitiesMessage::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool CapabilitiesMessage::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
         Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
 
-        int typeInt = json->getValue<int>("type");
-        MessageType type = static_cast<MessageType>(typeInt);
-        switch (type)
-        {
-        case MessageType::REGISTER_REQUEST:
-        {
-            auto message = std::make_unique<RegisterRequest>();
-            message->deserialize(data);
-            return message;
-        }
-        break;
-        case MessageType::REGISTER_RESPONSE:
+Poco::JSON::Object::Ptr CapabilitiesMessage::toJSON() const
+{
+    auto json = Message::toJSON();
+    json->set("capabilities", capabilities_);
+    return json;
+}
+
+bool CapabilitiesMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        capabilities_ = json->getValue<uint32_t>("capabilities");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void CapabilitiesMessage::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeVarUInt(capabilities_);
+}
+
+bool CapabilitiesMessage::decodeBinary(BinaryReader &reader)
+{
+    uint64_t capabilities = 0;
+    if (!Message::decodeBinary(reader) || !reader.readVarUInt(capabilities))
+    {
+        return false;
+    }
+    // 不认识的高位能力直接忽略
+    capabilities_ = static_cast<uint32_t>(capabilities);
+    return true;
+}
+
+bool CapabilitiesMessage::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "capabilities")
+    {
+        uint64_t capabilities = 0;
+        if (!reader.readUInt(capabilities))
         {
-            auto message = std::make_unique<RegisterResponse>();
-            message->deserialize(data);
-            return message;
+            return false;
         }
-        break;
-        case MessageType::LOGIN_REQUEST:
+        capabilities_ = static_cast<uint32_t>(capabilities);
+        return true;
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// HeartbeatMessage实现
+HeartbeatMessage::HeartbeatMessage() : Message(MessageType::HEARTBEAT)
+{
+}
+
+std::string HeartbeatMessage::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool HeartbeatMessage::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// ErrorMessage实现
+ErrorMessage::ErrorMessage() : Message(MessageType::ERROR_MESSAGE), error_code_(0), error_message_("")
+{
+}
+
+ErrorMessage::ErrorMessage(int error_code, const std::string &error_message)
+    : Message(MessageType::ERROR_MESSAGE), error_code_(error_code), error_message_(error_message)
+{
+}
+
+std::string ErrorMessage::serialize() const
+{
+    auto json = toJSON();
+    std::ostringstream oss;
+    Poco::JSON::Stringifier::stringify(json, oss);
+    return oss.str();
+}
+
+bool ErrorMessage::deserialize(const std::string &data)
+{
+    try
+    {
+        Poco::JSON::Parser parser;
+        Poco::Dynamic::Var result = parser.parse(data);
+        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
+        return fromJSON(json);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+Poco::JSON::Object::Ptr ErrorMessage::toJSON() const
+{
+    auto json = Message::toJSON();
+    json->set("error_code", error_code_);
+    json->set("error_message", error_message_);
+    return json;
+}
+
+bool ErrorMessage::fromJSON(const Poco::JSON::Object::Ptr &json)
+{
+    if (!Message::fromJSON(json))
+    {
+        return false;
+    }
+
+    try
+    {
+        error_code_ = json->getValue<int>("error_code");
+        error_message_ = json->getValue<std::string>("error_message");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void ErrorMessage::encodeBinary(BinaryWriter &writer) const
+{
+    Message::encodeBinary(writer);
+    writer.writeVarInt(error_code_);
+    writer.writeString(error_message_);
+}
+
+bool ErrorMessage::decodeBinary(BinaryReader &reader)
+{
+    int64_t code = 0;
+    if (!Message::decodeBinary(reader) || !reader.readVarInt(code))
+    {
+        return false;
+    }
+    error_code_ = static_cast<int>(code);
+    return reader.readString(error_message_);
+}
+
+bool ErrorMessage::readJSONField(std::string_view key, JsonReader &reader)
+{
+    if (key == "error_code")
+    {
+        int64_t value = 0;
+        if (!reader.readInt(value))
         {
-            auto message = std::make_unique<LoginRequest>();
-            message->deserialize(data);
-            return message;
+            return false;
         }
-        break;
-        case MessageType::LOGIN_RESPONSE:
+        error_code_ = static_cast<int>(value);
+        return true;
+    }
+    if (key == "error_message")
+    {
+        return reader.readString(error_message_);
+    }
+    return Message::readJSONField(key, reader);
+}
+
+// 工厂方法实现
+std::unique_ptr<Message> Message::createMessage(MessageType type)
+{
+    switch (type)
+    {
+    case MessageType::REGISTER_REQUEST:
+        return std::make_unique<RegisterRequest>();
+    case MessageType::REGISTER_RESPONSE:
+        return std::make_unique<RegisterResponse>();
+    case MessageType::LOGIN_REQUEST:
+        return std::make_unique<LoginRequest>();
+    case MessageType::LOGIN_RESPONSE:
+        return std::make_unique<LoginResponse>();
+    case MessageType::BROADCAST_MESSAGE:
+    case MessageType::PRIVATE_MESSAGE:
+    case MessageType::ROOM_MESSAGE:
+        return std::make_unique<ChatMessage>();
+    case MessageType::ROOM_JOIN:
+    case MessageType::ROOM_LEAVE:
+        return std::make_unique<RoomRequest>();
+    case MessageType::ROOM_RESPONSE:
+        return std::make_unique<RoomResponse>();
+    case MessageType::HISTORY_REQUEST:
+        return std::make_unique<HistoryRequest>();
+    case MessageType::HISTORY_RESPONSE:
+        return std::make_unique<HistoryResponse>();
+    case MessageType::USER_LIST_RESPONSE:
+        return std::make_unique<UserListResponse>();
+    case MessageType::USER_STATUS_UPDATE:
+        return std::make_unique<UserStatusUpdate>();
+    case MessageType::MESSAGE_ACK:
+        return std::make_unique<MessageAck>();
+    case MessageType::HEARTBEAT:
+        return std::make_unique<HeartbeatMessage>();
+    case MessageType::CAPABILITIES:
+        return std::make_unique<CapabilitiesMessage>();
+    case MessageType::ERROR_MESSAGE:
+        return std::make_unique<ErrorMessage>();
+    default:
+        return nullptr;
+    }
+}
+
+std::unique_ptr<Message> Message::parseBinary(std::string_view data)
+{
+    if (data.size() < 2)
+    {
+        return nullptr;
+    }
+
+    auto message = createMessage(static_cast<MessageType>(static_cast<uint8_t>(data[1])));
+    if (!message)
+    {
+        return nullptr;
+    }
+
+    BinaryReader reader(data.data() + 1, data.size() - 1);
+    if (!message->decodeBinary(reader) || !message->decodeBinaryTrailer(reader) || !reader.atEnd())
+    {
+        return nullptr;
+    }
+    return message;
+}
+
+std::unique_ptr<Message> Message::parseJSON(std::string_view data)
+{
+    // Poco 输出的键按字母序排列，"type" 之前的字段先记下原始范围，确定类型后再回放
+    struct PendingField
+    {
+        std::string_view key;
+        std::string_view value;
+    };
+    constexpr size_t kMaxPendingFields = 16;
+    PendingField pending[kMaxPendingFields];
+    size_t pendingCount = 0;
+
+    JsonReader reader(data);
+    if (!reader.beginObject())
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<Message> message;
+    std::string_view key;
+    while (reader.nextKey(key))
+    {
+        if (message)
         {
-            auto message = std::make_unique<LoginResponse>();
-            message->deserialize(data);
-            return message;
+            if (!message->readJSONField(key, reader))
+            {
+                return nullptr;
+            }
+            continue;
         }
-        break;
-        case MessageType::BROADCAST_MESSAGE:
-        case MessageType::PRIVATE_MESSAGE:
+
+        if (key != "type")
         {
-            auto message = std::make_unique<ChatMessage>();
-            message->deserialize(data);
-            return message;
+            if (pendingCount == kMaxPendingFields || !reader.skipValue(&pending[pendingCount].value))
+            {
+                return nullptr;
+            }
+            pending[pendingCount++].key = key;
+            continue;
         }
-        break;
-        case MessageType::USER_LIST_RESPONSE:
+
+        int64_t type = 0;
+        if (!reader.readInt(type) || type < 0 || type > UINT8_MAX)
         {
-            auto message = std::make_unique<UserListResponse>();
-            message->deserialize(data);
-            return message;
+            return nullptr;
         }
-        break;
-        case MessageType::USER_STATUS_UPDATE:
+        message = createMessage(static_cast<MessageType>(type));
+        if (!message)
         {
-            auto message = std::make_unique<UserStatusUpdate>();
-            message->deserialize(data);
-            return message;
+            return nullptr;
         }
-        break;
-        case MessageType::ERROR_MESSAGE:
+        message->type_ = static_cast<MessageType>(type);
+
+        for (size_t i = 0; i < pendingCount; ++i)
         {
-            auto message = std::make_unique<ErrorMessage>();
-            message->deserialize(data);
-            return message;
-        }
-        break;
-        default:
-            break;
+            JsonReader valueReader(pending[i].value);
+            if (!message->readJSONField(pending[i].key, valueReader))
+            {
+                return nullptr;
+            }
         }
     }
-    catch (const std::exception &)
+
+    if (!message || !reader.finished())
     {
-        // 解析失败
+        return nullptr;
     }
+    return message;
+}
 
-    return nullptr;
+std::unique_ptr<Message> Message::parseMessage(std::string_view data)
+{
+    if (detectFormat(data) == WireFormat::BINARY)
+    {
+        return parseBinary(data);
+    }
+    return parseJSON(data);
 }
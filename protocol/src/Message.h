@@ -3,9 +3,14 @@
 #include "message_types.h"
 #include <string>
 #include <memory>
+#include <string_view>
 #include <vector>
 #include <Poco/JSON/Object.h>
 
+class BinaryWriter;
+class BinaryReader;
+class JsonReader;
+
 // 消息基类
 class Message
 {
@@ -13,29 +18,54 @@ public:
     Message(MessageType type);
     virtual ~Message() = default;
 
-    // 基本属性
+    // 基本属性。ID 和时间戳（Unix 毫秒）在首次读取或编码时才生成，
+    // 解析得到的消息直接使用对端的值，不读取时钟
     MessageType getType() const { return type_; }
-    uint32_t getId() const { return id_; }
-    uint64_t getTimestamp() const { return timestamp_; }
+    uint64_t getId() const { ensureStamped(); return id_; }
+    uint64_t getTimestamp() const { ensureStamped(); return timestamp_; }
 
-    void setId(uint32_t id) { id_ = id; }
+    void setId(uint64_t id) { id_ = id; }
+    // 重新分配 ID 和时间戳，服务器转发消息时用本节点的 ID 覆盖客户端的值
+    void stamp();
 
     // 序列化/反序列化
     virtual std::string serialize() const = 0;
     virtual bool deserialize(const std::string &data) = 0;
 
+    // 按指定线路格式编码，BINARY 格式不经过 JSON DOM
+    std::string encode(WireFormat format) const;
+    std::string serializeBinary() const;
+    static WireFormat detectFormat(std::string_view data);
+
     // 创建消息的工厂方法
     static std::unique_ptr<Message> createMessage(MessageType type);
-    static std::unique_ptr<Message> parseMessage(const std::string &data);
+    // 根据首字节自动识别 JSON 或二进制格式，JSON 使用单遍流式解析
+    static std::unique_ptr<Message> parseMessage(std::string_view data);
 
 protected:
     MessageType type_;
-    uint32_t id_;
-    uint64_t timestamp_;
+    mutable uint64_t id_;        // 0 表示尚未生成
+    mutable uint64_t timestamp_;
+
+    void ensureStamped() const;
 
     // JSON 相关
     virtual Poco::JSON::Object::Ptr toJSON() const;
     virtual bool fromJSON(const Poco::JSON::Object::Ptr &json);
+
+    // 二进制编码相关
+    virtual void encodeBinary(BinaryWriter &writer) const;
+    virtual bool decodeBinary(BinaryReader &reader);
+    // 只出现在顶层消息末尾的可选字段：内嵌在其他消息中时不编码，不带这些字段的编码仍可解码
+    virtual void encodeBinaryTrailer(BinaryWriter &) const {}
+    virtual bool decodeBinaryTrailer(BinaryReader &) { return true; }
+
+    // 流式 JSON 解析：读取一个字段的值，未知字段需跳过
+    virtual bool readJSONField(std::string_view key, JsonReader &reader);
+
+private:
+    static std::unique_ptr<Message> parseBinary(std::string_view data);
+    static std::unique_ptr<Message> parseJSON(std::string_view data);
 };
 
 // 注册请求消息
@@ -57,6 +87,9 @@ public:
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     std::string username_;
@@ -82,6 +115,9 @@ public:
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     MessageStatus status_;
@@ -106,6 +142,9 @@ public:
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     std::string account_;
@@ -132,15 +171,26 @@ public:
     const std::string &getMessage() const { return message_; }
     const std::string &getUsername() const { return username_; }
 
+    // 服务器支持的能力位，随登录成功的响应下发；客户端只在这里声明过的能力上发送 CAPABILITIES、HEARTBEAT 等新消息，
+    // 旧服务器不带该字段，取值为 0
+    void setCapabilities(uint32_t capabilities) { capabilities_ = capabilities; }
+    uint32_t getCapabilities() const { return capabilities_; }
+
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    void encodeBinaryTrailer(BinaryWriter &writer) const override;
+    bool decodeBinaryTrailer(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     MessageStatus status_;
     std::string username_;
     std::string account_;
     std::string message_;
+    uint32_t capabilities_ = 0;
 };
 
 // 聊天消息
@@ -150,6 +200,8 @@ public:
     ChatMessage();
     ChatMessage(const std::string &sender, const std::string &sender_username, const std::string &content);
     ChatMessage(const std::string &sender, const std::string &sender_username, const std::string &receiver, const std::string &content);
+    // 房间消息使用 ROOM_MESSAGE 类型，接收方字段保存房间名
+    ChatMessage(MessageType type, const std::string &sender, const std::string &sender_username, const std::string &receiver, const std::string &content);
 
     std::string serialize() const override;
     bool deserialize(const std::string &data) override;
@@ -158,25 +210,167 @@ public:
     void setReceiver(const std::string &receiver) { receiver_ = receiver; }
     void setContent(const std::string &content) { content_ = content; }
     void setSenderUsername(const std::string &username) { sender_username_ = username; }
+    void setSeq(uint64_t seq) { seq_ = seq; }
+    // 客户端重发未确认的消息时置位，服务器对带标记的消息按 ID 去重；只在服务器声明 kCapabilityRetransmit 后使用
+    void setRetransmit(bool retransmit) { retransmit_ = retransmit; }
 
     const std::string &getSender() const { return sender_; }
     const std::string &getReceiver() const { return receiver_; }
     const std::string &getContent() const { return content_; }
     const std::string &getSenderUsername() const { return sender_username_; }
+    // 服务器按会话分配的单调递增序号，0 表示未经服务器转发
+    uint64_t getSeq() const { return seq_; }
+    bool isRetransmit() const { return retransmit_; }
+
+    const std::string &getRoom() const { return receiver_; }
 
     // 辅助方法
-    bool isPrivateMessage() const { return !receiver_.empty(); }
-    bool isBroadcastMessage() const { return receiver_.empty(); }
+    bool isPrivateMessage() const { return type_ == MessageType::PRIVATE_MESSAGE; }
+    bool isBroadcastMessage() const { return type_ == MessageType::BROADCAST_MESSAGE; }
+    bool isRoomMessage() const { return type_ == MessageType::ROOM_MESSAGE; }
 
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    void encodeBinaryTrailer(BinaryWriter &writer) const override;
+    bool decodeBinaryTrailer(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
+    // 历史响应内嵌聊天消息，直接复用其编解码
+    friend class HistoryResponse;
+
     std::string sender_;
     std::string sender_username_;
     std::string receiver_;
     std::string content_;
+    uint64_t seq_;
+    bool retransmit_ = false;
+};
+
+// 历史消息请求：target 为空表示广播，'#' 开头为房间，否则为私聊对方账号。
+// beforeId 为 0 时取最近的 limit 条，否则取该 ID 之前的 limit 条
+class HistoryRequest : public Message
+{
+public:
+    HistoryRequest();
+    HistoryRequest(const std::string &target, uint32_t limit, uint64_t beforeId = 0);
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+
+    void setTarget(const std::string &target) { target_ = target; }
+    void setLimit(uint32_t limit) { limit_ = limit; }
+    void setBeforeId(uint64_t beforeId) { beforeId_ = beforeId; }
+
+    const std::string &getTarget() const { return target_; }
+    uint32_t getLimit() const { return limit_; }
+    uint64_t getBeforeId() const { return beforeId_; }
+
+protected:
+    Poco::JSON::Object::Ptr toJSON() const override;
+    bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
+
+private:
+    std::string target_;
+    uint32_t limit_;
+    uint64_t beforeId_;
+};
+
+// 历史消息响应，消息按时间正序排列
+class HistoryResponse : public Message
+{
+public:
+    HistoryResponse();
+    HistoryResponse(MessageStatus status, const std::string &target);
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+
+    void setStatus(MessageStatus status) { status_ = status; }
+    void setTarget(const std::string &target) { target_ = target; }
+    void addMessage(ChatMessage message) { messages_.push_back(std::move(message)); }
+    void setHasMore(bool hasMore) { hasMore_ = hasMore; }
+
+    MessageStatus getStatus() const { return status_; }
+    const std::string &getTarget() const { return target_; }
+    const std::vector<ChatMessage> &getMessages() const { return messages_; }
+    // 为不超过帧长度上限只返回了较新的一部分，更早的消息以第一条的 ID 作为 beforeId 继续查询
+    bool hasMore() const { return hasMore_; }
+
+protected:
+    Poco::JSON::Object::Ptr toJSON() const override;
+    bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
+
+private:
+    MessageStatus status_;
+    std::string target_;
+    std::vector<ChatMessage> messages_;
+    bool hasMore_;
+};
+
+// 加入/离开房间请求，类型为 ROOM_JOIN 或 ROOM_LEAVE
+class RoomRequest : public Message
+{
+public:
+    RoomRequest();
+    RoomRequest(MessageType type, const std::string &room);
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+
+    void setRoom(const std::string &room) { room_ = room; }
+    const std::string &getRoom() const { return room_; }
+    bool isJoin() const { return type_ == MessageType::ROOM_JOIN; }
+
+protected:
+    Poco::JSON::Object::Ptr toJSON() const override;
+    bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
+
+private:
+    std::string room_;
+};
+
+// 房间操作结果
+class RoomResponse : public Message
+{
+public:
+    RoomResponse();
+    RoomResponse(MessageStatus status, const std::string &room, const std::string &message = "");
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+
+    void setStatus(MessageStatus status) { status_ = status; }
+    void setRoom(const std::string &room) { room_ = room; }
+    void setMessage(const std::string &message) { message_ = message; }
+
+    MessageStatus getStatus() const { return status_; }
+    const std::string &getRoom() const { return room_; }
+    const std::string &getMessage() const { return message_; }
+
+protected:
+    Poco::JSON::Object::Ptr toJSON() const override;
+    bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
+
+private:
+    MessageStatus status_;
+    std::string room_;
+    std::string message_;
 };
 
 // 用户列表响应消息
@@ -195,6 +389,9 @@ public:
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     std::vector<std::string> users_;
@@ -217,11 +414,73 @@ public:
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     std::string action_; // "logout", "leave"
 };
 
+// 累计确认：服务器已处理（转发、存入离线收件箱或回复错误）该连接上 ID 不大于 ack_id 的全部聊天消息。
+// 服务器每处理完一次读入的所有帧才回复一次，不逐条确认
+class MessageAck : public Message
+{
+public:
+    MessageAck();
+    explicit MessageAck(uint64_t ackId);
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+
+    void setAckId(uint64_t ackId) { ackId_ = ackId; }
+    uint64_t getAckId() const { return ackId_; }
+
+protected:
+    Poco::JSON::Object::Ptr toJSON() const override;
+    bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
+
+private:
+    uint64_t ackId_;
+};
+
+// 能力协商：客户端发送自己支持的能力位，服务器回复双方都支持的能力位，之后双方按回复启用
+class CapabilitiesMessage : public Message
+{
+public:
+    CapabilitiesMessage();
+    explicit CapabilitiesMessage(uint32_t capabilities);
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+
+    void setCapabilities(uint32_t capabilities) { capabilities_ = capabilities; }
+    uint32_t getCapabilities() const { return capabilities_; }
+
+protected:
+    Poco::JSON::Object::Ptr toJSON() const override;
+    bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
+
+private:
+    uint32_t capabilities_;
+};
+
+// 心跳，只携带公共字段；客户端空闲时定期发送，服务器据此判断连接仍然存活
+class HeartbeatMessage : public Message
+{
+public:
+    HeartbeatMessage();
+
+    std::string serialize() const override;
+    bool deserialize(const std::string &data) override;
+};
+
 // 错误消息
 class ErrorMessage : public Message
 {
@@ -241,6 +500,9 @@ public:
 protected:
     Poco::JSON::Object::Ptr toJSON() const override;
     bool fromJSON(const Poco::JSON::Object::Ptr &json) override;
+    void encodeBinary(BinaryWriter &writer) const override;
+    bool decodeBinary(BinaryReader &reader) override;
+    bool readJSONField(std::string_view key, JsonReader &reader) override;
 
 private:
     int error_code_;
@@ -16,6 +16,8 @@ enum class MessageType : uint8_t
     BROADCAST_MESSAGE = 10,
     PRIVATE_MESSAGE = 11,
     MESSAGE_ACK = 12,
+    HISTORY_REQUEST = 13,
+    HISTORY_RESPONSE = 14,
 
     // 用户相关
     USER_LIST_REQUEST = 20,
@@ -24,9 +26,26 @@ enum class MessageType : uint8_t
 
     // 系统相关
     HEARTBEAT = 30,
-    ERROR_MESSAGE = 31
+    ERROR_MESSAGE = 31,
+    BATCH = 32, // 批量帧，负载中依次包含多条完整消息的负载
+    CAPABILITIES = 33, // 能力协商，客户端连接后声明支持的可选特性，服务器回复双方都支持的部分
+
+    // 房间相关
+    ROOM_JOIN = 40,
+    ROOM_LEAVE = 41,
+    ROOM_MESSAGE = 42,
+    ROOM_RESPONSE = 43
 };
 
+// 可协商的能力位
+constexpr uint32_t kCapabilityCompression = 1u << 0; // 长度头带压缩标志的 zlib 压缩帧
+constexpr uint32_t kCapabilityRetransmit = 1u << 1;   // 重发的聊天消息带 retransmit 标记，服务器只对带标记的消息去重
+constexpr uint32_t kCapabilityBatch = 1u << 2;        // 多条消息合并为一个 BATCH 帧
+constexpr uint32_t kCapabilityHeartbeat = 1u << 3;    // 服务器接受 HEARTBEAT，只声明不协商
+
+// 聊天消息二进制编码末尾可选的标志位
+constexpr uint64_t kChatFlagRetransmit = 1u << 0;
+
 // 消息状态
 enum class MessageStatus : uint8_t
 {
@@ -37,4 +56,11 @@ enum class MessageStatus : uint8_t
     USER_ALREADY_EXISTS = 4,
     INVALID_FORMAT = 5,
     UNAUTHORIZED = 6
-};
\ No newline at end of file
+};
+
+// 线路编码格式
+enum class WireFormat : uint8_t
+{
+    JSON = 0,
+    BINARY = 1
+};
@@ -0,0 +1,177 @@
+#include "AsyncLog.h"
+#include <Poco/Logger.h>
+#include <chrono>
+
+namespace
+{
+    // 缓冲区为空时后台线程的休眠间隔；生产者从不唤醒它，入队路径上没有锁和系统调用
+    constexpr auto kIdleSleep = std::chrono::milliseconds(2);
+    // 丢弃计数的汇报间隔，避免过载时汇报本身刷屏
+    constexpr auto kDropReportInterval = std::chrono::seconds(1);
+}
+
+AsyncLog &AsyncLog::getInstance()
+{
+    static AsyncLog instance;
+    return instance;
+}
+
+AsyncLog::~AsyncLog()
+{
+    stop();
+}
+
+void AsyncLog::setLevel(int priority)
+{
+    level_.store(priority, std::memory_order_relaxed);
+    // 已创建的 Poco 日志器也一并调整，后台线程输出时不会被再次过滤掉
+    Poco::Logger::setLevel("", priority);
+}
+
+void AsyncLog::start(size_t capacity)
+{
+    if (running_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // 缓冲区只分配一次，stop 之后仍在提交的线程不会访问已释放的内存
+    if (!cells_)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask_ = size - 1;
+    }
+
+    running_.store(true, std::memory_order_release);
+    drainer_ = std::thread(&AsyncLog::drainLoop, this);
+}
+
+void AsyncLog::stop()
+{
+    if (!running_.exchange(false, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    drainer_.join();
+}
+
+void AsyncLog::submit(Poco::Message::Priority priority, const char *source, std::string text)
+{
+    if (!running_.load(std::memory_order_acquire))
+    {
+        Record record;
+        record.priority = priority;
+        record.source = source;
+        record.text = std::move(text);
+        write(record);
+        return;
+    }
+
+    Cell *cell = nullptr;
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &cells_[pos & mask_];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // 缓冲区已满
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->record.priority = priority;
+    cell->record.source = source;
+    cell->record.text = std::move(text);
+    cell->record.time.update();
+    cell->sequence.store(pos + 1, std::memory_order_release);
+}
+
+bool AsyncLog::tryPop(Record &record)
+{
+    Cell &cell = cells_[dequeuePos_ & mask_];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePos_ + 1) < 0)
+    {
+        return false;
+    }
+    record = std::move(cell.record);
+    cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+    ++dequeuePos_;
+    return true;
+}
+
+void AsyncLog::drainLoop()
+{
+    Record record;
+    uint64_t reportedDrops = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+    auto reportDrops = [&reportedDrops, &lastReport, this]()
+    {
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reportedDrops)
+        {
+            Poco::Logger::get("AsyncLog").warning("日志缓冲区已满，丢弃了 " + std::to_string(dropped - reportedDrops) + " 条记录");
+            reportedDrops = dropped;
+        }
+        lastReport = std::chrono::steady_clock::now();
+    };
+
+    while (true)
+    {
+        bool drained = false;
+        while (tryPop(record))
+        {
+            write(record);
+            drained = true;
+        }
+
+        if (std::chrono::steady_clock::now() - lastReport >= kDropReportInterval)
+        {
+            reportDrops();
+        }
+
+        if (!running_.load(std::memory_order_acquire))
+        {
+            while (tryPop(record))
+            {
+                write(record);
+            }
+            reportDrops();
+            break;
+        }
+        if (!drained)
+        {
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+}
+
+void AsyncLog::write(const Record &record)
+{
+    Poco::Message message(record.source, record.text, record.priority);
+    message.setTime(record.time);
+    Poco::Logger::get(record.source).log(message);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Poco/Message.h>
+#include <Poco/Timestamp.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// 异步日志：调用线程只做级别判断和格式化，记录放入无锁环形缓冲区后立即返回，
+// 由后台线程按原来源名交给 Poco::Logger 输出（通道、格式与以前一致）。
+// 级别关闭时宏内的消息表达式不会被求值，开销只有一次原子读取；
+// 缓冲区满时丢弃新记录并计数，不阻塞转发线程。未启动时直接同步输出
+class AsyncLog
+{
+public:
+    static AsyncLog &getInstance();
+
+    // 级别取 Poco::Message::Priority，数值越小越严重
+    void setLevel(int priority);
+    int getLevel() const { return level_.load(std::memory_order_relaxed); }
+    bool enabled(int priority) const { return priority <= level_.load(std::memory_order_relaxed); }
+
+    // capacity 向上取整为 2 的幂
+    void start(size_t capacity);
+    // 输出缓冲区中剩余的记录后停止
+    void stop();
+
+    // source 必须是静态字符串（日志宏传入字面量）
+    void submit(Poco::Message::Priority priority, const char *source, std::string text);
+
+    uint64_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    AsyncLog(const AsyncLog &) = delete;
+    AsyncLog &operator=(const AsyncLog &) = delete;
+
+private:
+    struct Record
+    {
+        Poco::Message::Priority priority = Poco::Message::PRIO_INFORMATION;
+        const char *source = nullptr;
+        std::string text;
+        Poco::Timestamp time;
+    };
+
+    // 有界多生产者队列的槽位：sequence 标记槽位可写还是可读（Vyukov 算法）
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    AsyncLog() = default;
+    ~AsyncLog();
+
+    bool tryPop(Record &record);
+    void drainLoop();
+    static void write(const Record &record);
+
+    std::atomic<int> level_{Poco::Message::PRIO_INFORMATION};
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_ = 0; // 只由后台线程访问
+    std::atomic<bool> running_{false};
+    std::thread drainer_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// 级别关闭时不求值 text
+#define CHAT_LOG(priority, source, text)                                    \
+    do                                                                      \
+    {                                                                       \
+        AsyncLog &chatLog_ = AsyncLog::getInstance();                       \
+        if (chatLog_.enabled(priority))                                     \
+        {                                                                   \
+            chatLog_.submit(priority, source, text);                        \
+        }                                                                   \
+    } while (0)
+
+#define LOG_TRACE(source, text) CHAT_LOG(Poco::Message::PRIO_TRACE, source, text)
+#define LOG_DEBUG(source, text) CHAT_LOG(Poco::Message::PRIO_DEBUG, source, text)
+#define LOG_INFO(source, text) CHAT_LOG(Poco::Message::PRIO_INFORMATION, source, text)
+#define LOG_WARNING(source, text) CHAT_LOG(Poco::Message::PRIO_WARNING, source, text)
+#define LOG_ERROR(source, text) CHAT_LOG(Poco::Message::PRIO_ERROR, source, text)
+#define LOG_FATAL(source, text) CHAT_LOG(Poco::Message::PRIO_FATAL, source, text)
@@ -0,0 +1,183 @@
+#include "AuthService.h"
+#include "AsyncLog.h"
+#include "ConnectionManager.h"
+#include "UserManager.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    // 工作线程最多每隔这么久输出一次统计
+    constexpr int64_t kReportIntervalSeconds = 60;
+
+    double percentile(std::vector<double> &samples, double p)
+    {
+        if (samples.empty())
+        {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(p * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+}
+
+AuthService &AuthService::getInstance()
+{
+    static AuthService instance;
+    return instance;
+}
+
+AuthService::~AuthService()
+{
+    stop();
+}
+
+void AuthService::start(size_t workers, size_t maxQueue)
+{
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (running_)
+    {
+        return;
+    }
+    running_ = true;
+    maxQueue_ = maxQueue;
+    latencies_.reserve(kLatencySamples);
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+    {
+        workers_.emplace_back(&AuthService::workerLoop, this);
+    }
+
+    LOG_INFO("AuthService", "认证线程数: " + std::to_string(workers_.size()) + "，队列上限: " + std::to_string(maxQueue_));
+}
+
+void AuthService::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    queueReady_.notify_all();
+    for (auto &worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+bool AuthService::submit(SlotHandle connection, const std::string &account, const std::string &password)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!running_ || queue_.size() >= maxQueue_)
+        {
+            ++rejected_;
+            return false;
+        }
+        queue_.push_back({connection, account, password, Clock::now()});
+    }
+    queueReady_.notify_one();
+    return true;
+}
+
+void AuthService::workerLoop()
+{
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueReady_.wait(lock, [this]
+                             { return !running_ || !queue_.empty(); });
+            // 停止时丢弃尚未处理的请求，连接随后也会关闭
+            if (!running_)
+            {
+                return;
+            }
+            request = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        process(request);
+    }
+}
+
+void AuthService::process(const Request &request)
+{
+    auto &userManager = UserManager::getInstance();
+
+    bool success = false;
+    std::string username;
+    try
+    {
+        success = userManager.authenticateUser(request.account, request.password);
+        if (success)
+        {
+            username = userManager.getUserByAccount(request.account).username;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("AuthService", "认证失败: " + std::string(e.what()));
+    }
+
+    ConnectionManager::getInstance().completeLogin(request.connection, success, request.account, username);
+
+    ++completed_;
+    recordLatency(std::chrono::duration<double, std::micro>(Clock::now() - request.enqueuedAt).count());
+
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(Clock::now().time_since_epoch()).count();
+    int64_t last = lastReport_.load(std::memory_order_relaxed);
+    if (now - last >= kReportIntervalSeconds && lastReport_.compare_exchange_strong(last, now))
+    {
+        logStats();
+    }
+}
+
+void AuthService::recordLatency(double micros)
+{
+    std::lock_guard<std::mutex> lock(latencyMutex_);
+    if (latencies_.size() < kLatencySamples)
+    {
+        latencies_.push_back(micros);
+    }
+    else
+    {
+        latencies_[latencyCursor_] = micros;
+    }
+    latencyCursor_ = (latencyCursor_ + 1) % kLatencySamples;
+}
+
+AuthStats AuthService::getStats() const
+{
+    AuthStats stats{};
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stats.queueDepth = queue_.size();
+    }
+    stats.completed = completed_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+
+    std::vector<double> samples;
+    {
+        std::lock_guard<std::mutex> lock(latencyMutex_);
+        samples = latencies_;
+    }
+    stats.p50Us = percentile(samples, 0.50);
+    stats.p95Us = percentile(samples, 0.95);
+    stats.p99Us = percentile(samples, 0.99);
+    return stats;
+}
+
+void AuthService::logStats() const
+{
+    AuthStats stats = getStats();
+    char line[256];
+    std::snprintf(line, sizeof(line), "认证统计: 队列深度=%zu 完成=%llu 拒绝=%llu 延迟(us) p50=%.0f p95=%.0f p99=%.0f",
+                  stats.queueDepth, static_cast<unsigned long long>(stats.completed),
+                  static_cast<unsigned long long>(stats.rejected), stats.p50Us, stats.p95Us, stats.p99Us);
+    LOG_INFO("AuthService", line);
+}
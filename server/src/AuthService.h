@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SlotMap.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 登录流水线的运行统计，延迟为从入队到结果投递回连接的时间（微秒）
+struct AuthStats
+{
+    size_t queueDepth;
+    uint64_t completed;
+    uint64_t rejected;
+    double p50Us;
+    double p95Us;
+    double p99Us;
+};
+
+// 异步认证服务：连接线程（或反应器线程）只把登录请求放入队列，
+// 由固定数量的工作线程完成密码哈希和用户查找，再通过 ConnectionManager 把结果投递回连接。
+// 连接在结果返回前已关闭时，结果被直接丢弃
+class AuthService
+{
+public:
+    static AuthService &getInstance();
+
+    void start(size_t workers, size_t maxQueue);
+    void stop();
+
+    // 队列已满或服务未启动时返回 false，调用方应立即回复失败
+    bool submit(SlotHandle connection, const std::string &account, const std::string &password);
+
+    AuthStats getStats() const;
+    void logStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request
+    {
+        SlotHandle connection;
+        std::string account;
+        std::string password;
+        Clock::time_point enqueuedAt;
+    };
+
+    AuthService() = default;
+    ~AuthService();
+    AuthService(const AuthService &) = delete;
+    AuthService &operator=(const AuthService &) = delete;
+
+    void workerLoop();
+    void process(const Request &request);
+    void recordLatency(double micros);
+
+    mutable std::mutex queueMutex_;
+    std::condition_variable queueReady_;
+    std::deque<Request> queue_;
+    size_t maxQueue_ = 0;
+    bool running_ = false;
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> rejected_{0};
+
+    // 最近的延迟样本环，统计时取分位数
+    static constexpr size_t kLatencySamples = 4096;
+    mutable std::mutex latencyMutex_;
+    std::vector<double> latencies_;
+    size_t latencyCursor_ = 0;
+    std::atomic<int64_t> lastReport_{0};
+};
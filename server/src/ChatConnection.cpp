@@ -1,168 +1,321 @@
 #include "ChatConnection.h"
+#include "AsyncLog.h"
+#include "AuthService.h"
 #include "ConnectionManager.h"
+#include "ConversationSequencer.h"
+#include "HistoryStore.h"
+#include "IdleReaper.h"
+#include "Metrics.h"
+#include "RoomRegistry.h"
 #include "Message.h"
 #include "UserManager.h"
+#include "FrameDecoder.h"
+#include "FrameWriter.h"
 #include <Poco/Net/NetException.h>
-#include <Poco/Logger.h>
 #include <Poco/StreamCopier.h>
 #include <Poco/DateTime.h>
 #include <Poco/DateTimeFormatter.h>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
+namespace
+{
+    constexpr size_t kMaxRoomNameLength = 64;
+    constexpr size_t kMaxRoomsPerConnection = 1024;
+    constexpr uint32_t kMaxHistoryLimit = 100;
+    // 历史响应中消息编码的总字节数上限，为响应自身的字段留出余量，整帧不超过客户端的帧长度上限
+    constexpr size_t kMaxHistoryBytes = FrameDecoder::kMaxFrameLength - 64 * 1024;
+}
+
 ChatConnection::ChatConnection(const Poco::Net::StreamSocket &socket)
-    : TCPServerConnection(socket), isConnected_(true), isAuthenticated_(false)
+    : socket_(socket), isConnected_(true), isAuthenticated_(false), loginPending_(false),
+      wireFormat_(WireFormat::JSON), lastActivityMs_(IdleReaper::toMillis(IdleReaper::Clock::now()))
 {
     clientAddress_ = socket.peerAddress().toString();
+    FrameWriter::configureSocket(socket_);
 
-    auto &logger = Poco::Logger::get("ChatConnection");
-    logger.information("New connection from: " + clientAddress_);
+    LOG_INFO("ChatConnection", "New connection from: " + clientAddress_);
 }
 
 ChatConnection::~ChatConnection()
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
-    logger.information("Connection closed: " + clientAddress_);
+    outbound_.close();
+    if (writerThread_.joinable())
+    {
+        writerThread_.join();
+    }
+
+    LOG_INFO("ChatConnection", "Connection closed: " + clientAddress_);
 }
 
 void ChatConnection::run()
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
-    auto &connectionManager = ConnectionManager::getInstance();
-
     try
     {
-        connectionManager.addConnection(this);
+        open();
 
+        // 发送超时的对端视为慢消费者，写线程会因此断开连接
+        socket_.setSendTimeout(Poco::Timespan(10, 0));
+        writerThread_ = std::thread(&ChatConnection::writerLoop, this);
+
+        std::string_view payload;
         while (isConnected_)
         {
-            auto message = receiveMessage();
-            if (!message)
+            if (!receiveFrame(payload))
             {
-                logger.information("Connection " + clientAddress_ + " closed by client.");
+                LOG_INFO("ChatConnection", "Connection " + clientAddress_ + " closed by client.");
                 break;
             }
-
-            // 处理不同类型的消息
-            switch (message->getType())
+            if (!handlePayload(payload))
             {
-            case MessageType::LOGIN_REQUEST:
-                if (isAuthenticated_)
-                {
-                    logger.warning("Received login request from already authenticated user: " + account_);
-                    continue;
-                }
-                handleLoginRequest(static_cast<LoginRequest &>(*message));
-                break;
-            case MessageType::REGISTER_REQUEST:
-                if (isAuthenticated_)
-                {
-                    logger.warning("Received register request from already authenticated user: " + account_);
-                    continue;
-                }
-                handleRegisterRequest(static_cast<RegisterRequest &>(*message));
-                break;
-            case MessageType::BROADCAST_MESSAGE:
-            case MessageType::PRIVATE_MESSAGE:
-                handleChatMessage(static_cast<ChatMessage &>(*message));
-                break;
-            case MessageType::USER_STATUS_UPDATE:
-                handleUserStatusUpdate(static_cast<UserStatusUpdate &>(*message));
-                break;
-            default:
-                logger.warning("Unknown message type received: " + std::to_string(static_cast<int>(message->getType())));
+                LOG_ERROR("ChatConnection", "接收消息失败: 无法解析消息");
                 break;
             }
         }
     }
     catch (const Poco::Net::NetException &e)
     {
-        logger.error("Network error in connection " + clientAddress_ + ": " + e.displayText());
+        LOG_ERROR("ChatConnection", "Network error in connection " + clientAddress_ + ": " + e.displayText());
     }
     catch (const std::exception &e)
     {
-        logger.error("Error in connection " + clientAddress_ + ": " + e.what());
+        LOG_ERROR("ChatConnection", "Error in connection " + clientAddress_ + ": " + e.what());
     }
 
+    close();
+}
+
+void ChatConnection::setWriteNotifier(std::function<void()> notifier)
+{
+    std::lock_guard<std::mutex> lock(notifierMutex_);
+    writeNotifier_ = std::move(notifier);
+}
+
+void ChatConnection::open()
+{
+    ConnectionManager::getInstance().addConnection(this);
+    IdleReaper::getInstance().watch(handle_);
+}
+
+void ChatConnection::close()
+{
     // 清理连接
     isConnected_ = false;
-    connectionManager.removeConnection(this);
-    logger.information("Connection " + clientAddress_ + " closed.");
+    leaveAllRooms();
+    ConnectionManager::getInstance().removeConnection(this);
+    setWriteNotifier(nullptr);
+
+    // 写线程会先写完队列中剩余的帧（例如被踢下线的通知）再退出
+    outbound_.close();
+    if (writerThread_.joinable())
+    {
+        writerThread_.join();
+    }
+    if (outbound_.dropped() > 0)
+    {
+        LOG_WARNING("ChatConnection", "Connection " + clientAddress_ + " dropped " + std::to_string(outbound_.dropped()) + " outbound frames.");
+    }
+    LOG_INFO("ChatConnection", "Connection " + clientAddress_ + " closed.");
 }
 
-// 接受消息并返回一个 Message 对象
-std::unique_ptr<Message> ChatConnection::receiveMessage()
+bool ChatConnection::handlePayload(std::string_view payload)
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
-    if (!isConnected_)
+    auto receivedAt = Metrics::Clock::now();
+    lastActivityMs_.store(IdleReaper::toMillis(receivedAt), std::memory_order_relaxed);
+    auto &metrics = Metrics::getInstance();
+    metrics.add(Metrics::BYTES_IN, Frame::kHeaderSize + payload.size());
+
+    if (!Frame::isBatch(payload))
     {
-        return nullptr;
+        return handleMessagePayload(payload, receivedAt);
     }
 
-    try
+    // 批量帧中的消息按顺序逐条处理，与分别收到时完全相同
+    std::vector<std::string_view> payloads;
+    if (!Frame::unpackBatch(payload, payloads))
     {
-        // 接收4字节的消息长度
-        uint32_t messageLength = 0;
-        int bytesRead = 0;
-
-        // 确保读取完整的4字节长度
-        while (bytesRead < 4)
+        metrics.add(Metrics::PARSE_FAILURES);
+        return false;
+    }
+    for (std::string_view inner : payloads)
+    {
+        if (!handleMessagePayload(inner, receivedAt))
         {
-            int received = socket().receiveBytes(
-                reinterpret_cast<char *>(&messageLength) + bytesRead,
-                4 - bytesRead);
+            return false;
+        }
+    }
+    return true;
+}
 
-            if (received <= 0)
-            {
-                if (bytesRead == 0 && received == 0)
-                {
-                    return nullptr;
-                }
-                throw std::runtime_error("连接中断，无法接收完整的消息长度");
-            }
+bool ChatConnection::handleMessagePayload(std::string_view payload, Metrics::Clock::time_point receivedAt)
+{
+    auto &metrics = Metrics::getInstance();
+    WireFormat format = Message::detectFormat(payload);
+    wireFormat_ = format;
+    if (format == WireFormat::JSON)
+    {
+        LOG_DEBUG("ChatConnection", "接收到JSON (" + std::to_string(payload.size()) + " 字节): " + std::string(payload));
+    }
 
-            bytesRead += received;
-        }
+    // 绝大多数帧是聊天消息，只取路由字段，content 留在接收缓冲区中随帧转发
+    ChatEnvelope envelope;
+    if (envelope.parse(payload))
+    {
+        metrics.messageIn(envelope.getType());
+        handleChatMessage(envelope);
+        metrics.recordSince(Metrics::RECEIVE_TO_ROUTE, receivedAt);
+        return true;
+    }
 
-        messageLength = ntohl(messageLength);
+    auto message = Message::parseMessage(payload);
+    if (!message)
+    {
+        metrics.add(Metrics::PARSE_FAILURES);
+        return false;
+    }
+    metrics.messageIn(message->getType());
+    handleMessage(*message);
+    return true;
+}
 
-        if (messageLength == 0)
+void ChatConnection::flushAck()
+{
+    if (lastReceivedId_ > lastAckedId_)
+    {
+        lastAckedId_ = lastReceivedId_;
+        sendMessage(MessageAck(lastAckedId_));
+    }
+}
+
+void ChatConnection::handleMessage(Message &message)
+{
+    // 处理不同类型的消息
+    switch (message.getType())
+    {
+    case MessageType::LOGIN_REQUEST:
+        if (isAuthenticated_)
         {
-            return nullptr; // 空消息
+            LOG_WARNING("ChatConnection", "Received login request from already authenticated user: " + account_);
+            return;
         }
-
-        if (messageLength > 10 * 1024 * 1024) // 10MB上限
+        if (loginPending_)
+        {
+            LOG_WARNING("ChatConnection", "Received login request while another login is pending from " + clientAddress_);
+            return;
+        }
+        handleLoginRequest(static_cast<LoginRequest &>(message));
+        break;
+    case MessageType::REGISTER_REQUEST:
+        if (isAuthenticated_)
         {
-            throw std::runtime_error("消息过大: " + std::to_string(messageLength) + " 字节");
+            LOG_WARNING("ChatConnection", "Received register request from already authenticated user: " + account_);
+            return;
         }
+        if (loginPending_)
+        {
+            LOG_WARNING("ChatConnection", "Received register request while a login is pending from " + clientAddress_);
+            return;
+        }
+        handleRegisterRequest(static_cast<RegisterRequest &>(message));
+        break;
+    case MessageType::ROOM_JOIN:
+    case MessageType::ROOM_LEAVE:
+        handleRoomRequest(static_cast<RoomRequest &>(message));
+        break;
+    case MessageType::HISTORY_REQUEST:
+        handleHistoryRequest(static_cast<HistoryRequest &>(message));
+        break;
+    case MessageType::USER_STATUS_UPDATE:
+        if (loginPending_)
+        {
+            // 登录结果返回前账号还在由认证线程写入，登出/离开要等结果返回后再处理
+            LOG_WARNING("ChatConnection", "Received user status update while a login is pending from " + clientAddress_);
+            return;
+        }
+        handleUserStatusUpdate(static_cast<UserStatusUpdate &>(message));
+        break;
+    case MessageType::HEARTBEAT:
+        // 收到帧时已刷新活动时间，心跳无需回复
+        break;
+    case MessageType::CAPABILITIES:
+        handleCapabilities(static_cast<CapabilitiesMessage &>(message));
+        break;
+    default:
+        LOG_WARNING("ChatConnection", "Unknown message type received: " + std::to_string(static_cast<int>(message.getType())));
+        break;
+    }
+}
+
+uint32_t ChatConnection::supportedCapabilities() const
+{
+    uint32_t supported = kCapabilityRetransmit | kCapabilityHeartbeat;
+    if (outbound_.limits().compressionThreshold > 0)
+    {
+        supported |= kCapabilityCompression;
+    }
+    if (outbound_.limits().batchFrames)
+    {
+        supported |= kCapabilityBatch;
+    }
+    return supported;
+}
+
+void ChatConnection::handleCapabilities(const CapabilitiesMessage &capabilities)
+{
+    uint32_t agreed = capabilities.getCapabilities() & supportedCapabilities();
 
-        std::vector<char> buffer(messageLength + 1);
-        bytesRead = 0;
+    // 支持该能力的对端解码器总能识别压缩帧和 BATCH 帧，回复与启用的先后无关
+    sendMessage(CapabilitiesMessage(agreed));
+    compressionThreshold_ = (agreed & kCapabilityCompression) ? outbound_.limits().compressionThreshold : 0;
+    batchFrames_ = (agreed & kCapabilityBatch) != 0;
+    LOG_DEBUG("ChatConnection", "与 " + clientAddress_ + " 协商的能力: " + std::to_string(agreed));
+}
 
-        while (bytesRead < messageLength)
-        {
-            int received = socket().receiveBytes(
-                buffer.data() + bytesRead,
-                messageLength - bytesRead);
+void ChatConnection::setDisconnected()
+{
+    isConnected_ = false;
+    // 关闭读方向以唤醒阻塞的读取线程或反应器，已排队的数据仍可发出
+    try
+    {
+        socket_.shutdownReceive();
+    }
+    catch (const Poco::Exception &)
+    {
+    }
+}
+
+// 取出下一帧的负载，负载指向接收缓冲区，在下一次调用前有效
+bool ChatConnection::receiveFrame(std::string_view &payload)
+{
+    if (!isConnected_)
+    {
+        return false;
+    }
 
-            if (received <= 0)
+    try
+    {
+        // 缓冲区中已有完整帧时直接取出，否则一次读入内核中已有的全部数据；
+        // 读取前先确认上一批处理过的消息
+        while (!decoder_.nextFrame(payload))
+        {
+            flushAck();
+            if (decoder_.readFrom(socket_) == FrameDecoder::ReadResult::CLOSED)
             {
-                throw std::runtime_error("连接中断，无法接收完整的消息");
+                if (decoder_.buffered() > 0)
+                {
+                    throw std::runtime_error("连接中断，无法接收完整的消息");
+                }
+                return false;
             }
-
-            bytesRead += received;
         }
-        buffer[messageLength] = '\0';
-        std::string jsonData(buffer.data(), messageLength);
-
-        logger.debug("接收到JSON (" + std::to_string(messageLength) + " 字节): " + jsonData);
-        return Message::parseMessage(jsonData);
+        return true;
     }
     catch (const std::exception &e)
     {
-        logger.error("接收消息失败: " + std::string(e.what()));
+        LOG_ERROR("ChatConnection", "接收消息失败: " + std::string(e.what()));
         isConnected_ = false;
-        return nullptr;
+        return false;
     }
 }
 
@@ -171,32 +324,94 @@ void ChatConnection::sendMessage(const Message &message)
     if (!isConnected_)
         return;
 
-    try
-    {
-        std::string jsonData = message.serialize();
-        auto &logger = Poco::Logger::get("ChatConnection");
+    sendFrame(Frame::create(message, wireFormat_));
+}
 
-        logger.debug("发送JSON (" + std::to_string(jsonData.length()) + " 字节): " + jsonData);
+bool ChatConnection::sendFrame(const FramePtr &frame)
+{
+    if (!isConnected_)
+        return false;
 
-        uint32_t messageLength = htonl(static_cast<uint32_t>(jsonData.length()));
+    if (frame->getFormat() == WireFormat::JSON)
+    {
+        LOG_DEBUG("ChatConnection", "发送JSON (" + std::to_string(frame->payload().length()) + " 字节): " + std::string(frame->payload()));
+    }
 
-        int sent = socket().sendBytes(&messageLength, sizeof(messageLength));
-        if (sent != sizeof(messageLength))
-        {
-            throw std::runtime_error("发送消息长度失败");
-        }
+    switch (outbound_.push(frame))
+    {
+    case OutboundQueue::PushResult::QUEUED:
+        Metrics::getInstance().messageOut(frame->getType());
+        break;
+    case OutboundQueue::PushResult::DROPPED:
+        Metrics::getInstance().messageOut(frame->getType());
+        LOG_DEBUG("ChatConnection", "出站队列超过高水位，已丢弃 " + clientAddress_ + " 的旧消息");
+        break;
+    case OutboundQueue::PushResult::QUEUE_FULL:
+        LOG_WARNING("ChatConnection", "Slow consumer " + clientAddress_ + " exceeded outbound high watermark, disconnecting.");
+        disconnectSlowConsumer();
+        return false;
+    case OutboundQueue::PushResult::CLOSED:
+        return false;
+    }
 
-        sent = socket().sendBytes(jsonData.c_str(), jsonData.length());
-        if (sent != jsonData.length())
+    std::lock_guard<std::mutex> lock(notifierMutex_);
+    if (writeNotifier_)
+    {
+        writeNotifier_();
+    }
+    return true;
+}
+
+void ChatConnection::writerLoop()
+{
+    // 每轮把队列中积压的帧合并为一次 writev 写出
+    FrameWriter writer(socket_);
+    std::vector<FramePtr> batch;
+    try
+    {
+        while (outbound_.popBatch(batch, 256, true))
         {
-            throw std::runtime_error("发送消息内容不完整");
+            writer.setCompressionThreshold(compressionThreshold_);
+            if (batchFrames_)
+            {
+                writer.enqueueBatched(batch);
+            }
+            else
+            {
+                for (const auto &frame : batch)
+                {
+                    writer.enqueue(frame);
+                }
+            }
+            batch.clear();
+            writer.flush();
         }
     }
+    catch (const Poco::TimeoutException &)
+    {
+        LOG_WARNING("ChatConnection", "Send to " + clientAddress_ + " timed out, disconnecting slow consumer.");
+        disconnectSlowConsumer();
+    }
     catch (const std::exception &e)
     {
-        auto &logger = Poco::Logger::get("ChatConnection");
-        logger.error("发送消息失败: " + std::string(e.what()));
+        LOG_ERROR("ChatConnection", "发送消息失败: " + std::string(e.what()));
         isConnected_ = false;
+        outbound_.close();
+        setDisconnected();
+    }
+}
+
+void ChatConnection::disconnectSlowConsumer()
+{
+    OutboundQueue::recordSlowConsumerDisconnect();
+    isConnected_ = false;
+    outbound_.close();
+    try
+    {
+        socket_.shutdown();
+    }
+    catch (const Poco::Exception &)
+    {
     }
 }
 
@@ -207,59 +422,67 @@ std::string ChatConnection::getClientAddress() const
 
 void ChatConnection::handleLoginRequest(const LoginRequest &loginRequest)
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
-    auto response = std::make_unique<LoginResponse>();
+    // 哈希和查找交给认证线程池，当前线程立即返回继续处理其他连接
+    loginPending_ = true;
+    if (!AuthService::getInstance().submit(handle_, loginRequest.getAccount(), loginRequest.getPassword()))
+    {
+        loginPending_ = false;
+        LOG_WARNING("ChatConnection", "Auth queue full, rejecting login from " + clientAddress_);
+        LoginResponse response(MessageStatus::FAILED, "", "", "服务器繁忙，请稍后重试");
+        sendMessage(response);
+    }
+}
 
-    account_ = loginRequest.getAccount();
-    auto &userManager = UserManager::getInstance();
-    if (userManager.authenticateUser(account_, loginRequest.getPassword()))
+void ChatConnection::finishLogin(bool success, const std::string &account, const std::string &username)
+{
+    LoginResponse response;
+
+    if (success)
     {
-        if (response)
         {
-            response->setStatus(MessageStatus::SUCCESS);
-            response->setAccount(account_);
-            std::string username = userManager.getUserByAccount(account_).username;
-            response->setUsername(username);
-            response->setMessage("登录成功");
+            std::lock_guard<std::mutex> lock(sessionMutex_);
+            account_ = account;
+            username_ = username;
         }
         isAuthenticated_ = true;
-        auto &connectionManager = ConnectionManager::getInstance();
-        connectionManager.authenticateConnection(this, account_);
-        logger.information("User " + account_ + " logged in successfully.");
+        response.setStatus(MessageStatus::SUCCESS);
+        response.setAccount(account);
+        response.setUsername(username);
+        response.setMessage("登录成功");
+        // 旧客户端忽略该字段；新客户端据此决定是否发送 CAPABILITIES 和 HEARTBEAT
+        response.setCapabilities(supportedCapabilities());
+        LOG_INFO("ChatConnection", "User " + account + " logged in successfully.");
+        Metrics::getInstance().add(Metrics::AUTH_SUCCESSES);
     }
     else
     {
-        logger.error("Authentication failed for user " + account_);
-        if (response)
-        {
-            response->setStatus(MessageStatus::FAILED);
-            response->setMessage("登录失败");
-        }
+        Metrics::getInstance().add(Metrics::AUTH_FAILURES);
+        LOG_ERROR("ChatConnection", "Authentication failed for user " + account);
+        response.setStatus(MessageStatus::FAILED);
+        response.setMessage("登录失败");
     }
+    loginPending_ = false;
+
     // 发送认证结果
-    if (response)
-    {
-        sendMessage(*response);
-    }
+    sendMessage(response);
 }
 
 void ChatConnection::handleRegisterRequest(const RegisterRequest &registerRequest)
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
     auto response = std::make_unique<RegisterResponse>();
 
     std::string username = registerRequest.getUsername();
     std::string password = registerRequest.getPassword();
     auto &userManager = UserManager::getInstance();
-    account_ = userManager.registerUser(username, password);
-    if (!account_.empty())
+    std::string account = userManager.registerUser(username, password);
+    if (!account.empty())
     {
         if (response)
         {
             response->setStatus(MessageStatus::SUCCESS);
-            response->setMessage("注册成功，您的账号是: " + account_ + "，请登录你的账号");
+            response->setMessage("注册成功，您的账号是: " + account + "，请登录你的账号");
         }
-        logger.information("User " + account_ + " registered successfully.");
+        LOG_INFO("ChatConnection", "User " + account + " registered successfully.");
     }
     else
     {
@@ -276,48 +499,219 @@ void ChatConnection::handleRegisterRequest(const RegisterRequest &registerReques
     }
 }
 
-void ChatConnection::handleChatMessage(const ChatMessage &chatMessage)
+void ChatConnection::handleChatMessage(ChatEnvelope &chatMessage)
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
+    if (!isAuthenticated_)
+    {
+        LOG_WARNING("ChatConnection", "Chat message from unauthenticated connection " + clientAddress_);
+        return;
+    }
+    // 重复的消息同样要确认，否则客户端会一直重发。只有带重发标记的消息才查重：
+    // 首次发送的消息即使 ID 与之前的相同（旧客户端的 ID 不保证唯一）也照常转发
+    auto &connectionManager = ConnectionManager::getInstance();
+    uint64_t clientId = chatMessage.getClientId();
+    lastReceivedId_ = std::max(lastReceivedId_, clientId);
+    if (clientId != 0 && chatMessage.isRetransmit() && connectionManager.wasForwarded(account_, clientId))
+    {
+        LOG_DEBUG("ChatConnection", "Duplicate message " + std::to_string(clientId) + " from " + account_ + " already forwarded, acknowledged only");
+        return;
+    }
+    if (chatMessage.isRoomMessage() && rooms_.count(chatMessage.getRoom()) == 0)
+    {
+        LOG_WARNING("ChatConnection", "Room message from " + clientAddress_ + " to unjoined room " + chatMessage.getRoom());
+        sendMessage(RoomResponse(MessageStatus::UNAUTHORIZED, chatMessage.getRoom(), "您不在该房间中"));
+        return;
+    }
+
+    if (!chatMessage.isBroadcastMessage() && !chatMessage.isRoomMessage() &&
+        !(chatMessage.isPrivateMessage() && !chatMessage.getReceiver().empty()))
+    {
+        LOG_WARNING("ChatConnection", "Received unsupported chat message type from " + clientAddress_);
+        return;
+    }
+
+    // 转发前由服务器统一分配消息 ID 和会话序号，发送者取自会话；客户端自带的值不可信也可能重复。
+    // ID、序号和写入历史在同一会话的互斥区内完成，历史记录按 ID 递增排列；
+    // 历史只入队，由后台线程成批落盘，生成的二进制帧在随后转发时复用
+    chatMessage.setSender(account_, username_);
+    std::string conversation = ConversationSequencer::conversationKey(chatMessage);
+    ConversationSequencer::getInstance().next(conversation, [&](uint64_t seq)
+                                              {
+        chatMessage.stamp();
+        chatMessage.setSeq(seq);
+        if (FramePtr frame = chatMessage.frame(WireFormat::BINARY))
+        {
+            HistoryStore::getInstance().append(conversation, chatMessage.getId(), frame->payload());
+        } });
 
-    if (chatMessage.isPrivateMessage() && chatMessage.getType() == MessageType::PRIVATE_MESSAGE)
+    std::string size = " (" + std::to_string(chatMessage.getContentSize()) + " bytes)";
+    if (chatMessage.isPrivateMessage())
     {
-        auto &connectionManager = ConnectionManager::getInstance();
         connectionManager.sendMessageToUser(chatMessage);
-        logger.information("Private message from " + chatMessage.getSender() + " to " + chatMessage.getReceiver() + ": " + chatMessage.getContent());
+        LOG_INFO("ChatConnection", "Private message from " + account_ + " to " + chatMessage.getReceiver() + size);
     }
-    else if (chatMessage.isBroadcastMessage() && chatMessage.getType() == MessageType::BROADCAST_MESSAGE)
+    else if (chatMessage.isBroadcastMessage())
     {
-        auto &connectionManager = ConnectionManager::getInstance();
         connectionManager.broadcastMessage(chatMessage, this);
-        logger.information("Broadcast message from " + chatMessage.getSender() + "[" + clientAddress_ + "]" + ": " + chatMessage.getContent());
+        LOG_INFO("ChatConnection", "Broadcast message from " + account_ + "[" + clientAddress_ + "]" + size);
     }
     else
     {
-        logger.warning("Received unsupported chat message type from " + clientAddress_);
+        connectionManager.sendMessageToRoom(chatMessage, this);
+        LOG_INFO("ChatConnection", "Room message from " + account_ + " to " + chatMessage.getRoom() + size);
+    }
+    if (clientId != 0)
+    {
+        connectionManager.recordForwarded(account_, clientId);
     }
 }
 
 void ChatConnection::handleUserStatusUpdate(const UserStatusUpdate &userStatusUpdate)
 {
-    auto &logger = Poco::Logger::get("ChatConnection");
     auto &connectionManager = ConnectionManager::getInstance();
 
     if (userStatusUpdate.getAction() == "leave")
     {
-        logger.information("User " + account_ + " has left the chat.");
+        LOG_INFO("ChatConnection", "User " + account_ + " has left the chat.");
         isConnected_ = false;
+        leaveAllRooms();
         connectionManager.removeConnection(this);
     }
     else if (userStatusUpdate.getAction() == "logout")
     {
-        logger.information("User " + account_ + " has logged out.");
+        LOG_INFO("ChatConnection", "User " + account_ + " has logged out.");
+        leaveAllRooms();
         connectionManager.unauthenticateConnection(this);
         isAuthenticated_ = false;
+        std::lock_guard<std::mutex> lock(sessionMutex_);
         account_.clear();
+        username_.clear();
+    }
+    else
+    {
+        LOG_WARNING("ChatConnection", "Received unsupported user status update: " + userStatusUpdate.getAction());
+    }
+}
+
+void ChatConnection::handleRoomRequest(const RoomRequest &roomRequest)
+{
+    const std::string &room = roomRequest.getRoom();
+
+    if (!isAuthenticated_)
+    {
+        sendMessage(RoomResponse(MessageStatus::UNAUTHORIZED, room, "请先登录"));
+        return;
+    }
+    if (room.empty() || room.size() > kMaxRoomNameLength)
+    {
+        sendMessage(RoomResponse(MessageStatus::INVALID_FORMAT, room, "房间名不能为空且不超过 64 字节"));
+        return;
+    }
+
+    auto &rooms = RoomRegistry::getInstance();
+    if (roomRequest.isJoin())
+    {
+        if (rooms_.count(room) == 0 && rooms_.size() >= kMaxRoomsPerConnection)
+        {
+            sendMessage(RoomResponse(MessageStatus::FAILED, room, "加入的房间数已达上限"));
+            return;
+        }
+        rooms.join(room, handle_);
+        rooms_.insert(room);
+        LOG_INFO("ChatConnection", "User " + account_ + " joined room " + room);
+        sendMessage(RoomResponse(MessageStatus::SUCCESS, room, "已加入房间 " + room));
+    }
+    else
+    {
+        if (rooms_.erase(room) == 0)
+        {
+            sendMessage(RoomResponse(MessageStatus::FAILED, room, "您不在该房间中"));
+            return;
+        }
+        rooms.leave(room, handle_);
+        LOG_INFO("ChatConnection", "User " + account_ + " left room " + room);
+        sendMessage(RoomResponse(MessageStatus::SUCCESS, room, "已离开房间 " + room));
+    }
+}
+
+void ChatConnection::handleHistoryRequest(const HistoryRequest &historyRequest)
+{
+    const std::string &target = historyRequest.getTarget();
+    if (!isAuthenticated_)
+    {
+        sendMessage(HistoryResponse(MessageStatus::UNAUTHORIZED, target));
+        return;
+    }
+
+    std::string conversation;
+    if (target.empty())
+    {
+        conversation = "broadcast";
+    }
+    else if (target[0] == '#')
+    {
+        // 只能查看已加入房间的历史
+        if (rooms_.count(target.substr(1)) == 0)
+        {
+            sendMessage(HistoryResponse(MessageStatus::UNAUTHORIZED, target));
+            return;
+        }
+        conversation = target;
     }
     else
     {
-        logger.warning("Received unsupported user status update: " + userStatusUpdate.getAction());
+        conversation = ConversationSequencer::privateKey(account_, target);
+    }
+
+    uint32_t limit = std::min(std::max<uint32_t>(historyRequest.getLimit(), 1), kMaxHistoryLimit);
+    HistoryStore::View view;
+    HistoryStore::getInstance().query(conversation, historyRequest.getBeforeId(), limit, view);
+
+    // 从最新的消息往前累计编码大小，放不下时只返回较新的部分并标记 has_more，
+    // 客户端以其中第一条的 ID 作为 before_id 继续翻页
+    WireFormat format = wireFormat_;
+    std::vector<ChatMessage> newestFirst;
+    size_t bytes = 0;
+    bool hasMore = false;
+    for (auto it = view.messages.rbegin(); it != view.messages.rend(); ++it)
+    {
+        auto message = Message::parseMessage(*it);
+        if (!message || !dynamic_cast<ChatMessage *>(message.get()))
+        {
+            continue;
+        }
+        // 二进制连接中内嵌消息的编码不超过存储的编码；JSON 连接按实际编码计算，转义可能使内容变长
+        size_t size = (format == WireFormat::BINARY ? it->size() : message->encode(format).size()) + 1;
+        if (size > kMaxHistoryBytes)
+        {
+            // 单条就超过上限的消息无法返回，跳过它以免后续翻页卡在这里
+            LOG_WARNING("ChatConnection", "History message " + std::to_string(message->getId()) + " in " + conversation + " is too large to return");
+            continue;
+        }
+        if (bytes + size > kMaxHistoryBytes)
+        {
+            hasMore = true;
+            break;
+        }
+        bytes += size;
+        newestFirst.push_back(std::move(static_cast<ChatMessage &>(*message)));
+    }
+
+    HistoryResponse response(MessageStatus::SUCCESS, target);
+    for (auto it = newestFirst.rbegin(); it != newestFirst.rend(); ++it)
+    {
+        response.addMessage(std::move(*it));
     }
-}
\ No newline at end of file
+    response.setHasMore(hasMore);
+    sendMessage(response);
+}
+
+void ChatConnection::leaveAllRooms()
+{
+    auto &rooms = RoomRegistry::getInstance();
+    for (const auto &room : rooms_)
+    {
+        rooms.leave(room, handle_);
+    }
+    rooms_.clear();
+}
@@ -1,34 +1,114 @@
 #pragma once
 
+#include "ChatEnvelope.h"
 #include "Message.h"
-#include <Poco/Net/TCPServerConnection.h>
+#include "Frame.h"
+#include "FrameDecoder.h"
+#include "Metrics.h"
+#include "OutboundQueue.h"
+#include "SlotMap.h"
 #include <Poco/Net/StreamSocket.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_set>
 
-class ChatConnection : public Poco::Net::TCPServerConnection
+// 一个客户端会话：保存认证状态并处理消息。
+// 由 ChatConnectionHandler（每连接一线程）或 ReactorConnectionHandler（事件驱动）驱动。
+// 总是由 shared_ptr 持有：广播快照中的引用可能比驱动它的线程或处理器活得更久
+class ChatConnection : public std::enable_shared_from_this<ChatConnection>
 {
 public:
     ChatConnection(const Poco::Net::StreamSocket &socket);
     virtual ~ChatConnection();
 
-    void run() override;
+    // 线程模式：阻塞读取并处理消息，直到连接关闭
+    void run();
+
+    // 事件驱动模式：由反应器在连接建立、收到完整消息和连接关闭时调用
+    void open();
+    // 处理一帧负载：聊天消息只解码路由字段后转发原始内容，其余消息完整解析；
+    // BATCH 帧拆开后逐条处理。解析失败返回 false
+    bool handlePayload(std::string_view payload);
+    // 一次读入的帧全部处理完后调用：有新处理的聊天消息时回复一条累计的 MESSAGE_ACK
+    void flushAck();
+    void close();
+
+    // 发送只是把帧放入出站队列，由连接自己的写者写入套接字，可在任意线程调用
     void sendMessage(const Message &message);
-    std::string getAccount() const { return account_; }
+    // 帧进入出站队列时返回 true；连接已关闭或因慢消费者被断开时返回 false
+    bool sendFrame(const FramePtr &frame);
+    OutboundQueue &outbound() { return outbound_; }
+    // 事件驱动模式下，有新帧入队时通知反应器注册可写事件
+    void setWriteNotifier(std::function<void()> notifier);
+
+    // ConnectionManager 分配的句柄，异步任务和路由用它找回仍然存活的连接
+    SlotHandle getHandle() const { return handle_; }
+    void setHandle(SlotHandle handle) { handle_ = handle; }
+    std::string getAccount() const
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex_);
+        return account_;
+    }
     bool isConnected() const { return isConnected_; }
     bool isAuthenticated() const { return isAuthenticated_; }
-    void setDisconnected() { isConnected_ = false; }
+    WireFormat getWireFormat() const { return wireFormat_; }
+    void setWireFormat(WireFormat format) { wireFormat_ = format; }
+    // 能力协商后的压缩阈值，0 表示未启用压缩；写者每轮写出前读取
+    size_t getCompressionThreshold() const { return compressionThreshold_.load(std::memory_order_relaxed); }
+    // 对端在能力协商中声明支持 BATCH 且服务器配置允许时为 true；未协商的对端不会收到 BATCH 帧
+    bool getBatchFrames() const { return batchFrames_.load(std::memory_order_relaxed); }
+    void setDisconnected();
+    // 最近一次收到帧的时间（steady_clock 毫秒），IdleReaper 据此判断连接是否空闲
+    int64_t getLastActivityMs() const { return lastActivityMs_.load(std::memory_order_relaxed); }
+
+    // 由 ConnectionManager 在认证线程上调用（不持有任何连接表锁），保存认证结果并回复客户端
+    void finishLogin(bool success, const std::string &account, const std::string &username);
 
     std::string getClientAddress() const;
 
 private:
+    Poco::Net::StreamSocket socket_;
+    SlotHandle handle_;
     std::string clientAddress_;
+    // 账号和昵称由认证线程在 finishLogin 中写入，其他线程通过 getAccount() 加锁读取；
+    // 连接自己的线程只在已认证或没有待完成的登录时直接访问，此时不会有并发写入
+    mutable std::mutex sessionMutex_;
     std::string account_;
-    bool isConnected_;
-    bool isAuthenticated_;
+    std::string username_; // 登录时确定，转发聊天消息时作为发送者昵称
+    std::atomic<bool> isConnected_;
+    std::atomic<bool> isAuthenticated_;
+    std::atomic<bool> loginPending_; // 登录请求已交给 AuthService，尚未返回结果
+    std::atomic<WireFormat> wireFormat_; // 跟随客户端最近一次使用的编码格式
+    std::atomic<int64_t> lastActivityMs_;
+    std::atomic<size_t> compressionThreshold_{0};
+    std::atomic<bool> batchFrames_{false};
+    FrameDecoder decoder_; // 线程模式下的接收缓冲区
+    OutboundQueue outbound_;
+    std::thread writerThread_;
+    std::mutex notifierMutex_; // close() 清空通知器后，不会再有线程回调已销毁的处理器
+    std::function<void()> writeNotifier_;
+    std::unordered_set<std::string> rooms_; // 已加入的房间，只在连接自己的线程中访问
+    uint64_t lastReceivedId_ = 0; // 已处理的最大客户端消息 ID，同样只在连接自己的线程中访问
+    uint64_t lastAckedId_ = 0;
+
+    void writerLoop();
+    void disconnectSlowConsumer();
 
-    void handleChatMessage(const ChatMessage &chatMessage);
+    bool handleMessagePayload(std::string_view payload, Metrics::Clock::time_point receivedAt);
+    void handleMessage(Message &message);
+    void handleChatMessage(ChatEnvelope &chatMessage);
     void handleLoginRequest(const LoginRequest &loginRequest);
     void handleRegisterRequest(const RegisterRequest &registerRequest);
     void handleUserStatusUpdate(const UserStatusUpdate &userStatusUpdate);
-    std::unique_ptr<Message> receiveMessage();
+    void handleRoomRequest(const RoomRequest &roomRequest);
+    void handleHistoryRequest(const HistoryRequest &historyRequest);
+    void handleCapabilities(const CapabilitiesMessage &capabilities);
+    // 按配置本服务器支持的能力位，登录成功时下发，协商时与客户端声明的取交集
+    uint32_t supportedCapabilities() const;
+    void leaveAllRooms();
+    bool receiveFrame(std::string_view &payload);
 };
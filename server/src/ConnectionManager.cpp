@@ -1,6 +1,10 @@
 #include "ConnectionManager.h"
+#include "AsyncLog.h"
 #include "ChatConnection.h"
-#include <Poco/Logger.h>
+#include "OfflineDelivery.h"
+#include "OfflineStore.h"
+#include "UserManager.h"
+#include "RoomRegistry.h"
 #include <algorithm>
 
 ConnectionManager &ConnectionManager::getInstance()
@@ -9,43 +13,91 @@ ConnectionManager &ConnectionManager::getInstance()
     return instance;
 }
 
-void ConnectionManager::addConnection(ChatConnection *connection)
+ConnectionManager::ConnectionManager()
+{
+    setShardCount(connections_->shardCount());
+}
+
+void ConnectionManager::setShardCount(size_t shards)
 {
+    slots_ = std::make_unique<ShardedSlotMap<ChatConnection *>>(shards);
+    connections_ = std::make_unique<ShardedRegistry<std::string, OnlineEntry>>(shards);
+    recentClientIds_ = std::make_unique<ShardedRegistry<std::string, RecentClientIds>>(shards);
+
+    auto empty = std::make_shared<const OnlineSnapshot>();
+    snapshots_.reset(new std::shared_ptr<const OnlineSnapshot>[connections_->shardCount()]);
+    for (size_t i = 0; i < connections_->shardCount(); ++i)
     {
-        std::unique_lock<std::shared_mutex> lock(connectionsMutex_);
-        unauthenticatedConnections_.push_back(connection);
+        snapshots_[i] = empty;
     }
+}
 
-    auto &logger = Poco::Logger::get("ConnectionManager");
-    logger.information("New connection added. Total connections: " + std::to_string(getConnectionCount()));
+std::shared_ptr<const OnlineSnapshot> ConnectionManager::getOnlineSnapshot(size_t shard) const
+{
+    return std::atomic_load(&snapshots_[shard]);
 }
 
-void ConnectionManager::authenticateConnection(ChatConnection *connection, const std::string &account)
+void ConnectionManager::publishSnapshot(const std::string &account, const std::unordered_map<std::string, OnlineEntry> &accounts)
 {
-    ChatConnection *oldConnection = nullptr;
+    // 成员变化远少于广播：写方重建本分片的列表（约 N/分片数），读方零拷贝
+    auto snapshot = std::make_shared<OnlineSnapshot>();
+    snapshot->reserve(accounts.size());
+    for (const auto &pair : accounts)
     {
-        std::unique_lock<std::shared_mutex> lock(connectionsMutex_);
+        snapshot->push_back(pair.second.connection->shared_from_this());
+    }
+    std::atomic_store(&snapshots_[connections_->shardIndex(account)], std::shared_ptr<const OnlineSnapshot>(std::move(snapshot)));
+}
 
-        // 将连接从未认证列表中移除
-        auto it = std::remove(unauthenticatedConnections_.begin(), unauthenticatedConnections_.end(), connection);
-        if (it != unauthenticatedConnections_.end())
-        {
-            unauthenticatedConnections_.erase(it, unauthenticatedConnections_.end());
-        }
-        // 检查是否已存在同一账号的连接
-        auto existingIt = connections_.find(account);
-        if (existingIt != connections_.end())
-        {
-            oldConnection = existingIt->second;
-        }
-        // 添加到已认证列表中
-        connections_[account] = connection;
+void ConnectionManager::addConnection(ChatConnection *connection)
+{
+    connection->setHandle(slots_->insert(connection));
+    ++connectionCount_;
+
+    LOG_INFO("ConnectionManager", "New connection added. Total connections: " + std::to_string(getConnectionCount()));
+}
+
+void ConnectionManager::completeLogin(SlotHandle handle, bool success, const std::string &account, const std::string &username)
+{
+    std::shared_ptr<ChatConnection> oldConnection; // 被顶下线的旧连接，持有引用以便在锁外通知
+
+    // 回复在任何锁之外入队：block 策略下入队可能等待，不能拖住同一分片上的连接、登录和路由。
+    // 先回复再登记，登录结果总排在转发给该账号的消息之前；登记前发给它的私聊进入离线收件箱，随后补发
+    std::shared_ptr<ChatConnection> newConnection = getConnection(handle);
+    if (!newConnection)
+    {
+        LOG_INFO("ConnectionManager", "Login result for closed connection " + std::to_string(handle.pack()) + " discarded");
+        return;
+    }
+    newConnection->finishLogin(success, account, username);
+    if (!success)
+    {
+        return;
+    }
+
+    // 连接关闭前总会先在同一槽位分片锁内释放自己的槽位，在该锁内登记不会留下已关闭连接的句柄
+    bool found = slots_->write(handle, [&](ChatConnection *connection)
+                               {
+        // 在账号表中登记句柄，并检查是否已存在同一账号的连接
+        connections_->write(account, [&](auto &accounts)
+                            {
+            auto existingIt = accounts.find(account);
+            if (existingIt != accounts.end())
+            {
+                oldConnection = existingIt->second.connection->shared_from_this();
+            }
+            accounts[account] = {handle, connection};
+            publishSnapshot(account, accounts); }); });
+
+    if (!found)
+    {
+        LOG_INFO("ConnectionManager", "Connection " + std::to_string(handle.pack()) + " closed before its login was registered");
+        return;
     }
 
-    if (oldConnection != nullptr)
+    if (oldConnection)
     {
-        auto &logger = Poco::Logger::get("ConnectionManager");
-        logger.warning("Account " + account + " already logged in. Kicking out old connection from " + oldConnection->getClientAddress());
+        LOG_WARNING("ConnectionManager", "Account " + account + " already logged in. Kicking out old connection from " + oldConnection->getClientAddress());
 
         try
         {
@@ -57,136 +109,297 @@ void ConnectionManager::authenticateConnection(ChatConnection *connection, const
         }
         catch (const std::exception &e)
         {
-            logger.error("Failed to notify old connection: " + std::string(e.what()));
+            LOG_ERROR("ConnectionManager", "Failed to notify old connection: " + std::string(e.what()));
         }
     }
 
-    auto &logger = Poco::Logger::get("ConnectionManager");
-    logger.information("Connection authenticated for account: " + account);
+    LOG_INFO("ConnectionManager", "Connection authenticated for account: " + account);
+    // 补发可能要等出站队列排空，交给独立的线程，不占用认证线程
+    OfflineDelivery::getInstance().submit(handle);
 }
 
-void ConnectionManager::removeConnection(ChatConnection *connection)
+bool ConnectionManager::deliverOfflineMessages(const std::shared_ptr<ChatConnection> &connection)
 {
-    // 从已认证连接中移除
-    if (connection->isAuthenticated())
-    {
+    const OutboundLimits &limits = connection->outbound().limits();
+    constexpr size_t kBatchSize = 256;
+
+    auto result = OfflineStore::getInstance().deliver(connection->getAccount(), kBatchSize, [&](const std::vector<std::string_view> &batch)
+                                                      {
+        WireFormat format = connection->getWireFormat();
+        OutboundQueue &outbound = connection->outbound();
+        size_t accepted = 0;
+        for (std::string_view payload : batch)
         {
-            std::unique_lock<std::shared_mutex> lock(connectionsMutex_);
-            auto it = std::find_if(connections_.begin(), connections_.end(),
-                                   [connection](const auto &pair)
-                                   { return pair.second == connection; });
-            if (it != connections_.end())
+            // 收件箱保存的是私聊消息的二进制编码，二进制连接直接转发原始字节
+            FramePtr frame;
+            if (format == WireFormat::BINARY)
             {
-                connections_.erase(it);
+                frame = Frame::fromPayload(payload, MessageType::PRIVATE_MESSAGE);
             }
-        }
-        auto &logger = Poco::Logger::get("ConnectionManager");
-        logger.information("Connection removed for authenticated user: " + connection->getClientAddress() + " Total connections: " + std::to_string(getConnectionCount()));
-    }
-    // 从未认证连接中移除
-    else
-    {
-        {
-            std::unique_lock<std::shared_mutex> lock(connectionsMutex_);
-            auto it = std::remove(unauthenticatedConnections_.begin(), unauthenticatedConnections_.end(), connection);
-            if (it != unauthenticatedConnections_.end())
+            else if (auto message = Message::parseMessage(payload))
+            {
+                frame = Frame::create(*message, format);
+            }
+            else
+            {
+                // 无法解码的记录不会因为重试变好，视为已处理
+                ++accepted;
+                continue;
+            }
+
+            // 入队后会超过高水位时先等队列回落到低水位，不触发慢消费者策略：
+            // DROP_OLDEST 下超过高水位会丢掉刚补发的旧帧，其余策略会断开连接。
+            // 在队列的条件变量上等写者取走数据，最多等待 blockTimeout，超时后整批稍后重试
+            if (outbound.bytes() + frame->payload().size() > limits.highWatermark &&
+                !outbound.waitWritable(limits.blockTimeout))
+            {
+                break;
+            }
+            if (!connection->sendFrame(frame))
             {
-                unauthenticatedConnections_.erase(it, unauthenticatedConnections_.end());
+                break;
             }
+            ++accepted;
         }
-        auto &logger = Poco::Logger::get("ConnectionManager");
-        logger.information("Connection removed for unauthenticated user: " + connection->getClientAddress() + " Total connections: " + std::to_string(getConnectionCount()));
+        return accepted; });
+
+    if (result.delivered > 0)
+    {
+        LOG_INFO("ConnectionManager", "Delivered " + std::to_string(result.delivered) + " offline messages to " + connection->getAccount());
     }
+    return result.complete;
 }
 
-void ConnectionManager::unauthenticateConnection(ChatConnection *connection)
+bool ConnectionManager::wasForwarded(const std::string &account, uint64_t clientId) const
+{
+    return recentClientIds_->read(account, [&](const auto &accounts)
+                                  {
+        auto it = accounts.find(account);
+        return it != accounts.end() && it->second.ids.count(clientId) > 0; });
+}
+
+void ConnectionManager::recordForwarded(const std::string &account, uint64_t clientId)
+{
+    // 客户端 ID 不要求单调，也可能与同一账号其他设备的 ID 交错，只按精确值记录
+    recentClientIds_->write(account, [&](auto &accounts)
+                            {
+        RecentClientIds &recent = accounts[account];
+        if (!recent.ids.insert(clientId).second)
+        {
+            return;
+        }
+        recent.order.push_back(clientId);
+        if (recent.order.size() > kRecentClientIds)
+        {
+            recent.ids.erase(recent.order.front());
+            recent.order.pop_front();
+        } });
+}
+
+SlotHandle ConnectionManager::findHandle(const std::string &account) const
 {
+    SlotHandle handle;
+    connections_->read(account, [&](const auto &accounts)
+                       {
+        auto it = accounts.find(account);
+        if (it != accounts.end())
+        {
+            handle = it->second.handle;
+        } });
+    return handle;
+}
+
+void ConnectionManager::storeOfflineMessage(const ChatEnvelope &message)
+{
+    FramePtr frame = message.frame(WireFormat::BINARY);
+    switch (frame ? OfflineStore::getInstance().enqueue(message.getReceiver(), frame->payload()) : OfflineStore::EnqueueResult::FAILED)
     {
-        std::unique_lock<std::shared_mutex> lock(connectionsMutex_);
-        auto it = connections_.find(connection->getAccount());
-        if (it != connections_.end())
+    case OfflineStore::EnqueueResult::STORED:
+    {
+        LOG_INFO("ConnectionManager", "User " + message.getReceiver() + " is offline, message stored for later delivery");
+        // 入箱不持有分片锁，接收方可能恰好在判定离线之后登录，而它的补发已经读过收件箱。
+        // 入箱后再查一次：此时仍查不到说明登录在入箱之后登记，登录后提交的补发一定能看到这条消息
+        SlotHandle handle = findHandle(message.getReceiver());
+        if (!handle.isNull())
         {
-            connections_.erase(it);
-            unauthenticatedConnections_.push_back(connection);
+            OfflineDelivery::getInstance().submit(handle);
         }
+        break;
+    }
+    case OfflineStore::EnqueueResult::INBOX_FULL:
+        LOG_WARNING("ConnectionManager", "Offline inbox of " + message.getReceiver() + " is full, message dropped");
+        break;
+    case OfflineStore::EnqueueResult::FAILED:
+        LOG_ERROR("ConnectionManager", "Failed to store offline message for " + message.getReceiver());
+        break;
+    }
+}
+
+void ConnectionManager::removeConnection(ChatConnection *connection)
+{
+    // 与 completeLogin 相同的加锁顺序：先槽位分片，再账号分片。
+    // 槽位释放后代号递增，仍持有旧句柄的路由和认证结果都会查找失败
+    SlotHandle handle = connection->getHandle();
+    bool wasAuthenticated = false;
+    bool removed = slots_->erase(handle, [&](ChatConnection *)
+                                 {
+        const std::string account = connection->getAccount();
+        connections_->write(account, [&](auto &accounts)
+                            {
+            auto it = accounts.find(account);
+            if (it != accounts.end() && it->second.handle == handle)
+            {
+                accounts.erase(it);
+                publishSnapshot(account, accounts);
+                wasAuthenticated = true;
+            } }); });
+    if (removed)
+    {
+        --connectionCount_;
     }
 
-    auto &logger = Poco::Logger::get("ConnectionManager");
-    logger.information("Connection unauthenticated for user: " + connection->getClientAddress() + " Total connections: " + std::to_string(getConnectionCount()));
+    LOG_INFO("ConnectionManager", std::string("Connection removed for ") + (wasAuthenticated ? "authenticated" : "unauthenticated") +
+                       " user: " + connection->getClientAddress() + " Total connections: " + std::to_string(getConnectionCount()));
 }
 
-void ConnectionManager::broadcastMessage(const ChatMessage &message, ChatConnection *sender)
+void ConnectionManager::unauthenticateConnection(ChatConnection *connection)
 {
-    std::vector<ChatConnection *> targetConnections;
+    // 连接保留在槽位表中，只从账号表移除；句柄不变
+    connections_->write(connection->getAccount(), [&](auto &accounts)
+                        {
+        auto it = accounts.find(connection->getAccount());
+        if (it != accounts.end() && it->second.handle == connection->getHandle())
+        {
+            accounts.erase(it);
+            publishSnapshot(connection->getAccount(), accounts);
+        } });
+
+    LOG_INFO("ConnectionManager", "Connection unauthenticated for user: " + connection->getClientAddress() + " Total connections: " + std::to_string(getConnectionCount()));
+}
 
+void ConnectionManager::broadcastMessage(const ChatEnvelope &message, ChatConnection *sender)
+{
+    // 直接遍历各分片当前发布的快照：不加锁、不复制，与登录和断开完全并行。
+    // 每种线路格式只编码一次，所有接收者共享同一帧
+    size_t recipients = 0;
+    for (size_t shard = 0; shard < connections_->shardCount(); ++shard)
     {
-        std::shared_lock<std::shared_mutex> lock(connectionsMutex_);
-        for (const auto &pair : connections_)
+        std::shared_ptr<const OnlineSnapshot> snapshot = getOnlineSnapshot(shard);
+        for (const auto &connection : *snapshot)
         {
-            ChatConnection *connection = pair.second;
-            if (connection != sender && connection->isConnected())
+            if (connection.get() == sender || !connection->isConnected())
+            {
+                continue;
+            }
+            try
+            {
+                FramePtr frame = message.frame(connection->getWireFormat());
+                if (frame)
+                {
+                    connection->sendFrame(frame);
+                    ++recipients;
+                }
+            }
+            catch (const std::exception &e)
             {
-                targetConnections.push_back(connection);
+                LOG_ERROR("ConnectionManager", "Failed to send message to " + connection->getClientAddress() + ": " + e.what());
             }
         }
     }
 
-    auto &logger = Poco::Logger::get("ConnectionManager");
-    logger.information("Broadcasting message to " + std::to_string(targetConnections.size()) + " connections");
+    LOG_INFO("ConnectionManager", "Broadcast message to " + std::to_string(recipients) + " connections");
+}
+
+void ConnectionManager::sendMessageToUser(const ChatEnvelope &message)
+{
+    LOG_INFO("ConnectionManager", "Sending message to user: " + message.getReceiver());
 
-    for (ChatConnection *connection : targetConnections)
+    // 账号表只用来取句柄；发送时再按句柄校验，接收方在这之间断开时查找失败而不是访问已释放的连接。
+    // 分片锁内只查句柄，账号查询和离线入箱都在锁外进行，磁盘写入不会挡住同一分片上的登录和路由
+    SlotHandle handle = findHandle(message.getReceiver());
+    if (handle.isNull())
     {
-        try
-        {
-            connection->sendMessage(message);
-        }
-        catch (const std::exception &e)
+        if (UserManager::getInstance().getUserByAccount(message.getReceiver()).account.empty())
         {
-            logger.error("Failed to send message to " + connection->getClientAddress() + ": " + e.what());
+            LOG_WARNING("ConnectionManager", "No such user: " + message.getReceiver());
+            return;
         }
+        storeOfflineMessage(message);
+        return;
     }
-}
-void ConnectionManager::sendMessageToUser(const ChatMessage &message)
-{
-    ChatConnection *connection = nullptr;
+
+    // 只在槽位锁内取得引用，入队在锁外进行：block 策略下入队可能等待
+    std::shared_ptr<ChatConnection> connection = getConnection(handle);
+    if (!connection)
+    {
+        LOG_WARNING("ConnectionManager", "Connection for user " + message.getReceiver() + " closed before delivery.");
+        storeOfflineMessage(message);
+        return;
+    }
+    if (!connection->isConnected())
+    {
+        LOG_WARNING("ConnectionManager", "Connection for user " + message.getReceiver() + " is not connected.");
+        return;
+    }
+    try
     {
-        std::shared_lock<std::shared_mutex> lock(connectionsMutex_);
-        auto it = connections_.find(message.getReceiver());
-        if (it != connections_.end())
+        if (FramePtr frame = message.frame(connection->getWireFormat()))
         {
-            connection = it->second;
+            connection->sendFrame(frame);
         }
     }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("ConnectionManager", "Failed to send message to " + connection->getClientAddress() + ": " + e.what());
+    }
+}
 
-    auto &logger = Poco::Logger::get("ConnectionManager");
-    logger.information("Sending message to user: " + message.getReceiver());
+void ConnectionManager::sendMessageToRoom(const ChatEnvelope &message, ChatConnection *sender)
+{
+    std::vector<SlotHandle> members;
+    RoomRegistry::getInstance().getMembers(message.getRoom(), members);
 
-    if (connection != nullptr && connection->isConnected())
+    // 与广播相同，每种线路格式只编码一次；成员句柄逐个校验，已断开的成员直接跳过
+    size_t recipients = 0;
+    for (SlotHandle member : members)
     {
-        if (connection->isConnected())
+        if (sender && member == sender->getHandle())
         {
-            try
-            {
-                connection->sendMessage(message);
-            }
-            catch (const std::exception &e)
+            continue;
+        }
+        std::shared_ptr<ChatConnection> connection = getConnection(member);
+        if (!connection || !connection->isConnected())
+        {
+            continue;
+        }
+        try
+        {
+            FramePtr frame = message.frame(connection->getWireFormat());
+            if (frame)
             {
-                logger.error("Failed to send message to " + connection->getClientAddress() + ": " + e.what());
+                connection->sendFrame(frame);
+                ++recipients;
             }
         }
-        else
+        catch (const std::exception &e)
         {
-            logger.warning("Connection for user " + message.getReceiver() + " is not connected.");
+            LOG_ERROR("ConnectionManager", "Failed to send message to " + connection->getClientAddress() + ": " + e.what());
         }
     }
-    else
-    {
-        logger.warning("No connection found for user: " + message.getReceiver());
-    }
+
+    LOG_INFO("ConnectionManager", "Room " + message.getRoom() + " message delivered to " + std::to_string(recipients) + " members");
 }
 
 size_t ConnectionManager::getConnectionCount() const
 {
-    std::shared_lock<std::shared_mutex> lock(connectionsMutex_);
-    return connections_.size() + unauthenticatedConnections_.size();
+    return connectionCount_.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<ChatConnection> ConnectionManager::getConnection(SlotHandle handle) const
+{
+    // 槽位锁内连接不会被移除；析构已经开始的连接 lock() 得到空指针
+    std::shared_ptr<ChatConnection> connection;
+    slots_->read(handle, [&](ChatConnection *const &entry)
+                 { connection = entry->weak_from_this().lock(); });
+    return connection;
 }
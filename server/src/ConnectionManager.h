@@ -1,36 +1,102 @@
 #pragma once
 
+#include "ChatEnvelope.h"
 #include "Message.h"
+#include "ShardedRegistry.h"
+#include "SlotMap.h"
 #include <Poco/Net/TCPServerConnection.h>
 #include <Poco/Net/StreamSocket.h>
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <vector>
-#include <mutex>
-#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 class ChatConnection;
 
+// 某个分片内在线（已认证）连接的不可变快照，发布后只读
+using OnlineSnapshot = std::vector<std::shared_ptr<ChatConnection>>;
+
 class ConnectionManager
 {
 public:
     static ConnectionManager &getInstance();
 
+    // 为连接分配句柄并登记；句柄在连接移除前一直有效
     void addConnection(ChatConnection *connection);
-    void authenticateConnection(ChatConnection *connection, const std::string &account);
+    // AuthService 工作线程调用：句柄仍有效时在锁外投递登录结果，成功时再在槽位锁内登记账号；
+    // 连接已关闭（句柄失效）时丢弃结果
+    void completeLogin(SlotHandle handle, bool success, const std::string &account, const std::string &username);
     void removeConnection(ChatConnection *connection);
     void unauthenticateConnection(ChatConnection *connection);
-    void broadcastMessage(const ChatMessage &message, ChatConnection *sender = nullptr);
-    void sendMessageToUser(const ChatMessage &message);
+    // 路由只使用信封中的路由字段，按接收方格式取信封生成的帧（每种格式只编码一次）
+    void broadcastMessage(const ChatEnvelope &message, ChatConnection *sender = nullptr);
+    // 接收方不在线时存入其离线收件箱，登录后补发
+    void sendMessageToUser(const ChatEnvelope &message);
+    // 只投递给房间成员（不含发送者），开销与房间大小成正比
+    void sendMessageToRoom(const ChatEnvelope &message, ChatConnection *sender);
 
     size_t getConnectionCount() const;
+    // 按句柄取得仍然打开的连接，句柄已失效时返回空
+    std::shared_ptr<ChatConnection> getConnection(SlotHandle handle) const;
+    // 账号最近转发过的客户端消息 ID（跨连接保留，每个账号只记最近 kRecentClientIds 条）。
+    // 只对带重发标记的消息查询：已转发过的是确认丢失后重连重发的，调用方只确认不再转发
+    bool wasForwarded(const std::string &account, uint64_t clientId) const;
+    // 路由完成后登记，被拒绝的消息不登记，客户端修正后可以用同一 ID 重发
+    void recordForwarded(const std::string &account, uint64_t clientId);
+    // OfflineDelivery 工作线程调用：把离线收件箱中的消息按出站队列的余量放入连接，
+    // 连接已关闭、队列长时间不回落或收件箱正由另一次登录补发时返回 false，未发出的消息留在收件箱中
+    bool deliverOfflineMessages(const std::shared_ptr<ChatConnection> &connection);
+
+    // 分片数只能在接受连接之前设置
+    void setShardCount(size_t shards);
+
+    // 当前在线连接快照，无锁读取；快照持有连接的引用，遍历期间连接不会被销毁
+    std::shared_ptr<const OnlineSnapshot> getOnlineSnapshot(size_t shard) const;
 
 private:
-    ConnectionManager() = default;
+    ConnectionManager();
     ~ConnectionManager() = default;
+
+    // 在线账号表的值：路由用句柄在发送时校验连接是否仍然存活；
+    // 指针只在持有账号分片锁时使用（连接移除前总会先从账号表中删除自己）
+    struct OnlineEntry
+    {
+        SlotHandle handle;
+        ChatConnection *connection;
+    };
+
+    // 远大于客户端发送窗口（256 条），重发的消息一定还在记录中
+    static constexpr size_t kRecentClientIds = 1024;
+
+    // 按登记顺序淘汰最早的 ID
+    struct RecentClientIds
+    {
+        std::deque<uint64_t> order;
+        std::unordered_set<uint64_t> ids;
+    };
+
+    // 在账号分片的写锁内调用，按分片当前内容重建并原子替换快照
+    void publishSnapshot(const std::string &account, const std::unordered_map<std::string, OnlineEntry> &accounts);
+    // 只在账号分片的读锁内取句柄，不在线时返回空句柄
+    SlotHandle findHandle(const std::string &account) const;
+    void storeOfflineMessage(const ChatEnvelope &message);
     ConnectionManager(const ConnectionManager &) = delete;
     ConnectionManager &operator=(const ConnectionManager &) = delete;
 
-    mutable std::shared_mutex connectionsMutex_;
-    mutable std::unordered_map<std::string, ChatConnection *> connections_;
-    mutable std::vector<ChatConnection *> unauthenticatedConnections_;
+    // 所有打开的连接都在槽位表中，由句柄 O(1) 定位；已认证连接另按账号分片登记句柄。
+    // 需要同时持有两类锁时，总是先锁槽位分片再锁账号分片
+    std::unique_ptr<ShardedSlotMap<ChatConnection *>> slots_ =
+        std::make_unique<ShardedSlotMap<ChatConnection *>>();
+    std::unique_ptr<ShardedRegistry<std::string, OnlineEntry>> connections_ =
+        std::make_unique<ShardedRegistry<std::string, OnlineEntry>>();
+    // 每个账号最近转发过的客户端消息 ID，连接断开后保留，只在内存中
+    std::unique_ptr<ShardedRegistry<std::string, RecentClientIds>> recentClientIds_ =
+        std::make_unique<ShardedRegistry<std::string, RecentClientIds>>();
+    std::atomic<size_t> connectionCount_{0};
+
+    // 与 connections_ 的分片一一对应，通过 std::atomic_load/atomic_store 读写（RCU 风格）
+    std::unique_ptr<std::shared_ptr<const OnlineSnapshot>[]> snapshots_;
 };
@@ -0,0 +1,120 @@
+#include "ConversationSequencer.h"
+#include "ChatEnvelope.h"
+#include "HistoryStore.h"
+#include "IdGenerator.h"
+#include "Message.h"
+#include <mutex>
+
+namespace
+{
+    // 淘汰空闲会话的最小间隔，扫描整张表的开销按新会话均摊
+    constexpr int64_t kSweepIntervalMs = 60 * 1000;
+
+    // ChatMessage 和 ChatEnvelope 的路由字段同名
+    template <typename Chat>
+    std::string keyOf(const Chat &message)
+    {
+        if (message.isBroadcastMessage())
+        {
+            return "broadcast";
+        }
+        if (message.isRoomMessage())
+        {
+            return '#' + message.getRoom();
+        }
+        return ConversationSequencer::privateKey(message.getSender(), message.getReceiver());
+    }
+}
+
+ConversationSequencer &ConversationSequencer::getInstance()
+{
+    static ConversationSequencer instance;
+    return instance;
+}
+
+std::string ConversationSequencer::conversationKey(const ChatMessage &message)
+{
+    return keyOf(message);
+}
+
+std::string ConversationSequencer::conversationKey(const ChatEnvelope &message)
+{
+    return keyOf(message);
+}
+
+std::string ConversationSequencer::privateKey(const std::string &a, const std::string &b)
+{
+    return a < b ? a + '|' + b : b + '|' + a;
+}
+
+void ConversationSequencer::next(const std::string &conversation, const std::function<void(uint64_t seq)> &commit)
+{
+    int64_t now = static_cast<int64_t>(IdGenerator::nowMs());
+    while (true)
+    {
+        {
+            // 持有读锁期间计数器不会被淘汰
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = sequences_.find(conversation);
+            if (it != sequences_.end())
+            {
+                Counter &counter = it->second;
+                std::lock_guard<std::mutex> serial(counter.mutex);
+                counter.lastUsedMs.store(now, std::memory_order_relaxed);
+                commit(counter.seq.fetch_add(1, std::memory_order_relaxed) + 1);
+                return;
+            }
+        }
+
+        // 新会话或已被淘汰的会话才需要写锁：从历史中已提交的最大序号继续，重启或淘汰后序号不会回到 1。
+        // 登记后回到读锁下分配，commit 不在写锁内执行
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (now - lastSweepMs_ >= kSweepIntervalMs)
+        {
+            lastSweepMs_ = now;
+            evictIdle(now);
+        }
+        auto inserted = sequences_.try_emplace(conversation);
+        Counter &counter = inserted.first->second;
+        if (inserted.second)
+        {
+            counter.seq.store(HistoryStore::getInstance().getLastSeq(conversation), std::memory_order_relaxed);
+        }
+        counter.lastUsedMs.store(now, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ConversationSequencer::current(const std::string &conversation) const
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = sequences_.find(conversation);
+        if (it != sequences_.end())
+        {
+            return it->second.seq.load(std::memory_order_relaxed);
+        }
+    }
+    return HistoryStore::getInstance().getLastSeq(conversation);
+}
+
+size_t ConversationSequencer::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return sequences_.size();
+}
+
+void ConversationSequencer::evictIdle(int64_t nowMs)
+{
+    // 写锁排除了读锁下的并发递增；空闲会话的消息早已写入历史，再次使用时可以从历史恢复
+    for (auto it = sequences_.begin(); it != sequences_.end();)
+    {
+        if (nowMs - it->second.lastUsedMs.load(std::memory_order_relaxed) > idleMs_)
+        {
+            it = sequences_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+class ChatMessage;
+class ChatEnvelope;
+
+// 为每个会话分配单调递增的序号：广播共用一个会话，房间各自一个会话，私聊按双方账号（有序）区分。
+// 客户端和存储可以据此排序、去重，而不必比较时间戳。
+// 计数器只在内存中：会话首次使用（包括重启后）时从聊天历史中已提交的最大序号继续，
+// 长时间没有消息的会话被淘汰，再次使用时同样从历史恢复，表项数只随活跃会话数增长
+class ConversationSequencer
+{
+public:
+    static ConversationSequencer &getInstance();
+
+    // 会话键：广播为 "broadcast"，房间为 '#' + 房间名，私聊为较小账号 + '|' + 较大账号
+    static std::string conversationKey(const ChatMessage &message);
+    static std::string conversationKey(const ChatEnvelope &message);
+    static std::string privateKey(const std::string &a, const std::string &b);
+
+    // 在会话的互斥区内分配下一个序号并调用 commit(seq)：调用方在其中分配消息 ID 并写入历史队列，
+    // 同一会话的消息 ID、序号和历史记录的先后顺序一致，历史可以按 ID 二分查找翻页起点。
+    // commit 只应做编码和入队这类短操作，不能再进入同一会话
+    void next(const std::string &conversation, const std::function<void(uint64_t seq)> &commit);
+    uint64_t current(const std::string &conversation) const;
+    size_t size() const;
+
+    // 空闲超过 idleMs 的会话在下次有新会话加入时被淘汰；必须远大于消息从分配序号到写入历史的延迟
+    void setIdleMs(int64_t idleMs) { idleMs_ = idleMs; }
+
+private:
+    struct Counter
+    {
+        std::mutex mutex; // 同一会话的序号分配和 commit 串行执行
+        std::atomic<uint64_t> seq{0};
+        std::atomic<int64_t> lastUsedMs{0};
+    };
+
+    ConversationSequencer() = default;
+    ConversationSequencer(const ConversationSequencer &) = delete;
+    ConversationSequencer &operator=(const ConversationSequencer &) = delete;
+
+    // 在写锁内调用
+    void evictIdle(int64_t nowMs);
+
+    mutable std::shared_mutex mutex_;
+    // 节点式容器，插入新会话不会移动已有计数器，读锁下可直接原子递增
+    std::unordered_map<std::string, Counter> sequences_;
+    int64_t idleMs_ = 3600 * 1000;
+    int64_t lastSweepMs_ = 0; // 只在写锁内访问
+};
@@ -0,0 +1,744 @@
+#include "HistoryStore.h"
+#include "AsyncLog.h"
+#include "BinaryCodec.h"
+#include "Message.h"
+#include "RecordIO.h"
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/SharedMemory.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    const std::string kSegmentPrefix = "history-";
+    const std::string kSegmentSuffix = ".seg";
+    const std::string kIndexSuffix = ".idx";
+    // 索引文件格式版本，写在首条记录中
+    constexpr uint64_t kIndexVersion = 1;
+    // 每个会话每隔多少条消息记录一个检查点，按 ID 查询时最多多走这么多步
+    constexpr uint64_t kCheckpointInterval = 32;
+    // 组提交队列的积压上限，磁盘跟不上时丢弃历史而不是拖住转发线程
+    constexpr size_t kMaxPending = 65536;
+    // 位置中的偏移为 32 位
+    constexpr size_t kMaxSegmentBytes = size_t(1) << 31;
+
+    std::string segmentName(uint32_t index, const std::string &suffix = kSegmentSuffix)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%08u", index);
+        return kSegmentPrefix + name + suffix;
+    }
+
+    // 文件名为 history-<8位序号><suffix> 时取出序号
+    bool parseName(const std::string &name, const std::string &suffix, uint32_t &index)
+    {
+        if (name.size() != segmentName(0, suffix).size() || name.compare(0, kSegmentPrefix.size(), kSegmentPrefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            return false;
+        }
+        index = static_cast<uint32_t>(std::strtoul(name.c_str() + kSegmentPrefix.size(), nullptr, 10));
+        return true;
+    }
+
+    // 解析记录负载：会话键 + 上一条记录位置（分段下标+1，0 表示没有）+ 消息的二进制编码
+    bool decodeRecord(std::string_view payload, std::string_view &conversation, uint64_t &prevSegment,
+                      uint64_t &prevOffset, std::string_view &message, uint64_t &id)
+    {
+        BinaryReader reader(payload.data(), payload.size());
+        if (!reader.readString(conversation) || !reader.readVarUInt(prevSegment) || !reader.readVarUInt(prevOffset) || reader.remaining() == 0)
+        {
+            return false;
+        }
+        message = payload.substr(payload.size() - reader.remaining());
+
+        // 消息编码头部：标识字节、类型、ID
+        BinaryReader header(message.data(), message.size());
+        uint8_t magic = 0;
+        uint8_t type = 0;
+        return header.readByte(magic) && magic == kBinaryMagic && header.readByte(type) && header.readVarUInt(id);
+    }
+
+    // 从聊天消息的二进制编码中取出会话序号，字段顺序见 ChatMessage::encodeBinary
+    uint64_t sequenceOf(std::string_view message)
+    {
+        BinaryReader reader(message.data(), message.size());
+        uint8_t magic = 0;
+        uint8_t type = 0;
+        uint64_t id = 0;
+        uint64_t timestamp = 0;
+        std::string_view field;
+        uint64_t seq = 0;
+        bool ok = reader.readByte(magic) && reader.readByte(type) && reader.readVarUInt(id) && reader.readVarUInt(timestamp) &&
+                  reader.readString(field) && reader.readString(field) && reader.readString(field) && reader.readString(field) &&
+                  reader.readVarUInt(seq);
+        return ok ? seq : 0;
+    }
+}
+
+struct HistoryStore::Segment
+{
+    std::string path;
+    std::unique_ptr<Poco::SharedMemory> mapping;
+    const char *data = nullptr;
+    size_t capacity = 0;
+    // 已提交的字节数，只在持有 indexMutex_ 写锁时增长
+    size_t committed = 0;
+};
+
+HistoryStore &HistoryStore::getInstance()
+{
+    static HistoryStore instance;
+    return instance;
+}
+
+std::unique_ptr<HistoryStore> HistoryStore::create()
+{
+    return std::unique_ptr<HistoryStore>(new HistoryStore());
+}
+
+HistoryStore::HistoryStore()
+{
+}
+
+HistoryStore::~HistoryStore()
+{
+    stop();
+}
+
+std::shared_ptr<HistoryStore::Segment> HistoryStore::openSegment(uint32_t index, bool create)
+{
+    auto segment = std::make_shared<Segment>();
+    segment->path = directory_ + "/" + segmentName(index);
+    try
+    {
+        Poco::File file(segment->path);
+        if (create)
+        {
+            // 预分配整段，之后只在映射范围内写入
+            std::FILE *created = std::fopen(segment->path.c_str(), "wb");
+            if (!created)
+            {
+                return nullptr;
+            }
+            std::fclose(created);
+            file.setSize(std::min(segmentBytes_, kMaxSegmentBytes));
+        }
+        segment->capacity = std::min(static_cast<size_t>(file.getSize()), kMaxSegmentBytes);
+        if (segment->capacity == 0)
+        {
+            return nullptr;
+        }
+        segment->mapping = std::make_unique<Poco::SharedMemory>(file, Poco::SharedMemory::AM_READ);
+        segment->data = segment->mapping->begin();
+    }
+    catch (const Poco::Exception &e)
+    {
+        LOG_ERROR("HistoryStore", "映射历史分段失败: " + segment->path + ", " + e.displayText());
+        return nullptr;
+    }
+    return segment;
+}
+
+bool HistoryStore::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (running_)
+        {
+            return true;
+        }
+    }
+
+    std::vector<uint32_t> indexes;
+    std::vector<uint32_t> indexFiles;
+    try
+    {
+        Poco::File directory(directory_);
+        directory.createDirectories();
+        std::vector<std::string> names;
+        directory.list(names);
+        for (const auto &name : names)
+        {
+            uint32_t index = 0;
+            if (parseName(name, kSegmentSuffix, index))
+            {
+                indexes.push_back(index);
+            }
+            else if (parseName(name, kIndexSuffix, index))
+            {
+                indexFiles.push_back(index);
+            }
+        }
+    }
+    catch (const Poco::Exception &e)
+    {
+        LOG_ERROR("HistoryStore", "无法打开历史目录 " + directory_ + ": " + e.displayText());
+        return false;
+    }
+    std::sort(indexes.begin(), indexes.end());
+    std::sort(indexFiles.rbegin(), indexFiles.rend());
+
+    // 分段下标即文件序号，只载入从 0 开始连续的分段
+    uint32_t available = 0;
+    while (available < indexes.size() && indexes[available] == available)
+    {
+        ++available;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    segments_.clear();
+    conversations_.clear();
+
+    // 从最新的可用索引文件恢复，它覆盖的分段只映射不扫描；索引文件损坏时退回上一个，都不可用时全部扫描
+    std::vector<size_t> sealedBytes;
+    for (uint32_t sealed : indexFiles)
+    {
+        if (sealed < available && loadIndex(sealed, sealedBytes))
+        {
+            break;
+        }
+        conversations_.clear();
+        sealedBytes.clear();
+    }
+
+    size_t scanned = 0;
+    for (uint32_t i = 0; i < available; ++i)
+    {
+        auto segment = openSegment(i, false);
+        if (!segment)
+        {
+            break;
+        }
+        if (i < sealedBytes.size())
+        {
+            segment->committed = std::min(sealedBytes[i], segment->capacity);
+            segments_.push_back(segment);
+            continue;
+        }
+
+        // 扫描到第一条残缺记录为止，预分配的全零尾部解析为空负载，也在此停止
+        std::string_view data(segment->data, segment->capacity);
+        size_t offset = 0;
+        while (true)
+        {
+            size_t start = offset;
+            std::string_view payload;
+            std::string_view conversation;
+            std::string_view message;
+            uint64_t prevSegment = 0;
+            uint64_t prevOffset = 0;
+            uint64_t id = 0;
+            if (!RecordIO::nextRecord(data, offset, payload) || !decodeRecord(payload, conversation, prevSegment, prevOffset, message, id))
+            {
+                offset = start;
+                break;
+            }
+            publish(conversations_[std::string(conversation)], id, sequenceOf(message), Position{i, static_cast<uint32_t>(start)});
+        }
+        segment->committed = offset;
+        segments_.push_back(segment);
+        ++scanned;
+    }
+    if (segments_.size() < sealedBytes.size())
+    {
+        // 索引中的链头可能指向没能映射的分段
+        LOG_ERROR("HistoryStore", "无法映射索引文件覆盖的历史分段");
+        return false;
+    }
+
+    if (segments_.empty())
+    {
+        auto segment = openSegment(0, true);
+        if (!segment)
+        {
+            return false;
+        }
+        segments_.push_back(segment);
+    }
+    else
+    {
+        // 最后一段继续写入：把提交位置之后可能残留的半截数据清零，避免下次启动时被误认为记录
+        auto &last = segments_.back();
+        size_t committed = last->committed;
+        size_t capacity = last->capacity;
+        last->mapping.reset();
+        try
+        {
+            Poco::File file(last->path);
+            file.setSize(committed);
+            file.setSize(capacity);
+        }
+        catch (const Poco::Exception &e)
+        {
+            LOG_ERROR("HistoryStore", "无法重置历史分段尾部: " + e.displayText());
+            return false;
+        }
+        last = openSegment(static_cast<uint32_t>(segments_.size() - 1), false);
+        if (!last)
+        {
+            return false;
+        }
+        last->committed = committed;
+    }
+
+    active_ = std::fopen(segments_.back()->path.c_str(), "r+b");
+    activeOffset_ = segments_.back()->committed;
+    if (!active_ || std::fseek(active_, static_cast<long>(activeOffset_), SEEK_SET) != 0)
+    {
+        LOG_ERROR("HistoryStore", "无法打开历史分段: " + segments_.back()->path);
+        return false;
+    }
+    uint64_t messages = 0;
+    for (const auto &conversation : conversations_)
+    {
+        messages += conversation.second.messages;
+    }
+    LOG_INFO("HistoryStore", "已载入 " + std::to_string(segments_.size()) + " 个历史分段（扫描 " + std::to_string(scanned) + " 个），" +
+                       std::to_string(conversations_.size()) + " 个会话，共 " + std::to_string(messages) + " 条消息");
+    lock.unlock();
+
+    std::lock_guard<std::mutex> queueLock(queueMutex_);
+    running_ = true;
+    writer_ = std::thread(&HistoryStore::writerLoop, this);
+    return true;
+}
+
+void HistoryStore::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    queueReady_.notify_all();
+    writer_.join();
+    batchCommitted_.notify_all();
+
+    if (active_)
+    {
+        std::fclose(active_);
+        active_ = nullptr;
+    }
+}
+
+bool HistoryStore::append(const std::string &conversation, const ChatMessage &message)
+{
+    return append(conversation, message.getId(), message.serializeBinary());
+}
+
+bool HistoryStore::append(const std::string &conversation, uint64_t id, std::string_view message)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!running_ || queue_.size() >= kMaxPending)
+        {
+            ++dropped_;
+            return false;
+        }
+        queue_.push_back({conversation, id, std::string(message)});
+        ++enqueued_;
+    }
+    queueReady_.notify_one();
+    return true;
+}
+
+void HistoryStore::flush()
+{
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    uint64_t target = enqueued_;
+    batchCommitted_.wait(lock, [&]
+                         { return written_ >= target || !running_; });
+}
+
+void HistoryStore::writerLoop()
+{
+    std::vector<Pending> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueReady_.wait(lock, [this]
+                             { return !queue_.empty() || !running_; });
+            if (queue_.empty())
+            {
+                break;
+            }
+            batch.swap(queue_);
+        }
+
+        size_t count = batch.size();
+        if (!writeBatch(batch))
+        {
+            LOG_ERROR("HistoryStore", "写入历史分段失败，本批次剩余消息已丢弃");
+        }
+        batch.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            written_ += count;
+        }
+        batchCommitted_.notify_all();
+    }
+}
+
+HistoryStore::Position HistoryStore::headOf(const std::string &conversation, const std::unordered_map<std::string, Position> &staged) const
+{
+    // 只有组提交线程修改索引，这里读取无需加锁
+    auto pending = staged.find(conversation);
+    if (pending != staged.end())
+    {
+        return pending->second;
+    }
+    auto it = conversations_.find(conversation);
+    if (it == conversations_.end() || it->second.messages == 0)
+    {
+        return Position{UINT32_MAX, 0};
+    }
+    return it->second.head;
+}
+
+bool HistoryStore::writeBatch(std::vector<Pending> &batch)
+{
+    std::string buffer;
+    std::string payload;
+    std::vector<Committed> updates;
+    std::unordered_map<std::string, Position> staged;
+    for (auto &pending : batch)
+    {
+        Position prev = headOf(pending.conversation, staged);
+        payload.clear();
+        BinaryWriter writer(payload);
+        writer.writeString(pending.conversation);
+        writer.writeVarUInt(prev.segment == UINT32_MAX ? 0 : uint64_t(prev.segment) + 1);
+        writer.writeVarUInt(prev.segment == UINT32_MAX ? 0 : prev.offset);
+        writer.writeBytes(pending.message.data(), pending.message.size());
+
+        size_t recordSize = RecordIO::kHeaderSize + payload.size();
+        if (recordSize > std::min(segmentBytes_, kMaxSegmentBytes))
+        {
+            ++dropped_;
+            continue;
+        }
+        if (activeOffset_ + buffer.size() + recordSize > segments_.back()->capacity)
+        {
+            if (!commitBuffer(buffer, updates) || !rollSegment())
+            {
+                return false;
+            }
+        }
+
+        Position position{static_cast<uint32_t>(segments_.size() - 1), static_cast<uint32_t>(activeOffset_ + buffer.size())};
+        RecordIO::appendRecord(buffer, payload);
+        staged[pending.conversation] = position;
+        updates.push_back({std::move(pending.conversation), pending.id, sequenceOf(pending.message), position});
+    }
+    return commitBuffer(buffer, updates);
+}
+
+bool HistoryStore::commitBuffer(std::string &buffer, std::vector<Committed> &updates)
+{
+    if (buffer.empty())
+    {
+        return true;
+    }
+
+    // 整批只 fsync 一次，落盘之后才对查询可见
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), active_) == buffer.size() && RecordIO::syncFile(active_);
+    if (!ok)
+    {
+        dropped_ += updates.size();
+        std::fseek(active_, static_cast<long>(activeOffset_), SEEK_SET);
+        buffer.clear();
+        updates.clear();
+        return false;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex_);
+        segments_.back()->committed = activeOffset_ + buffer.size();
+        for (const auto &update : updates)
+        {
+            publish(conversations_[update.conversation], update.id, update.seq, update.position);
+        }
+    }
+    activeOffset_ += buffer.size();
+    committed_ += updates.size();
+    buffer.clear();
+    updates.clear();
+    return true;
+}
+
+bool HistoryStore::rollSegment()
+{
+    // 写不出索引文件只影响下次启动的速度
+    uint32_t sealed = static_cast<uint32_t>(segments_.size() - 1);
+    if (!writeIndex(sealed))
+    {
+        LOG_WARNING("HistoryStore", "写入历史索引文件失败，下次启动将扫描分段 " + std::to_string(sealed));
+    }
+
+    auto segment = openSegment(static_cast<uint32_t>(segments_.size()), true);
+    std::FILE *file = segment ? std::fopen(segment->path.c_str(), "r+b") : nullptr;
+    if (!file)
+    {
+        return false;
+    }
+    std::fclose(active_);
+    active_ = file;
+    activeOffset_ = 0;
+
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    segments_.push_back(segment);
+    return true;
+}
+
+bool HistoryStore::writeIndex(uint32_t sealed)
+{
+    // 首条记录：版本、分段数和各段已提交的字节数；之后每个会话一条记录：
+    // 会话键、链头、消息数、最大序号、检查点数和各检查点的 ID 与位置。
+    // 只有组提交线程修改索引，这里读取无需加锁
+    std::string buffer;
+    std::string payload;
+    BinaryWriter header(payload);
+    header.writeVarUInt(kIndexVersion);
+    header.writeVarUInt(sealed + 1);
+    for (uint32_t i = 0; i <= sealed; ++i)
+    {
+        header.writeVarUInt(segments_[i]->committed);
+    }
+    header.writeVarUInt(conversations_.size());
+    RecordIO::appendRecord(buffer, payload);
+
+    for (const auto &entry : conversations_)
+    {
+        const Conversation &conversation = entry.second;
+        payload.clear();
+        BinaryWriter writer(payload);
+        writer.writeString(entry.first);
+        writer.writeVarUInt(conversation.head.segment);
+        writer.writeVarUInt(conversation.head.offset);
+        writer.writeVarUInt(conversation.messages);
+        writer.writeVarUInt(conversation.lastSeq);
+        writer.writeVarUInt(conversation.checkpoints.size());
+        for (const auto &checkpoint : conversation.checkpoints)
+        {
+            writer.writeVarUInt(checkpoint.id);
+            writer.writeVarUInt(checkpoint.position.segment);
+            writer.writeVarUInt(checkpoint.position.offset);
+        }
+        RecordIO::appendRecord(buffer, payload);
+    }
+
+    // 先写临时文件再改名，启动时看到的索引文件总是完整的
+    std::string path = directory_ + "/" + segmentName(sealed, kIndexSuffix);
+    std::string tempPath = path + ".tmp";
+    std::FILE *file = std::fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    ok = RecordIO::syncFile(file) && ok;
+    std::fclose(file);
+    try
+    {
+        if (!ok)
+        {
+            Poco::File(tempPath).remove();
+            return false;
+        }
+        Poco::File(tempPath).renameTo(path);
+        if (!RecordIO::syncDirectory(directory_))
+        {
+            return false;
+        }
+        // 新的索引文件已经覆盖更早的分段
+        if (sealed > 0)
+        {
+            Poco::File previous(directory_ + "/" + segmentName(sealed - 1, kIndexSuffix));
+            if (previous.exists())
+            {
+                previous.remove();
+            }
+        }
+    }
+    catch (const Poco::Exception &e)
+    {
+        LOG_ERROR("HistoryStore", "写入历史索引文件失败: " + path + ", " + e.displayText());
+        return false;
+    }
+    return true;
+}
+
+bool HistoryStore::loadIndex(uint32_t sealed, std::vector<size_t> &sealedBytes)
+{
+    std::string path = directory_ + "/" + segmentName(sealed, kIndexSuffix);
+    std::string data;
+    if (!RecordIO::readFile(path, data))
+    {
+        return false;
+    }
+
+    size_t offset = 0;
+    std::string_view payload;
+    uint64_t version = 0;
+    uint64_t segments = 0;
+    uint64_t count = 0;
+    if (!RecordIO::nextRecord(data, offset, payload))
+    {
+        return false;
+    }
+    BinaryReader header(payload.data(), payload.size());
+    if (!header.readVarUInt(version) || version != kIndexVersion || !header.readVarUInt(segments) || segments != uint64_t(sealed) + 1)
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < segments; ++i)
+    {
+        uint64_t bytes = 0;
+        if (!header.readVarUInt(bytes))
+        {
+            return false;
+        }
+        sealedBytes.push_back(static_cast<size_t>(bytes));
+    }
+    if (!header.readVarUInt(count))
+    {
+        return false;
+    }
+
+    // 位置都必须落在索引覆盖的分段内
+    auto valid = [&](uint64_t segment, uint64_t position)
+    {
+        return segment < segments && position < sealedBytes[segment];
+    };
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        std::string_view key;
+        uint64_t headSegment = 0;
+        uint64_t headOffset = 0;
+        uint64_t messages = 0;
+        uint64_t lastSeq = 0;
+        uint64_t checkpoints = 0;
+        if (!RecordIO::nextRecord(data, offset, payload))
+        {
+            return false;
+        }
+        BinaryReader reader(payload.data(), payload.size());
+        if (!reader.readString(key) || !reader.readVarUInt(headSegment) || !reader.readVarUInt(headOffset) ||
+            !reader.readVarUInt(messages) || !reader.readVarUInt(lastSeq) || !reader.readVarUInt(checkpoints) ||
+            !valid(headSegment, headOffset) || checkpoints > reader.remaining())
+        {
+            return false;
+        }
+        Conversation &conversation = conversations_[std::string(key)];
+        conversation.head = Position{static_cast<uint32_t>(headSegment), static_cast<uint32_t>(headOffset)};
+        conversation.messages = messages;
+        conversation.lastSeq = lastSeq;
+        conversation.checkpoints.reserve(checkpoints);
+        for (uint64_t c = 0; c < checkpoints; ++c)
+        {
+            uint64_t id = 0;
+            uint64_t segment = 0;
+            uint64_t position = 0;
+            if (!reader.readVarUInt(id) || !reader.readVarUInt(segment) || !reader.readVarUInt(position) || !valid(segment, position))
+            {
+                return false;
+            }
+            conversation.checkpoints.push_back({id, Position{static_cast<uint32_t>(segment), static_cast<uint32_t>(position)}});
+        }
+    }
+    return true;
+}
+
+void HistoryStore::publish(Conversation &conversation, uint64_t id, uint64_t seq, Position position)
+{
+    conversation.lastSeq = std::max(conversation.lastSeq, seq);
+    // 时钟在重启之间回拨时新记录的 ID 可能小于旧记录，这样的记录不作检查点，二分查找的前提不被破坏
+    if (conversation.messages % kCheckpointInterval == 0 &&
+        (conversation.checkpoints.empty() || conversation.checkpoints.back().id < id))
+    {
+        conversation.checkpoints.push_back({id, position});
+    }
+    conversation.head = position;
+    ++conversation.messages;
+}
+
+size_t HistoryStore::query(const std::string &conversation, uint64_t beforeId, size_t limit, View &view) const
+{
+    view.messages.clear();
+    view.segments.clear();
+
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    auto it = conversations_.find(conversation);
+    if (it == conversations_.end() || it->second.messages == 0 || limit == 0)
+    {
+        return 0;
+    }
+
+    // 按 ID 查询时从第一个不小于 beforeId 的检查点往回走，最多多走一个检查点间隔
+    Position position = it->second.head;
+    size_t maxSteps = limit;
+    if (beforeId != 0)
+    {
+        const auto &checkpoints = it->second.checkpoints;
+        auto checkpoint = std::lower_bound(checkpoints.begin(), checkpoints.end(), beforeId, [](const Checkpoint &c, uint64_t id)
+                                           { return c.id < id; });
+        if (checkpoint != checkpoints.end())
+        {
+            position = checkpoint->position;
+        }
+        maxSteps += 2 * kCheckpointInterval;
+    }
+
+    for (size_t steps = 0; steps < maxSteps && view.messages.size() < limit; ++steps)
+    {
+        const auto &segment = segments_[position.segment];
+        size_t offset = position.offset;
+        std::string_view payload;
+        std::string_view key;
+        std::string_view message;
+        uint64_t prevSegment = 0;
+        uint64_t prevOffset = 0;
+        uint64_t id = 0;
+        if (!RecordIO::nextRecord(std::string_view(segment->data, segment->committed), offset, payload) ||
+            !decodeRecord(payload, key, prevSegment, prevOffset, message, id))
+        {
+            break;
+        }
+        if (beforeId == 0 || id < beforeId)
+        {
+            view.messages.push_back(message);
+            if (view.segments.empty() || view.segments.back() != segment)
+            {
+                view.segments.push_back(segment);
+            }
+        }
+        if (prevSegment == 0 || prevSegment > segments_.size())
+        {
+            break;
+        }
+        position = Position{static_cast<uint32_t>(prevSegment - 1), static_cast<uint32_t>(prevOffset)};
+    }
+
+    std::reverse(view.messages.begin(), view.messages.end());
+    return view.messages.size();
+}
+
+uint64_t HistoryStore::getLastSeq(const std::string &conversation) const
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    auto it = conversations_.find(conversation);
+    return it == conversations_.end() ? 0 : it->second.lastSeq;
+}
+
+size_t HistoryStore::getConversationCount() const
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    return conversations_.size();
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class ChatMessage;
+
+// 聊天历史：所有转发过的聊天消息按时间顺序追加到分段日志（<目录>/history-<序号>.seg），
+// 每段预分配固定大小并整体只读映射，查询直接返回映射区内的消息编码，不做拷贝。
+// 记录格式见 RecordIO，负载为 会话键 + 该会话上一条记录的位置 + 消息的二进制编码，
+// 同一会话的记录由位置反向串成链；内存中为每个会话保存链头和每隔若干条的稀疏检查点。
+// 写满一段换段时把整个索引写入该段的索引文件（history-<序号>.idx），
+// 启动时载入最新的索引文件，只顺序扫描它之后写入的分段（通常只有最后一段）。
+// 追加只在调用线程编码后入队，由后台线程成批写入并一次 fsync（组提交），转发线程不等待落盘；
+// 查询只能看到已经提交的记录
+class HistoryStore
+{
+private:
+    struct Segment;
+
+public:
+    // 查询结果：messages 为映射区内的消息二进制编码（按时间正序），
+    // 在 View 存活期间有效；View 持有所引用的分段，分段不会被提前解除映射
+    struct View
+    {
+        std::vector<std::string_view> messages;
+        std::vector<std::shared_ptr<const Segment>> segments;
+    };
+
+    static HistoryStore &getInstance();
+    // 拥有自己分段和组提交线程的实例，不影响全局实例
+    static std::unique_ptr<HistoryStore> create();
+    ~HistoryStore();
+
+    void setDirectory(const std::string &directory) { directory_ = directory; }
+    void setSegmentBytes(size_t segmentBytes) { segmentBytes_ = segmentBytes; }
+
+    // 映射已有分段并重建索引，启动组提交线程
+    bool start();
+    // 提交队列中剩余的记录后停止
+    void stop();
+
+    // 编码后入队立即返回；队列积压超过上限或未启动时丢弃并返回 false
+    bool append(const std::string &conversation, const ChatMessage &message);
+    // message 为聊天消息的二进制编码，id 为其消息 ID
+    bool append(const std::string &conversation, uint64_t id, std::string_view message);
+
+    // 阻塞到调用前入队的记录全部提交，供基准测试和关闭流程使用
+    void flush();
+
+    // 取会话中最近的 limit 条消息；beforeId 不为 0 时取 ID 小于它的 limit 条。返回条数
+    size_t query(const std::string &conversation, uint64_t beforeId, size_t limit, View &view) const;
+
+    // 会话已提交记录中最大的会话序号，没有记录时为 0；ConversationSequencer 据此恢复计数器
+    uint64_t getLastSeq(const std::string &conversation) const;
+    size_t getConversationCount() const;
+
+    uint64_t getCommittedCount() const { return committed_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    HistoryStore(const HistoryStore &) = delete;
+    HistoryStore &operator=(const HistoryStore &) = delete;
+
+private:
+    HistoryStore();
+
+    // 记录在日志中的位置，segment 为分段在 segments_ 中的下标
+    struct Position
+    {
+        uint32_t segment = 0;
+        uint32_t offset = 0;
+    };
+
+    struct Checkpoint
+    {
+        uint64_t id;
+        Position position;
+    };
+
+    struct Conversation
+    {
+        Position head;
+        uint64_t messages = 0;
+        uint64_t lastSeq = 0; // 已提交记录中最大的会话序号
+        // 每 kCheckpointInterval 条记录一次，按 ID 二分查找起点；只保留 ID 递增的检查点。
+        // 同一会话的 ID 分配和入队由 ConversationSequencer 串行化，记录链本身按 ID 递增
+        std::vector<Checkpoint> checkpoints;
+    };
+
+    struct Pending
+    {
+        std::string conversation;
+        uint64_t id;
+        std::string message;
+    };
+
+    // 已提交记录的索引更新，批次落盘后统一发布
+    struct Committed
+    {
+        std::string conversation;
+        uint64_t id;
+        uint64_t seq;
+        Position position;
+    };
+
+    std::shared_ptr<Segment> openSegment(uint32_t index, bool create);
+    bool rollSegment();
+    // 把当前索引和各段已提交的字节数写入分段 sealed 的索引文件，只由组提交线程在换段时调用
+    bool writeIndex(uint32_t sealed);
+    // 载入分段 sealed 的索引文件，sealedBytes 为分段 0..sealed 已提交的字节数
+    bool loadIndex(uint32_t sealed, std::vector<size_t> &sealedBytes);
+    bool writeBatch(std::vector<Pending> &batch);
+    bool commitBuffer(std::string &buffer, std::vector<Committed> &updates);
+    void publish(Conversation &conversation, uint64_t id, uint64_t seq, Position position);
+    Position headOf(const std::string &conversation, const std::unordered_map<std::string, Position> &staged) const;
+    void writerLoop();
+
+    std::string directory_ = "config/history";
+    size_t segmentBytes_ = 64 * 1024 * 1024;
+
+    // 分段列表和会话索引，查询持读锁，组提交线程发布时持写锁
+    mutable std::shared_mutex indexMutex_;
+    std::vector<std::shared_ptr<Segment>> segments_;
+    std::unordered_map<std::string, Conversation> conversations_;
+
+    // 以下只由组提交线程（或 start 之前）访问
+    std::FILE *active_ = nullptr;
+    size_t activeOffset_ = 0;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueReady_;
+    std::condition_variable batchCommitted_;
+    std::vector<Pending> queue_;
+    uint64_t enqueued_ = 0;
+    uint64_t written_ = 0;
+    bool running_ = false;
+    std::thread writer_;
+
+    std::atomic<uint64_t> committed_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,124 @@
+#include "IdleReaper.h"
+#include "AsyncLog.h"
+#include "ChatConnection.h"
+#include "ConnectionManager.h"
+#include "Metrics.h"
+#include <utility>
+#include <vector>
+
+IdleReaper &IdleReaper::getInstance()
+{
+    static IdleReaper instance;
+    return instance;
+}
+
+IdleReaper::~IdleReaper()
+{
+    stop();
+}
+
+void IdleReaper::start(int timeoutSeconds)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ || timeoutSeconds <= 0)
+    {
+        return;
+    }
+    running_ = true;
+    timeoutMs_ = static_cast<int64_t>(timeoutSeconds) * 1000;
+    wheel_ = TimerWheel(static_cast<uint64_t>(toMillis(Clock::now()) / kTickMs));
+    thread_ = std::thread(&IdleReaper::run, this);
+
+    LOG_INFO("IdleReaper", "空闲连接超时: " + std::to_string(timeoutSeconds) + " 秒");
+}
+
+void IdleReaper::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    stopped_.notify_all();
+    thread_.join();
+}
+
+void IdleReaper::watch(SlotHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+        schedule(handle.pack(), toMillis(Clock::now()) + timeoutMs_);
+    }
+}
+
+void IdleReaper::schedule(uint64_t id, int64_t deadlineMs)
+{
+    // 向上取整到 tick，连接不会早于超时时间被检查
+    wheel_.schedule(id, static_cast<uint64_t>((deadlineMs + kTickMs - 1) / kTickMs));
+}
+
+void IdleReaper::run()
+{
+    std::vector<uint64_t> expired;
+    std::vector<std::pair<uint64_t, int64_t>> renewed;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        stopped_.wait_for(lock, std::chrono::milliseconds(kTickMs));
+        if (!running_)
+        {
+            break;
+        }
+
+        int64_t nowMs = toMillis(Clock::now());
+        expired.clear();
+        wheel_.advance(static_cast<uint64_t>(nowMs / kTickMs), expired);
+        if (expired.empty())
+        {
+            continue;
+        }
+
+        // 查找连接要获取槽位锁，断开连接会写日志，都在时间轮锁外进行，不阻塞新连接登记
+        lock.unlock();
+        renewed.clear();
+        for (uint64_t id : expired)
+        {
+            int64_t deadlineMs = check(SlotHandle::unpack(id), nowMs);
+            if (deadlineMs > 0)
+            {
+                renewed.emplace_back(id, deadlineMs);
+            }
+        }
+        lock.lock();
+        for (const auto &entry : renewed)
+        {
+            schedule(entry.first, entry.second);
+        }
+    }
+}
+
+int64_t IdleReaper::check(SlotHandle handle, int64_t nowMs)
+{
+    // 句柄失效说明连接已经关闭，定时器随之作废
+    auto connection = ConnectionManager::getInstance().getConnection(handle);
+    if (!connection || !connection->isConnected())
+    {
+        return 0;
+    }
+
+    int64_t deadlineMs = connection->getLastActivityMs() + timeoutMs_;
+    if (nowMs < deadlineMs)
+    {
+        return deadlineMs;
+    }
+
+    LOG_WARNING("IdleReaper", "Connection " + connection->getClientAddress() + " idle for " +
+                                  std::to_string((nowMs - connection->getLastActivityMs()) / 1000) + "s, disconnecting.");
+    Metrics::getInstance().add(Metrics::IDLE_REAPED);
+    connection->setDisconnected();
+    return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "SlotMap.h"
+#include "TimerWheel.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// 空闲连接回收：每个连接在时间轮中只有一个截止时间，由单个线程每 250 毫秒推进一次，
+// 不需要为每个连接设置套接字超时或定时器。截止时间到达时检查连接最近一次收到数据的时间，
+// 期间有输入（包括心跳）则按最近活动时间重新登记，否则断开连接并计入 idle_reaped
+class IdleReaper
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int64_t kTickMs = 250;
+
+    static IdleReaper &getInstance();
+
+    // timeoutSeconds 为 0 时不回收空闲连接
+    void start(int timeoutSeconds);
+    void stop();
+
+    // 连接登记后调用，从现在起开始计时；服务未启动时忽略
+    void watch(SlotHandle handle);
+
+    static int64_t toMillis(Clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    }
+
+private:
+    IdleReaper() = default;
+    ~IdleReaper();
+    IdleReaper(const IdleReaper &) = delete;
+    IdleReaper &operator=(const IdleReaper &) = delete;
+
+    void run();
+    // 截止时间到达后检查连接，仍需等待时返回新的截止时间（毫秒），否则返回 0
+    int64_t check(SlotHandle handle, int64_t nowMs);
+    void schedule(uint64_t id, int64_t deadlineMs);
+
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    TimerWheel wheel_;
+    bool running_ = false;
+    int64_t timeoutMs_ = 0;
+    std::thread thread_;
+};
@@ -0,0 +1,190 @@
+#include "Metrics.h"
+#include <algorithm>
+
+Metrics &Metrics::getInstance()
+{
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Metrics() : shards_(new Shard[kShards]())
+{
+}
+
+size_t Metrics::bucketOf(uint64_t micros)
+{
+    if (micros < kSubBuckets)
+    {
+        return static_cast<size_t>(micros);
+    }
+    // micros 落在 [2^magnitude, 2^(magnitude+1))，该区间按最高 kSubBucketBits+1 位线性细分
+    unsigned magnitude = 0;
+    while ((micros >> magnitude) > 1)
+    {
+        ++magnitude;
+    }
+    size_t sub = static_cast<size_t>(micros >> (magnitude - kSubBucketBits)) - kSubBuckets;
+    size_t bucket = kSubBuckets + (magnitude - kSubBucketBits) * kSubBuckets + sub;
+    return std::min(bucket, kBuckets - 1);
+}
+
+uint64_t Metrics::bucketUpperBound(size_t bucket)
+{
+    if (bucket < kSubBuckets)
+    {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>((bucket - kSubBuckets) / kSubBuckets);
+    uint64_t sub = (bucket - kSubBuckets) % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void Metrics::record(Histogram histogram, uint64_t micros)
+{
+    Shard &own = shard();
+    own.buckets[histogram][bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    own.sums[histogram].fetch_add(micros, std::memory_order_relaxed);
+    uint64_t max = own.maxima[histogram].load(std::memory_order_relaxed);
+    while (micros > max && !own.maxima[histogram].compare_exchange_weak(max, micros, std::memory_order_relaxed))
+    {
+    }
+}
+
+Metrics::Snapshot Metrics::snapshot() const
+{
+    Snapshot snapshot;
+    for (auto &histogram : snapshot.histograms)
+    {
+        histogram.buckets.assign(kBuckets, 0);
+    }
+
+    for (size_t s = 0; s < kShards; ++s)
+    {
+        const Shard &shard = shards_[s];
+        for (size_t i = 0; i < kCounterCount; ++i)
+        {
+            snapshot.counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < kMessageTypes; ++i)
+        {
+            snapshot.messagesIn[i] += shard.messagesIn[i].load(std::memory_order_relaxed);
+            snapshot.messagesOut[i] += shard.messagesOut[i].load(std::memory_order_relaxed);
+        }
+        for (size_t h = 0; h < kHistogramCount; ++h)
+        {
+            HistogramSnapshot &histogram = snapshot.histograms[h];
+            histogram.sum += shard.sums[h].load(std::memory_order_relaxed);
+            histogram.max = std::max(histogram.max, shard.maxima[h].load(std::memory_order_relaxed));
+            for (size_t b = 0; b < kBuckets; ++b)
+            {
+                uint64_t count = shard.buckets[h][b].load(std::memory_order_relaxed);
+                histogram.buckets[b] += count;
+                histogram.count += count;
+            }
+        }
+    }
+    return snapshot;
+}
+
+uint64_t Metrics::HistogramSnapshot::percentile(double q) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b)
+    {
+        seen += buckets[b];
+        if (seen >= rank)
+        {
+            // 桶上界可能超过实际出现过的最大值
+            return std::min(bucketUpperBound(b), max);
+        }
+    }
+    return max;
+}
+
+const char *Metrics::counterName(Counter counter)
+{
+    switch (counter)
+    {
+    case BYTES_IN:
+        return "bytes_in";
+    case BYTES_OUT:
+        return "bytes_out";
+    case PARSE_FAILURES:
+        return "parse_failures";
+    case AUTH_SUCCESSES:
+        return "auth_successes";
+    case AUTH_FAILURES:
+        return "auth_failures";
+    case IDLE_REAPED:
+        return "idle_reaped";
+    default:
+        return "unknown";
+    }
+}
+
+const char *Metrics::histogramName(Histogram histogram)
+{
+    switch (histogram)
+    {
+    case RECEIVE_TO_ROUTE:
+        return "receive_to_route";
+    case ROUTE_TO_SEND:
+        return "route_to_send";
+    default:
+        return "unknown";
+    }
+}
+
+const char *Metrics::messageTypeName(size_t type)
+{
+    switch (static_cast<MessageType>(type))
+    {
+    case MessageType::REGISTER_REQUEST:
+        return "register_request";
+    case MessageType::REGISTER_RESPONSE:
+        return "register_response";
+    case MessageType::LOGIN_REQUEST:
+        return "login_request";
+    case MessageType::LOGIN_RESPONSE:
+        return "login_response";
+    case MessageType::LOGOUT:
+        return "logout";
+    case MessageType::BROADCAST_MESSAGE:
+        return "broadcast_message";
+    case MessageType::PRIVATE_MESSAGE:
+        return "private_message";
+    case MessageType::MESSAGE_ACK:
+        return "message_ack";
+    case MessageType::HISTORY_REQUEST:
+        return "history_request";
+    case MessageType::HISTORY_RESPONSE:
+        return "history_response";
+    case MessageType::USER_LIST_REQUEST:
+        return "user_list_request";
+    case MessageType::USER_LIST_RESPONSE:
+        return "user_list_response";
+    case MessageType::USER_STATUS_UPDATE:
+        return "user_status_update";
+    case MessageType::HEARTBEAT:
+        return "heartbeat";
+    case MessageType::CAPABILITIES:
+        return "capabilities";
+    case MessageType::ERROR_MESSAGE:
+        return "error_message";
+    case MessageType::ROOM_JOIN:
+        return "room_join";
+    case MessageType::ROOM_LEAVE:
+        return "room_leave";
+    case MessageType::ROOM_MESSAGE:
+        return "room_message";
+    case MessageType::ROOM_RESPONSE:
+        return "room_response";
+    default:
+        return nullptr;
+    }
+}
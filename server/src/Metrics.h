@@ -0,0 +1,124 @@
+#pragma once
+
+#include "message_types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 服务器运行指标：计数器、按消息类型的收发计数和延迟直方图。
+// 每个线程固定写入一个分片（线程数超过分片数时共用），热路径上只有一次无竞争的原子加，不加锁；
+// 读取时把所有分片相加。直方图采用 HDR 式的对数-线性分桶，相对误差约 6%
+class Metrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Counter
+    {
+        BYTES_IN,
+        BYTES_OUT,
+        PARSE_FAILURES,
+        AUTH_SUCCESSES,
+        AUTH_FAILURES,
+        IDLE_REAPED, // 超过 server.timeout 没有任何输入而被断开的连接
+        kCounterCount
+    };
+
+    enum Histogram
+    {
+        RECEIVE_TO_ROUTE, // 收到帧到路由完成
+        ROUTE_TO_SEND,    // 帧进入出站队列到交给写者
+        kHistogramCount
+    };
+
+    // 消息类型取值都小于 64
+    static constexpr size_t kMessageTypes = 64;
+    // 每个 2 的幂区间分为 16 个线性子桶，最大可区分约 2^40 微秒
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBuckets = kSubBuckets * 38;
+
+    struct HistogramSnapshot
+    {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> buckets;
+
+        // q 取 0~1，返回所在桶的上界（微秒）
+        uint64_t percentile(double q) const;
+    };
+
+    struct Snapshot
+    {
+        std::array<uint64_t, kCounterCount> counters{};
+        std::array<uint64_t, kMessageTypes> messagesIn{};
+        std::array<uint64_t, kMessageTypes> messagesOut{};
+        std::array<HistogramSnapshot, kHistogramCount> histograms;
+    };
+
+    static Metrics &getInstance();
+
+    void add(Counter counter, uint64_t value = 1)
+    {
+        shard().counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void messageIn(MessageType type)
+    {
+        shard().messagesIn[static_cast<size_t>(type) % kMessageTypes].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void messageOut(MessageType type)
+    {
+        shard().messagesOut[static_cast<size_t>(type) % kMessageTypes].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record(Histogram histogram, uint64_t micros);
+
+    void recordSince(Histogram histogram, Clock::time_point start)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        record(histogram, elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0);
+    }
+
+    Snapshot snapshot() const;
+
+    static const char *counterName(Counter counter);
+    static const char *histogramName(Histogram histogram);
+    // 未知类型返回 nullptr
+    static const char *messageTypeName(size_t type);
+
+    static size_t bucketOf(uint64_t micros);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+private:
+    Metrics();
+
+    static constexpr size_t kShards = 32;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> counters[kCounterCount];
+        std::atomic<uint64_t> messagesIn[kMessageTypes];
+        std::atomic<uint64_t> messagesOut[kMessageTypes];
+        std::atomic<uint64_t> sums[kHistogramCount];
+        std::atomic<uint64_t> maxima[kHistogramCount];
+        std::atomic<uint64_t> buckets[kHistogramCount][kBuckets];
+    };
+
+    Shard &shard()
+    {
+        static std::atomic<size_t> nextShard{0};
+        thread_local size_t index = nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shards_[index];
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+};
@@ -0,0 +1,263 @@
+#include "MetricsServer.h"
+#include "AsyncLog.h"
+#include "AuthService.h"
+#include "ConnectionManager.h"
+#include "HistoryStore.h"
+#include "Metrics.h"
+#include "OutboundQueue.h"
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <cstdio>
+
+namespace
+{
+    struct Quantile
+    {
+        const char *label;
+        const char *key;
+        double q;
+    };
+
+    constexpr Quantile kQuantiles[] = {
+        {"0.5", "p50", 0.5},
+        {"0.9", "p90", 0.9},
+        {"0.99", "p99", 0.99},
+        {"0.999", "p999", 0.999},
+    };
+
+    void appendNumber(std::string &out, double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1f", value);
+        out += buffer;
+    }
+
+    // 输出 "key":value 形式的 JSON 成员，first 为 false 时先加逗号
+    void appendMember(std::string &out, bool &first, const char *key, uint64_t value)
+    {
+        out += first ? "\"" : ",\"";
+        out += key;
+        out += "\":" + std::to_string(value);
+        first = false;
+    }
+
+    void appendMessageCounts(std::string &out, const std::array<uint64_t, Metrics::kMessageTypes> &counts)
+    {
+        out += "{";
+        bool first = true;
+        for (size_t type = 0; type < counts.size(); ++type)
+        {
+            const char *name = Metrics::messageTypeName(type);
+            if (name && counts[type] > 0)
+            {
+                appendMember(out, first, name, counts[type]);
+            }
+        }
+        out += "}";
+    }
+
+    void appendPrometheus(std::string &out, const char *name, const char *type, uint64_t value)
+    {
+        out += "# TYPE chat_";
+        out += name;
+        out += " ";
+        out += type;
+        out += "\nchat_";
+        out += name;
+        out += " " + std::to_string(value) + "\n";
+    }
+
+    void appendPrometheusMessages(std::string &out, const char *name, const std::array<uint64_t, Metrics::kMessageTypes> &counts)
+    {
+        out += "# TYPE chat_";
+        out += name;
+        out += " counter\n";
+        for (size_t type = 0; type < counts.size(); ++type)
+        {
+            const char *typeName = Metrics::messageTypeName(type);
+            if (typeName && counts[type] > 0)
+            {
+                out += "chat_";
+                out += name;
+                out += "{type=\"";
+                out += typeName;
+                out += "\"} " + std::to_string(counts[type]) + "\n";
+            }
+        }
+    }
+}
+
+void MetricsRequestHandler::handleRequest(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+{
+    std::string path = request.getURI().substr(0, request.getURI().find('?'));
+    std::string body;
+    if (path == "/metrics")
+    {
+        body = MetricsServer::renderPrometheus();
+        response.setContentType("text/plain; version=0.0.4");
+    }
+    else if (path == "/stats")
+    {
+        body = MetricsServer::renderJSON();
+        response.setContentType("application/json");
+    }
+    else
+    {
+        body = "not found\n";
+        response.setStatus(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+        response.setContentType("text/plain");
+    }
+    response.setContentLength(static_cast<std::streamsize>(body.size()));
+    response.send() << body;
+}
+
+Poco::Net::HTTPRequestHandler *MetricsRequestHandlerFactory::createRequestHandler(const Poco::Net::HTTPServerRequest &)
+{
+    return new MetricsRequestHandler();
+}
+
+MetricsServer::MetricsServer(const std::string &host, int port)
+{
+    // 抓取请求很少，两个线程足够，不与聊天连接争抢资源
+    Poco::Net::HTTPServerParams::Ptr params = new Poco::Net::HTTPServerParams;
+    params->setMaxThreads(2);
+    params->setKeepAlive(false);
+    Poco::Net::ServerSocket socket(Poco::Net::SocketAddress(host, static_cast<Poco::UInt16>(port)));
+    server_ = std::make_unique<Poco::Net::HTTPServer>(new MetricsRequestHandlerFactory(), socket, params);
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+void MetricsServer::start()
+{
+    server_->start();
+}
+
+void MetricsServer::stop()
+{
+    if (server_)
+    {
+        server_->stop();
+        server_.reset();
+    }
+}
+
+std::string MetricsServer::renderJSON()
+{
+    Metrics::Snapshot metrics = Metrics::getInstance().snapshot();
+    AuthStats auth = AuthService::getInstance().getStats();
+    OutboundStats outbound = OutboundQueue::globalStats();
+    auto &history = HistoryStore::getInstance();
+
+    std::string out = "{\"connections\":" + std::to_string(ConnectionManager::getInstance().getConnectionCount());
+
+    out += ",\"counters\":{";
+    bool first = true;
+    for (size_t i = 0; i < Metrics::kCounterCount; ++i)
+    {
+        appendMember(out, first, Metrics::counterName(static_cast<Metrics::Counter>(i)), metrics.counters[i]);
+    }
+    out += "},\"messages_in\":";
+    appendMessageCounts(out, metrics.messagesIn);
+    out += ",\"messages_out\":";
+    appendMessageCounts(out, metrics.messagesOut);
+
+    out += ",\"latency_us\":{";
+    for (size_t h = 0; h < Metrics::kHistogramCount; ++h)
+    {
+        const auto &histogram = metrics.histograms[h];
+        out += h == 0 ? "\"" : ",\"";
+        out += Metrics::histogramName(static_cast<Metrics::Histogram>(h));
+        out += "\":{";
+        first = true;
+        appendMember(out, first, "count", histogram.count);
+        out += ",\"mean\":";
+        appendNumber(out, histogram.count ? double(histogram.sum) / double(histogram.count) : 0.0);
+        for (const auto &quantile : kQuantiles)
+        {
+            appendMember(out, first, quantile.key, histogram.percentile(quantile.q));
+        }
+        appendMember(out, first, "max", histogram.max);
+        out += "}";
+    }
+    out += "}";
+
+    out += ",\"auth\":{";
+    first = true;
+    appendMember(out, first, "queue_depth", auth.queueDepth);
+    appendMember(out, first, "completed", auth.completed);
+    appendMember(out, first, "rejected", auth.rejected);
+    out += ",\"p50_us\":";
+    appendNumber(out, auth.p50Us);
+    out += ",\"p95_us\":";
+    appendNumber(out, auth.p95Us);
+    out += ",\"p99_us\":";
+    appendNumber(out, auth.p99Us);
+    out += "}";
+
+    out += ",\"outbound\":{";
+    first = true;
+    appendMember(out, first, "queued_frames", outbound.queuedFrames);
+    appendMember(out, first, "queued_bytes", outbound.queuedBytes);
+    appendMember(out, first, "dropped_frames", outbound.droppedFrames);
+    appendMember(out, first, "slow_consumer_disconnects", outbound.slowConsumerDisconnects);
+    out += "}";
+
+    out += ",\"history\":{";
+    first = true;
+    appendMember(out, first, "committed", history.getCommittedCount());
+    appendMember(out, first, "dropped", history.getDroppedCount());
+    out += "}";
+
+    out += ",\"log\":{\"dropped\":" + std::to_string(AsyncLog::getInstance().getDropped()) + "}}";
+    return out;
+}
+
+std::string MetricsServer::renderPrometheus()
+{
+    Metrics::Snapshot metrics = Metrics::getInstance().snapshot();
+    AuthStats auth = AuthService::getInstance().getStats();
+    OutboundStats outbound = OutboundQueue::globalStats();
+    auto &history = HistoryStore::getInstance();
+
+    std::string out;
+    appendPrometheus(out, "connections", "gauge", ConnectionManager::getInstance().getConnectionCount());
+    for (size_t i = 0; i < Metrics::kCounterCount; ++i)
+    {
+        std::string name = std::string(Metrics::counterName(static_cast<Metrics::Counter>(i))) + "_total";
+        appendPrometheus(out, name.c_str(), "counter", metrics.counters[i]);
+    }
+    appendPrometheusMessages(out, "messages_in_total", metrics.messagesIn);
+    appendPrometheusMessages(out, "messages_out_total", metrics.messagesOut);
+
+    for (size_t h = 0; h < Metrics::kHistogramCount; ++h)
+    {
+        const auto &histogram = metrics.histograms[h];
+        std::string name = std::string("chat_") + Metrics::histogramName(static_cast<Metrics::Histogram>(h)) + "_microseconds";
+        out += "# TYPE " + name + " summary\n";
+        for (const auto &quantile : kQuantiles)
+        {
+            out += name + "{quantile=\"" + quantile.label + "\"} " + std::to_string(histogram.percentile(quantile.q)) + "\n";
+        }
+        out += name + "_sum " + std::to_string(histogram.sum) + "\n";
+        out += name + "_count " + std::to_string(histogram.count) + "\n";
+    }
+
+    appendPrometheus(out, "auth_queue_depth", "gauge", auth.queueDepth);
+    appendPrometheus(out, "auth_completed_total", "counter", auth.completed);
+    appendPrometheus(out, "auth_rejected_total", "counter", auth.rejected);
+    appendPrometheus(out, "outbound_queued_frames", "gauge", outbound.queuedFrames);
+    appendPrometheus(out, "outbound_queued_bytes", "gauge", outbound.queuedBytes);
+    appendPrometheus(out, "outbound_dropped_frames_total", "counter", outbound.droppedFrames);
+    appendPrometheus(out, "outbound_slow_consumer_disconnects_total", "counter", outbound.slowConsumerDisconnects);
+    appendPrometheus(out, "history_committed_total", "counter", history.getCommittedCount());
+    appendPrometheus(out, "history_dropped_total", "counter", history.getDroppedCount());
+    appendPrometheus(out, "log_dropped_total", "counter", AsyncLog::getInstance().getDropped());
+    return out;
+}
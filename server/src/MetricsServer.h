@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServer.h>
+#include <memory>
+#include <string>
+
+// /metrics 返回 Prometheus 文本格式，/stats 返回 JSON，其余路径返回 404
+class MetricsRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    void handleRequest(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response) override;
+};
+
+class MetricsRequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory
+{
+public:
+    Poco::Net::HTTPRequestHandler *createRequestHandler(const Poco::Net::HTTPServerRequest &request) override;
+};
+
+// 独立端口上的轻量 HTTP 服务，输出 Metrics 中的计数和直方图，
+// 以及认证队列、出站队列、聊天历史和异步日志的统计
+class MetricsServer
+{
+public:
+    MetricsServer(const std::string &host, int port);
+    ~MetricsServer();
+
+    void start();
+    void stop();
+
+    static std::string renderJSON();
+    static std::string renderPrometheus();
+
+private:
+    std::unique_ptr<Poco::Net::HTTPServer> server_;
+};
@@ -0,0 +1,113 @@
+#include "OfflineDelivery.h"
+#include "AsyncLog.h"
+#include "ChatConnection.h"
+#include "ConnectionManager.h"
+#include <algorithm>
+
+namespace
+{
+    // 未补发完的收件箱隔多久再试
+    constexpr std::chrono::milliseconds kRetryDelay{200};
+}
+
+OfflineDelivery &OfflineDelivery::getInstance()
+{
+    static OfflineDelivery instance;
+    return instance;
+}
+
+OfflineDelivery::~OfflineDelivery()
+{
+    stop();
+}
+
+void OfflineDelivery::start(size_t workers)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+        return;
+    }
+    running_ = true;
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+    {
+        workers_.emplace_back(&OfflineDelivery::workerLoop, this);
+    }
+    LOG_INFO("OfflineDelivery", "离线消息补发线程数: " + std::to_string(workers_.size()));
+}
+
+void OfflineDelivery::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+        // 未完成的补发留在收件箱中，下次登录时继续
+        pending_.clear();
+    }
+    ready_.notify_all();
+    for (auto &worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void OfflineDelivery::submit(SlotHandle connection)
+{
+    schedule(connection, Clock::now());
+}
+
+void OfflineDelivery::schedule(SlotHandle connection, Clock::time_point due)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        pending_.emplace(due, connection);
+    }
+    ready_.notify_one();
+}
+
+void OfflineDelivery::workerLoop()
+{
+    while (true)
+    {
+        SlotHandle handle;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (running_ && (pending_.empty() || pending_.begin()->first > Clock::now()))
+            {
+                if (pending_.empty())
+                {
+                    ready_.wait(lock);
+                }
+                else
+                {
+                    ready_.wait_until(lock, pending_.begin()->first);
+                }
+            }
+            if (!running_)
+            {
+                return;
+            }
+            handle = pending_.begin()->second;
+            pending_.erase(pending_.begin());
+        }
+
+        std::shared_ptr<ChatConnection> connection = ConnectionManager::getInstance().getConnection(handle);
+        if (!connection)
+        {
+            continue;
+        }
+        if (!ConnectionManager::getInstance().deliverOfflineMessages(connection) && connection->isConnected())
+        {
+            schedule(handle, Clock::now() + kRetryDelay);
+        }
+    }
+}
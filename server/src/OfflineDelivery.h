@@ -0,0 +1,41 @@
+#pragma once
+
+#include "SlotMap.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 离线消息补发：登录成功后由认证线程提交连接句柄，在独立的线程中把收件箱按批交给连接。
+// 补发可能要等接收方的出站队列排空，不能占用认证线程池。
+// 出站队列长时间不回落或收件箱正由另一次登录补发时，稍后重试；连接已关闭时放弃，消息留在收件箱中
+class OfflineDelivery
+{
+public:
+    static OfflineDelivery &getInstance();
+
+    void start(size_t workers);
+    void stop();
+
+    // 服务未启动时忽略，消息留在收件箱中等下次登录
+    void submit(SlotHandle connection);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    OfflineDelivery() = default;
+    ~OfflineDelivery();
+    OfflineDelivery(const OfflineDelivery &) = delete;
+    OfflineDelivery &operator=(const OfflineDelivery &) = delete;
+
+    void workerLoop();
+    void schedule(SlotHandle connection, Clock::time_point due);
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::multimap<Clock::time_point, SlotHandle> pending_; // 按到期时间排序，重试的任务排在新任务之后
+    bool running_ = false;
+    std::vector<std::thread> workers_;
+};
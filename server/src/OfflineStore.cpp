@@ -0,0 +1,540 @@
+#include "OfflineStore.h"
+#include "AsyncLog.h"
+#include "BinaryCodec.h"
+#include "IdGenerator.h"
+#include "Message.h"
+#include "RecordIO.h"
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    const std::string kInboxSuffix = ".inbox";
+    const std::string kTempSuffix = ".tmp";
+    // 投递时每次从文件读入的字节数
+    constexpr size_t kReadChunk = 1024 * 1024;
+    // 定期清理的最小间隔
+    constexpr uint64_t kPurgeIntervalMs = 3600 * 1000;
+
+    // 解析记录负载：存入时间 + 消息的二进制编码
+    bool decodeEntry(std::string_view payload, uint64_t &storedAtMs, std::string_view &message)
+    {
+        BinaryReader reader(payload.data(), payload.size());
+        if (!reader.readVarUInt(storedAtMs) || reader.remaining() == 0)
+        {
+            return false;
+        }
+        message = payload.substr(payload.size() - reader.remaining());
+        return true;
+    }
+
+    bool endsWith(const std::string &name, const std::string &suffix)
+    {
+        return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool readRange(const std::string &path, uint64_t begin, uint64_t end, std::string &data)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            return false;
+        }
+        data.resize(end - begin);
+        bool ok = std::fseek(file, static_cast<long>(begin), SEEK_SET) == 0 &&
+                  std::fread(&data[0], 1, data.size(), file) == data.size();
+        std::fclose(file);
+        return ok;
+    }
+
+    size_t countRecords(std::string_view data)
+    {
+        size_t records = 0;
+        size_t offset = 0;
+        std::string_view payload;
+        while (RecordIO::nextRecord(data, offset, payload))
+        {
+            ++records;
+        }
+        return records;
+    }
+
+    void removeFile(const std::string &path)
+    {
+        try
+        {
+            Poco::File(path).remove();
+        }
+        catch (const Poco::Exception &)
+        {
+        }
+    }
+}
+
+OfflineStore &OfflineStore::getInstance()
+{
+    static OfflineStore instance;
+    return instance;
+}
+
+std::unique_ptr<OfflineStore> OfflineStore::create()
+{
+    return std::unique_ptr<OfflineStore>(new OfflineStore());
+}
+
+OfflineStore::OfflineStore()
+{
+}
+
+bool OfflineStore::isValidAccount(const std::string &account)
+{
+    if (account.empty() || account.size() > 64)
+    {
+        return false;
+    }
+    for (char c : account)
+    {
+        bool valid = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '_';
+        if (!valid)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string OfflineStore::inboxPath(const std::string &account) const
+{
+    return directory_ + "/" + account + kInboxSuffix;
+}
+
+bool OfflineStore::load()
+{
+    Poco::File directory(directory_);
+    directory.createDirectories();
+
+    std::vector<std::string> names;
+    directory.list(names);
+
+    uint64_t now = IdGenerator::nowMs();
+    size_t inboxes = 0;
+    size_t messages = 0;
+    std::string data;
+    for (const auto &name : names)
+    {
+        if (endsWith(name, kInboxSuffix + kTempSuffix))
+        {
+            // 改写收件箱时中断，原文件仍完整
+            removeFile(directory_ + "/" + name);
+            continue;
+        }
+        if (!endsWith(name, kInboxSuffix))
+        {
+            continue;
+        }
+        std::string account = name.substr(0, name.size() - kInboxSuffix.size());
+        std::string path = inboxPath(account);
+        if (!isValidAccount(account) || !RecordIO::readFile(path, data))
+        {
+            continue;
+        }
+
+        Inbox inbox;
+        size_t offset = 0;
+        std::string_view payload;
+        while (RecordIO::nextRecord(data, offset, payload))
+        {
+            uint64_t storedAtMs = 0;
+            std::string_view message;
+            if (!decodeEntry(payload, storedAtMs, message))
+            {
+                break;
+            }
+            inbox.bytes = offset;
+            ++inbox.messages;
+            inbox.newestMs = std::max(inbox.newestMs, storedAtMs);
+        }
+
+        if (inbox.messages == 0 || inbox.newestMs + retentionMs_ < now)
+        {
+            removeFile(path);
+            continue;
+        }
+        if (inbox.bytes != data.size())
+        {
+            LOG_WARNING("OfflineStore", "离线收件箱 " + account + " 末尾有 " + std::to_string(data.size() - inbox.bytes) + " 字节不完整记录，已截断");
+            Poco::File(path).setSize(inbox.bytes);
+        }
+
+        inboxes_.write(account, [&](auto &map)
+                       { map[account] = inbox; });
+        ++inboxes;
+        messages += inbox.messages;
+    }
+
+    lastPurgeMs_ = now;
+    LOG_INFO("OfflineStore", "已载入 " + std::to_string(inboxes) + " 个离线收件箱，共 " + std::to_string(messages) + " 条消息");
+    return true;
+}
+
+OfflineStore::EnqueueResult OfflineStore::enqueue(const std::string &account, const ChatMessage &message)
+{
+    return enqueue(account, message.serializeBinary());
+}
+
+OfflineStore::EnqueueResult OfflineStore::enqueue(const std::string &account, std::string_view message)
+{
+    if (!isValidAccount(account))
+    {
+        return EnqueueResult::FAILED;
+    }
+
+    uint64_t now = IdGenerator::nowMs();
+    std::string payload;
+    BinaryWriter writer(payload);
+    writer.writeVarUInt(now);
+    writer.writeBytes(message.data(), message.size());
+
+    std::string record;
+    RecordIO::appendRecord(record, payload);
+
+    EnqueueResult result = inboxes_.write(account, [&](auto &map)
+                                          {
+        Inbox &inbox = map[account];
+        if (inbox.messages >= maxMessages_)
+        {
+            return EnqueueResult::INBOX_FULL;
+        }
+
+        // 每条消息写入后立即交给内核，进程崩溃不会丢失；不逐条 fsync，避免阻塞转发线程
+        std::FILE *file = std::fopen(inboxPath(account).c_str(), "ab");
+        bool ok = file && std::fwrite(record.data(), 1, record.size(), file) == record.size();
+        if (file)
+        {
+            ok = std::fclose(file) == 0 && ok;
+        }
+        if (!ok)
+        {
+            if (inbox.messages == 0)
+            {
+                map.erase(account);
+            }
+            return EnqueueResult::FAILED;
+        }
+
+        inbox.bytes += record.size();
+        ++inbox.messages;
+        inbox.newestMs = now;
+        return EnqueueResult::STORED; });
+
+    if (result == EnqueueResult::FAILED)
+    {
+        LOG_ERROR("OfflineStore", "写入离线收件箱失败: " + inboxPath(account));
+    }
+
+    maybePurge(now);
+    return result;
+}
+
+OfflineStore::DeliverResult OfflineStore::deliver(const std::string &account, size_t batchSize, const BatchHandler &handler)
+{
+    DeliverResult result;
+    if (!isValidAccount(account) || batchSize == 0)
+    {
+        return result;
+    }
+
+    // 分片锁内只占用收件箱并记下当前长度，读取和回调都在锁外进行：
+    // 回调可以等待接收方的出站队列排空而不阻塞同一分片上的其他账号，期间新消息照常追加到文件末尾
+    bool busy = false;
+    bool claimed = false;
+    uint64_t claimedBytes = 0;
+    inboxes_.write(account, [&](auto &map)
+                   {
+        auto it = map.find(account);
+        if (it == map.end())
+        {
+            return;
+        }
+        if (it->second.delivering)
+        {
+            busy = true;
+            return;
+        }
+        it->second.delivering = true;
+        claimed = true;
+        claimedBytes = it->second.bytes; });
+    if (busy)
+    {
+        result.complete = false;
+        return result;
+    }
+    if (!claimed)
+    {
+        return result;
+    }
+
+    std::string path = inboxPath(account);
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        LOG_ERROR("OfflineStore", "无法读取离线收件箱: " + path);
+        finishDelivery(account, claimedBytes, 0);
+        return result;
+    }
+
+    uint64_t now = IdGenerator::nowMs();
+    uint64_t expireBefore = now > retentionMs_ ? now - retentionMs_ : 0;
+
+    // buffer 保存文件中从 bufferStart 开始的一段；consumed 之前的记录已投递或已跳过，可以从文件中去掉
+    std::string buffer;
+    uint64_t bufferStart = 0;
+    size_t offset = 0;
+    uint64_t scanned = 0;
+    uint64_t consumed = 0;
+    bool stopped = false;
+    std::vector<std::string_view> batch;
+    std::vector<uint64_t> ends; // 批内每条消息的记录在文件中的结束位置
+    batch.reserve(batchSize);
+    ends.reserve(batchSize);
+
+    auto flush = [&]()
+    {
+        size_t accepted = std::min(handler(batch), batch.size());
+        result.delivered += accepted;
+        if (accepted == batch.size())
+        {
+            consumed = scanned;
+        }
+        else
+        {
+            consumed = accepted > 0 ? ends[accepted - 1] : consumed;
+            stopped = true;
+        }
+        batch.clear();
+        ends.clear();
+    };
+
+    while (!stopped)
+    {
+        // 批内的视图指向 buffer，补读之前先把它们交出去
+        if (!batch.empty())
+        {
+            flush();
+            if (stopped)
+            {
+                break;
+            }
+        }
+        buffer.erase(0, offset);
+        bufferStart += offset;
+        offset = 0;
+
+        uint64_t bufferEnd = bufferStart + buffer.size();
+        if (bufferEnd >= claimedBytes)
+        {
+            break;
+        }
+        size_t oldSize = buffer.size();
+        buffer.resize(oldSize + static_cast<size_t>(std::min<uint64_t>(kReadChunk, claimedBytes - bufferEnd)));
+        size_t read = std::fread(&buffer[oldSize], 1, buffer.size() - oldSize, file);
+        buffer.resize(oldSize + read);
+        if (read == 0)
+        {
+            break;
+        }
+
+        std::string_view payload;
+        while (RecordIO::nextRecord(buffer, offset, payload))
+        {
+            scanned = bufferStart + offset;
+            uint64_t storedAtMs = 0;
+            std::string_view message;
+            if (!decodeEntry(payload, storedAtMs, message) || storedAtMs < expireBefore)
+            {
+                if (batch.empty())
+                {
+                    consumed = scanned;
+                }
+                continue;
+            }
+            batch.push_back(message);
+            ends.push_back(scanned);
+            if (batch.size() == batchSize)
+            {
+                flush();
+                if (stopped)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    std::fclose(file);
+
+    if (!stopped && consumed < claimedBytes && bufferStart + buffer.size() == claimedBytes)
+    {
+        // 载入时已截断残缺的尾部，这里只会是读取期间损坏的记录，无法投递，一并去掉
+        LOG_WARNING("OfflineStore", "离线收件箱 " + account + " 中有 " + std::to_string(claimedBytes - consumed) + " 字节无法解析，已丢弃");
+        consumed = claimedBytes;
+    }
+
+    // 投递期间追加的消息（路由线程在登记新连接之前查到账号离线）也要补发，由调用方稍后重试
+    bool appended = finishDelivery(account, claimedBytes, consumed);
+    result.complete = !stopped && !appended;
+    return result;
+}
+
+bool OfflineStore::finishDelivery(const std::string &account, uint64_t claimedBytes, uint64_t consumedBytes)
+{
+    std::string path = inboxPath(account);
+    std::string tempPath = path + kTempSuffix;
+
+    // 先在锁外把未投递的部分写入临时文件并刷盘，锁内只补上这期间追加的记录再改名
+    uint64_t copiedEnd = inboxes_.read(account, [&](const auto &map) -> uint64_t
+                                       {
+        auto it = map.find(account);
+        return it == map.end() ? 0 : it->second.bytes; });
+    std::string tail;
+    std::FILE *temp = nullptr;
+    bool ok = true;
+    bool appendedAfterClaim = false;
+    if (consumedBytes > 0 && consumedBytes < copiedEnd)
+    {
+        ok = readRange(path, consumedBytes, copiedEnd, tail);
+        temp = ok ? std::fopen(tempPath.c_str(), "wb") : nullptr;
+        ok = temp && std::fwrite(tail.data(), 1, tail.size(), temp) == tail.size() && RecordIO::syncFile(temp);
+    }
+
+    inboxes_.write(account, [&](auto &map)
+                   {
+        auto it = map.find(account);
+        if (it == map.end())
+        {
+            return;
+        }
+        Inbox &inbox = it->second;
+        inbox.delivering = false;
+        appendedAfterClaim = inbox.bytes > claimedBytes;
+        if (consumedBytes == 0)
+        {
+            return;
+        }
+        if (consumedBytes >= inbox.bytes)
+        {
+            removeFile(path);
+            map.erase(it);
+            return;
+        }
+
+        std::string appended;
+        if (ok && inbox.bytes > std::max(copiedEnd, consumedBytes))
+        {
+            uint64_t from = std::max(copiedEnd, consumedBytes);
+            ok = readRange(path, from, inbox.bytes, appended);
+            if (ok && !temp)
+            {
+                temp = std::fopen(tempPath.c_str(), "wb");
+                ok = temp != nullptr;
+            }
+            ok = ok && std::fwrite(appended.data(), 1, appended.size(), temp) == appended.size() && RecordIO::syncFile(temp);
+        }
+        if (temp)
+        {
+            ok = std::fclose(temp) == 0 && ok;
+            temp = nullptr;
+        }
+        if (ok)
+        {
+            try
+            {
+                Poco::File(tempPath).renameTo(path);
+            }
+            catch (const Poco::Exception &)
+            {
+                ok = false;
+            }
+        }
+        if (!ok)
+        {
+            // 原文件保持不变，已投递的消息下次登录时会重发
+            removeFile(tempPath);
+            LOG_ERROR("OfflineStore", "改写离线收件箱失败，已投递的消息将重发: " + path);
+            appendedAfterClaim = false;
+            return;
+        }
+        if (!RecordIO::syncDirectory(directory_))
+        {
+            LOG_WARNING("OfflineStore", "无法把离线收件箱改名刷到磁盘: " + directory_);
+        }
+        inbox.bytes = tail.size() + appended.size();
+        inbox.messages = countRecords(tail) + countRecords(appended); });
+    if (temp)
+    {
+        std::fclose(temp);
+        removeFile(tempPath);
+    }
+    return appendedAfterClaim;
+}
+
+size_t OfflineStore::getPendingCount(const std::string &account) const
+{
+    return inboxes_.read(account, [&](const auto &map) -> size_t
+                         {
+        auto it = map.find(account);
+        return it == map.end() ? 0 : it->second.messages; });
+}
+
+size_t OfflineStore::getInboxCount() const
+{
+    return inboxes_.size();
+}
+
+size_t OfflineStore::purgeExpired()
+{
+    uint64_t now = IdGenerator::nowMs();
+    std::vector<std::string> expired;
+    inboxes_.forEachShard([&](const auto &map)
+                          {
+        for (const auto &pair : map)
+        {
+            if (!pair.second.delivering && pair.second.newestMs + retentionMs_ < now)
+            {
+                expired.push_back(pair.first);
+            }
+        } });
+
+    size_t purged = 0;
+    for (const auto &account : expired)
+    {
+        // 收集与删除之间可能有新消息写入，删除前重新检查
+        purged += inboxes_.write(account, [&](auto &map) -> size_t
+                                 {
+            auto it = map.find(account);
+            if (it == map.end() || it->second.delivering || it->second.newestMs + retentionMs_ >= now)
+            {
+                return 0;
+            }
+            removeFile(inboxPath(account));
+            map.erase(it);
+            return 1; });
+    }
+
+    if (purged > 0)
+    {
+        LOG_INFO("OfflineStore", "已清理 " + std::to_string(purged) + " 个过期的离线收件箱");
+    }
+    return purged;
+}
+
+void OfflineStore::maybePurge(uint64_t nowMs)
+{
+    uint64_t last = lastPurgeMs_.load(std::memory_order_relaxed);
+    if (nowMs - last < kPurgeIntervalMs || !lastPurgeMs_.compare_exchange_strong(last, nowMs))
+    {
+        return;
+    }
+    purgeExpired();
+}
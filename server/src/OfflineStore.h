@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ShardedRegistry.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ChatMessage;
+
+// 离线收件箱：接收方不在线时，私聊消息追加到该账号自己的只追加日志文件
+// （<目录>/<账号>.inbox），记录格式见 RecordIO，负载为 存入时间 + 消息的二进制编码。
+// 每个账号的索引（字节数、条数、最新存入时间）常驻内存，启动时扫描目录重建。
+// 登录时在锁外分块顺序读取文件并按批回调，接收方接受的消息才从文件中去掉：
+// 全部接受后删除文件，否则把未接受的部分（连同投递期间新追加的消息）改写为新文件。
+// 投递中途崩溃时已发出的消息会在下次登录时重发（至少一次）。
+// 超过保留期的消息在投递时跳过，整箱过期的文件在启动和定期清理时删除
+class OfflineStore
+{
+public:
+    enum class EnqueueResult
+    {
+        STORED,
+        INBOX_FULL, // 该账号积压的消息数已达上限
+        FAILED
+    };
+
+    // 一批待投递消息的二进制编码负载，仅在回调期间有效。
+    // 返回按顺序接受的条数，少于整批时投递停止，其余消息留在收件箱中
+    using BatchHandler = std::function<size_t(const std::vector<std::string_view> &)>;
+
+    struct DeliverResult
+    {
+        size_t delivered = 0;
+        // 回调拒收了部分消息，或收件箱正由另一次投递占用
+        bool complete = true;
+    };
+
+    static OfflineStore &getInstance();
+    // 另开一个实例，可指向其他目录或模拟重启后重建索引
+    static std::unique_ptr<OfflineStore> create();
+
+    void setDirectory(const std::string &directory) { directory_ = directory; }
+    void setRetentionMs(uint64_t retentionMs) { retentionMs_ = retentionMs; }
+    void setMaxMessagesPerAccount(size_t maxMessages) { maxMessages_ = maxMessages; }
+
+    // 扫描目录重建索引：截断残缺的记录，删除已整体过期的收件箱和改写中断留下的临时文件
+    bool load();
+
+    EnqueueResult enqueue(const std::string &account, const ChatMessage &message);
+    // message 为聊天消息的二进制编码
+    EnqueueResult enqueue(const std::string &account, std::string_view message);
+
+    // 按顺序投递账号收件箱中的消息，未过期的消息每 batchSize 条回调一次，
+    // 回调接受的消息从收件箱中去掉。同一账号同时只有一个投递进行
+    DeliverResult deliver(const std::string &account, size_t batchSize, const BatchHandler &handler);
+
+    size_t getPendingCount(const std::string &account) const;
+    size_t getInboxCount() const;
+
+    // 删除最新消息也已过期的收件箱，返回删除的个数
+    size_t purgeExpired();
+
+    // 账号直接用作文件名，只接受字母、数字、'-' 和 '_'
+    static bool isValidAccount(const std::string &account);
+
+    OfflineStore(const OfflineStore &) = delete;
+    OfflineStore &operator=(const OfflineStore &) = delete;
+
+private:
+    OfflineStore();
+
+    struct Inbox
+    {
+        uint64_t bytes = 0;
+        size_t messages = 0;
+        uint64_t newestMs = 0;
+        bool delivering = false; // 投递期间文件只会被追加，不会被清理或改写
+    };
+
+    std::string inboxPath(const std::string &account) const;
+    // 去掉文件开头 consumedBytes 字节已投递的记录并结束投递；
+    // 返回投递期间是否有新消息追加到 claimedBytes 之后并留在了收件箱中
+    bool finishDelivery(const std::string &account, uint64_t claimedBytes, uint64_t consumedBytes);
+    void maybePurge(uint64_t nowMs);
+
+    std::string directory_ = "config/offline";
+    uint64_t retentionMs_ = 7ull * 24 * 3600 * 1000;
+    size_t maxMessages_ = 10000;
+    ShardedRegistry<std::string, Inbox> inboxes_;
+    std::atomic<uint64_t> lastPurgeMs_{0};
+};
@@ -0,0 +1,194 @@
+#include "OutboundQueue.h"
+#include "Metrics.h"
+
+namespace
+{
+    std::mutex defaultLimitsMutex;
+    OutboundLimits defaultOutboundLimits;
+
+    std::atomic<uint64_t> totalQueuedFrames{0};
+    std::atomic<uint64_t> totalQueuedBytes{0};
+    std::atomic<uint64_t> totalDroppedFrames{0};
+    std::atomic<uint64_t> totalSlowConsumerDisconnects{0};
+}
+
+SlowConsumerPolicy OutboundLimits::parsePolicy(const std::string &name)
+{
+    if (name == "disconnect")
+    {
+        return SlowConsumerPolicy::DISCONNECT;
+    }
+    if (name == "block")
+    {
+        return SlowConsumerPolicy::BLOCK;
+    }
+    return SlowConsumerPolicy::DROP_OLDEST;
+}
+
+OutboundQueue::OutboundQueue(const OutboundLimits &limits) : limits_(limits)
+{
+}
+
+OutboundQueue::~OutboundQueue()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    totalQueuedFrames -= frames_.size();
+    totalQueuedBytes -= bytes_;
+}
+
+OutboundQueue::PushResult OutboundQueue::push(const FramePtr &frame)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_)
+    {
+        return PushResult::CLOSED;
+    }
+
+    PushResult result = PushResult::QUEUED;
+    if (bytes_ + frame->size() > limits_.highWatermark)
+    {
+        switch (limits_.policy)
+        {
+        case SlowConsumerPolicy::DROP_OLDEST:
+            while (!frames_.empty() && bytes_ + frame->size() > limits_.lowWatermark)
+            {
+                dropOldestLocked();
+                result = PushResult::DROPPED;
+            }
+            break;
+        case SlowConsumerPolicy::DISCONNECT:
+            return PushResult::QUEUE_FULL;
+        case SlowConsumerPolicy::BLOCK:
+            if (!writable_.wait_for(lock, limits_.blockTimeout, [&]
+                                    { return closed_ || bytes_ + frame->size() <= limits_.lowWatermark; }))
+            {
+                return PushResult::QUEUE_FULL;
+            }
+            if (closed_)
+            {
+                return PushResult::CLOSED;
+            }
+            break;
+        }
+    }
+
+    frames_.push_back({frame, std::chrono::steady_clock::now()});
+    bytes_ += frame->size();
+    ++totalQueuedFrames;
+    totalQueuedBytes += frame->size();
+    lock.unlock();
+
+    readable_.notify_one();
+    return result;
+}
+
+void OutboundQueue::dropOldestLocked()
+{
+    size_t size = frames_.front().frame->size();
+    frames_.pop_front();
+    bytes_ -= size;
+    --totalQueuedFrames;
+    totalQueuedBytes -= size;
+    ++dropped_;
+    ++totalDroppedFrames;
+}
+
+bool OutboundQueue::popBatch(std::vector<FramePtr> &batch, size_t maxFrames, bool wait)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wait)
+    {
+        readable_.wait(lock, [&]
+                       { return closed_ || !frames_.empty(); });
+    }
+    if (frames_.empty())
+    {
+        return !closed_;
+    }
+
+    auto &metrics = Metrics::getInstance();
+    auto now = std::chrono::steady_clock::now();
+    size_t poppedBytes = 0;
+    size_t count = 0;
+    while (!frames_.empty() && count < maxFrames)
+    {
+        Entry &entry = frames_.front();
+        poppedBytes += entry.frame->size();
+        metrics.record(Metrics::ROUTE_TO_SEND, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - entry.queuedAt).count()));
+        batch.push_back(std::move(entry.frame));
+        frames_.pop_front();
+        ++count;
+    }
+    metrics.add(Metrics::BYTES_OUT, poppedBytes);
+    bytes_ -= poppedBytes;
+    totalQueuedFrames -= count;
+    totalQueuedBytes -= poppedBytes;
+    bool belowLowWatermark = bytes_ <= limits_.lowWatermark;
+    lock.unlock();
+
+    if (belowLowWatermark)
+    {
+        writable_.notify_all();
+    }
+    return true;
+}
+
+bool OutboundQueue::waitWritable(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    // popBatch 取到低水位以下和 close 都会通知 writable_
+    writable_.wait_for(lock, timeout, [&]
+                       { return closed_ || bytes_ <= limits_.lowWatermark; });
+    return !closed_ && bytes_ <= limits_.lowWatermark;
+}
+
+void OutboundQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    readable_.notify_all();
+    writable_.notify_all();
+}
+
+bool OutboundQueue::isClosed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+size_t OutboundQueue::depth() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_.size();
+}
+
+size_t OutboundQueue::bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+void OutboundQueue::setDefaultLimits(const OutboundLimits &limits)
+{
+    std::lock_guard<std::mutex> lock(defaultLimitsMutex);
+    defaultOutboundLimits = limits;
+}
+
+OutboundLimits OutboundQueue::defaultLimits()
+{
+    std::lock_guard<std::mutex> lock(defaultLimitsMutex);
+    return defaultOutboundLimits;
+}
+
+OutboundStats OutboundQueue::globalStats()
+{
+    return {totalQueuedFrames.load(std::memory_order_relaxed), totalQueuedBytes.load(std::memory_order_relaxed),
+            totalDroppedFrames.load(std::memory_order_relaxed), totalSlowConsumerDisconnects.load(std::memory_order_relaxed)};
+}
+
+void OutboundQueue::recordSlowConsumerDisconnect()
+{
+    ++totalSlowConsumerDisconnects;
+}
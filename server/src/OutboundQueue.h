@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Frame.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 慢消费者处理策略：队列字节数超过高水位时如何处理新帧
+enum class SlowConsumerPolicy
+{
+    DROP_OLDEST, // 丢弃最旧的帧直到低于低水位
+    DISCONNECT,  // 断开该连接
+    BLOCK        // 阻塞发送方直到低于低水位，超时后断开
+};
+
+struct OutboundLimits
+{
+    size_t highWatermark = 4 * 1024 * 1024;
+    size_t lowWatermark = 1024 * 1024;
+    SlowConsumerPolicy policy = SlowConsumerPolicy::DROP_OLDEST;
+    std::chrono::milliseconds blockTimeout{1000};
+    // 写者一次取出多个小帧时合并为 BATCH 帧发送
+    bool batchFrames = true;
+    // 协商启用压缩后，负载不小于该字节数的帧压缩发送；0 表示不向客户端提供压缩能力
+    size_t compressionThreshold = 1024;
+
+    static SlowConsumerPolicy parsePolicy(const std::string &name);
+};
+
+// 全部连接的出站队列汇总计数
+struct OutboundStats
+{
+    uint64_t queuedFrames;
+    uint64_t queuedBytes;
+    uint64_t droppedFrames;
+    uint64_t slowConsumerDisconnects;
+};
+
+// 每个连接一个有界出站队列，路由线程只负责入队，由连接自己的写者取出并写入套接字
+class OutboundQueue
+{
+public:
+    enum class PushResult
+    {
+        QUEUED,
+        DROPPED,    // 已入队，但按 DROP_OLDEST 丢弃了旧帧
+        QUEUE_FULL, // 超过高水位，连接应被断开
+        CLOSED
+    };
+
+    explicit OutboundQueue(const OutboundLimits &limits = defaultLimits());
+    ~OutboundQueue();
+
+    PushResult push(const FramePtr &frame);
+
+    // 取出最多 maxFrames 个帧；wait 为 true 时阻塞到有数据或队列关闭。
+    // 队列已关闭且为空时返回 false
+    bool popBatch(std::vector<FramePtr> &batch, size_t maxFrames, bool wait);
+
+    // 等待写者把队列取到低水位以下，最多等待 timeout；队列关闭时立即返回。
+    // 返回 true 表示队列未关闭且已不超过低水位
+    bool waitWritable(std::chrono::milliseconds timeout);
+
+    // 关闭后不再接受新帧，写者取完剩余帧后退出
+    void close();
+    bool isClosed() const;
+
+    const OutboundLimits &limits() const { return limits_; }
+    size_t depth() const;
+    size_t bytes() const;
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static void setDefaultLimits(const OutboundLimits &limits);
+    static OutboundLimits defaultLimits();
+    static OutboundStats globalStats();
+    static void recordSlowConsumerDisconnect();
+
+private:
+    // 入队时刻用于统计帧在队列中等待的时间
+    struct Entry
+    {
+        FramePtr frame;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    void dropOldestLocked();
+
+    const OutboundLimits limits_;
+    mutable std::mutex mutex_;
+    std::condition_variable readable_;
+    std::condition_variable writable_;
+    std::deque<Entry> frames_;
+    size_t bytes_ = 0;
+    bool closed_ = false;
+    std::atomic<uint64_t> dropped_{0};
+};
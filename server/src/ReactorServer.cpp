@@ -0,0 +1,222 @@
+#include "ReactorServer.h"
+#include "AsyncLog.h"
+#include <Poco/Net/NetException.h>
+#include <Poco/NObserver.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    constexpr size_t kMaxWriteBatch = 256;
+
+    // 每个连接占用一个文件描述符，尽量把软上限提高到硬上限
+    void raiseFileDescriptorLimit()
+    {
+#ifndef _WIN32
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &limit) == 0)
+            {
+                LOG_INFO("ReactorServer", "文件描述符上限提高到 " + std::to_string(limit.rlim_cur));
+            }
+        }
+#endif
+    }
+}
+
+ReactorConnectionHandler::ReactorConnectionHandler(Poco::Net::StreamSocket &socket, Poco::Net::SocketReactor &reactor)
+    : socket_(socket), reactor_(reactor), connection_(std::make_shared<ChatConnection>(socket)), writer_(socket_)
+{
+    // 反应器线程复用于大量连接，读写都不能阻塞：发送缓冲区满时 FrameWriter 返回 WOULD_BLOCK，等待下一次可写通知，
+    // 一个不读数据的对端不会拖住同一反应器上的其他连接
+    socket_.setBlocking(false);
+    reactor_.addEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::ReadableNotification>(*this, &ReactorConnectionHandler::onReadable));
+    reactor_.addEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::ShutdownNotification>(*this, &ReactorConnectionHandler::onShutdown));
+    reactor_.addEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::ErrorNotification>(*this, &ReactorConnectionHandler::onError));
+    connection_->setWriteNotifier([this]
+                                 { requestWrite(); });
+    connection_->open();
+}
+
+ReactorConnectionHandler::~ReactorConnectionHandler()
+{
+    reactor_.removeEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::ReadableNotification>(*this, &ReactorConnectionHandler::onReadable));
+    reactor_.removeEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::ShutdownNotification>(*this, &ReactorConnectionHandler::onShutdown));
+    reactor_.removeEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::ErrorNotification>(*this, &ReactorConnectionHandler::onError));
+    reactor_.removeEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::WritableNotification>(*this, &ReactorConnectionHandler::onWritable));
+}
+
+void ReactorConnectionHandler::onReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &)
+{
+    try
+    {
+        // 每次通知只读一次，避免单个繁忙连接独占反应器线程
+        FrameDecoder::ReadResult result = decoder_.readFrom(socket_);
+        if (result == FrameDecoder::ReadResult::CLOSED)
+        {
+            LOG_INFO("ChatConnection", "Connection " + connection_->getClientAddress() + " closed by client.");
+            destroy();
+            return;
+        }
+        if (result == FrameDecoder::ReadResult::WOULD_BLOCK)
+        {
+            // 非阻塞套接字上的虚假唤醒
+            return;
+        }
+
+        if (!processFrames() || !connection_->isConnected())
+        {
+            destroy();
+        }
+    }
+    catch (const Poco::Exception &e)
+    {
+        LOG_ERROR("ChatConnection", "Network error in connection " + connection_->getClientAddress() + ": " + e.displayText());
+        destroy();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("ChatConnection", "Error in connection " + connection_->getClientAddress() + ": " + e.what());
+        destroy();
+    }
+}
+
+bool ReactorConnectionHandler::processFrames()
+{
+    std::string_view payload;
+
+    while (connection_->isConnected() && decoder_.nextFrame(payload))
+    {
+        if (!connection_->handlePayload(payload))
+        {
+            LOG_ERROR("ChatConnection", "接收消息失败: 无法解析消息");
+            return false;
+        }
+    }
+    connection_->flushAck();
+    return true;
+}
+
+void ReactorConnectionHandler::requestWrite()
+{
+    // 只在没有注册可写事件时注册一次，可能在任意线程调用
+    if (!writeRegistered_.exchange(true))
+    {
+        reactor_.addEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::WritableNotification>(*this, &ReactorConnectionHandler::onWritable));
+    }
+}
+
+void ReactorConnectionHandler::onWritable(const Poco::AutoPtr<Poco::Net::WritableNotification> &)
+{
+    try
+    {
+        if (!flush())
+        {
+            return; // 发送缓冲区已满，等待下一次可写通知
+        }
+
+        reactor_.removeEventHandler(socket_, Poco::NObserver<ReactorConnectionHandler, Poco::Net::WritableNotification>(*this, &ReactorConnectionHandler::onWritable));
+        writeRegistered_ = false;
+
+        // 清空队列与注销事件之间可能有新帧入队，此时入队方看到的标记仍为已注册
+        if (connection_->outbound().depth() > 0)
+        {
+            requestWrite();
+        }
+    }
+    catch (const Poco::Exception &e)
+    {
+        LOG_ERROR("ChatConnection", "发送消息失败: " + e.displayText());
+        destroy();
+    }
+}
+
+bool ReactorConnectionHandler::flush()
+{
+    // 上次未写完的数据优先，之后把队列中积压的帧合并为一次 writev
+    while (writer_.flush() == FrameWriter::FlushResult::COMPLETE)
+    {
+        writeBatch_.clear();
+        if (!connection_->outbound().popBatch(writeBatch_, kMaxWriteBatch, false) || writeBatch_.empty())
+        {
+            return true;
+        }
+        writer_.setCompressionThreshold(connection_->getCompressionThreshold());
+        if (connection_->getBatchFrames())
+        {
+            writer_.enqueueBatched(writeBatch_);
+        }
+        else
+        {
+            for (const auto &frame : writeBatch_)
+            {
+                writer_.enqueue(frame);
+            }
+        }
+    }
+    return false;
+}
+
+void ReactorConnectionHandler::onShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification> &)
+{
+    destroy();
+}
+
+void ReactorConnectionHandler::onError(const Poco::AutoPtr<Poco::Net::ErrorNotification> &)
+{
+    destroy();
+}
+
+void ReactorConnectionHandler::destroy()
+{
+    // 尽力写出剩余的帧（例如被踢下线的通知）：非阻塞套接字上只写到发送缓冲区满为止，写不下的直接丢弃
+    try
+    {
+        if (!flush())
+        {
+            LOG_INFO("ChatConnection", "Connection " + connection_->getClientAddress() + " closed with unsent frames discarded.");
+        }
+    }
+    catch (const Poco::Exception &)
+    {
+    }
+    connection_->close();
+    delete this;
+}
+
+ReactorServer::ReactorServer(const Poco::Net::ServerSocket &socket, unsigned ioThreads)
+    : socket_(socket), ioThreads_(ioThreads == 0 ? 1 : ioThreads), acceptThread_("ReactorAcceptor")
+{
+}
+
+ReactorServer::~ReactorServer()
+{
+    stop();
+}
+
+void ReactorServer::start()
+{
+    raiseFileDescriptorLimit();
+
+    // 接受连接的反应器只负责 accept，新连接按轮询分配给 ioThreads_ 个 I/O 反应器
+    acceptor_ = std::make_unique<Acceptor>(socket_, acceptReactor_, ioThreads_);
+    acceptThread_.start(acceptReactor_);
+
+    LOG_INFO("ReactorServer", "事件驱动模式已启动，I/O 线程数: " + std::to_string(ioThreads_));
+}
+
+void ReactorServer::stop()
+{
+    if (!acceptor_)
+    {
+        return;
+    }
+
+    acceptReactor_.stop();
+    acceptThread_.join();
+    // 销毁接收器会停止各 I/O 反应器，剩余连接在 ShutdownNotification 中清理
+    acceptor_.reset();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ChatConnection.h"
+#include "FrameDecoder.h"
+#include "FrameWriter.h"
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketReactor.h>
+#include <Poco/Net/SocketNotification.h>
+#include <Poco/Net/ParallelSocketAcceptor.h>
+#include <Poco/AutoPtr.h>
+#include <Poco/Thread.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 事件驱动模式下的单个连接：由所属反应器线程在套接字可读时回调，
+// 把收到的字节拼成完整的帧后交给 ChatConnection 处理
+class ReactorConnectionHandler
+{
+public:
+    ReactorConnectionHandler(Poco::Net::StreamSocket &socket, Poco::Net::SocketReactor &reactor);
+    ~ReactorConnectionHandler();
+
+    void onReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &notification);
+    void onWritable(const Poco::AutoPtr<Poco::Net::WritableNotification> &notification);
+    void onShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification> &notification);
+    void onError(const Poco::AutoPtr<Poco::Net::ErrorNotification> &notification);
+
+private:
+    bool processFrames();
+    void requestWrite();
+    bool flush();
+    void destroy();
+
+    Poco::Net::StreamSocket socket_;
+    Poco::Net::SocketReactor &reactor_;
+    std::shared_ptr<ChatConnection> connection_;
+    FrameDecoder decoder_;
+
+    FrameWriter writer_;
+    std::vector<FramePtr> writeBatch_;
+    std::atomic<bool> writeRegistered_{false};
+};
+
+// 少量固定的 I/O 线程，每个线程运行一个反应器（Linux 下基于 epoll），复用大量非阻塞连接
+class ReactorServer
+{
+public:
+    ReactorServer(const Poco::Net::ServerSocket &socket, unsigned ioThreads);
+    ~ReactorServer();
+
+    void start();
+    void stop();
+
+private:
+    using Acceptor = Poco::Net::ParallelSocketAcceptor<ReactorConnectionHandler, Poco::Net::SocketReactor>;
+
+    Poco::Net::ServerSocket socket_;
+    unsigned ioThreads_;
+    Poco::Net::SocketReactor acceptReactor_;
+    Poco::Thread acceptThread_;
+    std::unique_ptr<Acceptor> acceptor_;
+};
@@ -0,0 +1,105 @@
+#include "RecordIO.h"
+#include <Poco/Checksum.h>
+#include <fstream>
+#include <iterator>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace RecordIO
+{
+    void putUInt32(std::string &out, uint32_t value)
+    {
+        out.push_back(static_cast<char>((value >> 24) & 0xFF));
+        out.push_back(static_cast<char>((value >> 16) & 0xFF));
+        out.push_back(static_cast<char>((value >> 8) & 0xFF));
+        out.push_back(static_cast<char>(value & 0xFF));
+    }
+
+    uint32_t getUInt32(const char *data)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+        return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+    }
+
+    uint32_t crc32(const char *data, size_t length)
+    {
+        Poco::Checksum checksum(Poco::Checksum::TYPE_CRC32);
+        checksum.update(data, static_cast<unsigned>(length));
+        return checksum.checksum();
+    }
+
+    void appendRecord(std::string &out, std::string_view payload)
+    {
+        putUInt32(out, static_cast<uint32_t>(payload.size()));
+        putUInt32(out, crc32(payload.data(), payload.size()));
+        out.append(payload.data(), payload.size());
+    }
+
+    bool nextRecord(std::string_view data, size_t &offset, std::string_view &payload)
+    {
+        if (data.size() - offset < kHeaderSize)
+        {
+            return false;
+        }
+        uint32_t length = getUInt32(data.data() + offset);
+        uint32_t checksum = getUInt32(data.data() + offset + 4);
+        if (data.size() - offset - kHeaderSize < length)
+        {
+            return false;
+        }
+        const char *start = data.data() + offset + kHeaderSize;
+        if (crc32(start, length) != checksum)
+        {
+            return false;
+        }
+        payload = std::string_view(start, length);
+        offset += kHeaderSize + length;
+        return true;
+    }
+
+    bool readFile(const std::string &path, std::string &data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool syncFile(std::FILE *file)
+    {
+        if (std::fflush(file) != 0)
+        {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return ::fsync(fileno(file)) == 0;
+#endif
+    }
+
+    bool syncDirectory(const std::string &path)
+    {
+#ifdef _WIN32
+        // NTFS 的目录元数据由文件系统日志保证，无法对目录句柄 fsync
+        (void)path;
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// 服务器各持久化文件共用的记录格式：4字节网络序长度 + 4字节CRC32 + 负载。
+// 写入中途崩溃留下的残缺记录在读取时因长度不足或校验失败而被识别
+namespace RecordIO
+{
+    constexpr size_t kHeaderSize = 8;
+
+    void putUInt32(std::string &out, uint32_t value);
+    uint32_t getUInt32(const char *data);
+    uint32_t crc32(const char *data, size_t length);
+
+    // 在 out 末尾追加一条带长度和校验的记录
+    void appendRecord(std::string &out, std::string_view payload);
+
+    // 从 offset 处读取一条完整记录并前移 offset；残缺或校验失败时返回 false，offset 不变
+    bool nextRecord(std::string_view data, size_t &offset, std::string_view &payload);
+
+    bool readFile(const std::string &path, std::string &data);
+
+    // 把用户态缓冲和内核页缓存都刷到磁盘
+    bool syncFile(std::FILE *file);
+    // 把目录项（新建、改名）刷到磁盘，否则掉电后改名可能丢失
+    bool syncDirectory(const std::string &path);
+}
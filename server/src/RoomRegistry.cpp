@@ -0,0 +1,77 @@
+#include "RoomRegistry.h"
+
+RoomRegistry &RoomRegistry::getInstance()
+{
+    static RoomRegistry instance;
+    return instance;
+}
+
+std::unique_ptr<RoomRegistry> RoomRegistry::create()
+{
+    return std::unique_ptr<RoomRegistry>(new RoomRegistry());
+}
+
+void RoomRegistry::setShardCount(size_t shards)
+{
+    rooms_ = std::make_unique<ShardedRegistry<std::string, Members>>(shards);
+}
+
+bool RoomRegistry::join(const std::string &room, SlotHandle member)
+{
+    return rooms_->write(room, [&](auto &rooms)
+                         { return rooms[room].insert(member.pack()).second; });
+}
+
+bool RoomRegistry::leave(const std::string &room, SlotHandle member)
+{
+    return rooms_->write(room, [&](auto &rooms)
+                         {
+        auto it = rooms.find(room);
+        if (it == rooms.end() || it->second.erase(member.pack()) == 0)
+        {
+            return false;
+        }
+        if (it->second.empty())
+        {
+            rooms.erase(it);
+        }
+        return true; });
+}
+
+bool RoomRegistry::isMember(const std::string &room, SlotHandle member) const
+{
+    return rooms_->read(room, [&](const auto &rooms)
+                        {
+        auto it = rooms.find(room);
+        return it != rooms.end() && it->second.count(member.pack()) != 0; });
+}
+
+void RoomRegistry::getMembers(const std::string &room, std::vector<SlotHandle> &members) const
+{
+    members.clear();
+    rooms_->read(room, [&](const auto &rooms)
+                 {
+        auto it = rooms.find(room);
+        if (it == rooms.end())
+        {
+            return;
+        }
+        members.reserve(it->second.size());
+        for (uint64_t member : it->second)
+        {
+            members.push_back(SlotHandle::unpack(member));
+        } });
+}
+
+size_t RoomRegistry::getRoomCount() const
+{
+    return rooms_->size();
+}
+
+size_t RoomRegistry::getMemberCount(const std::string &room) const
+{
+    return rooms_->read(room, [&](const auto &rooms) -> size_t
+                        {
+        auto it = rooms.find(room);
+        return it == rooms.end() ? 0 : it->second.size(); });
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ShardedRegistry.h"
+#include "SlotMap.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// 房间成员表：按房间名哈希分片，每个房间保存成员连接的句柄集合。
+// 房间消息只遍历该房间的成员，开销与房间大小成正比，与在线总人数无关。
+// 成员以句柄登记，投递时再由 ConnectionManager 校验，已断开的成员查找失败即跳过
+class RoomRegistry
+{
+public:
+    static RoomRegistry &getInstance();
+    // 与全局实例互不相干的新成员表，基准测试用它对比不同投递方式
+    static std::unique_ptr<RoomRegistry> create();
+
+    // 已在房间中时返回 false；房间在第一个成员加入时创建
+    bool join(const std::string &room, SlotHandle member);
+    // 不在房间中时返回 false；最后一个成员离开后房间被删除
+    bool leave(const std::string &room, SlotHandle member);
+    bool isMember(const std::string &room, SlotHandle member) const;
+
+    // 在分片共享锁内复制成员句柄，随后的投递不持有房间锁
+    void getMembers(const std::string &room, std::vector<SlotHandle> &members) const;
+
+    size_t getRoomCount() const;
+    size_t getMemberCount(const std::string &room) const;
+
+    // 分片数只能在接受连接之前设置
+    void setShardCount(size_t shards);
+
+    RoomRegistry(const RoomRegistry &) = delete;
+    RoomRegistry &operator=(const RoomRegistry &) = delete;
+
+private:
+    RoomRegistry() = default;
+
+    // 成员集合以打包后的句柄为键
+    using Members = std::unordered_set<uint64_t>;
+
+    std::unique_ptr<ShardedRegistry<std::string, Members>> rooms_ =
+        std::make_unique<ShardedRegistry<std::string, Members>>();
+};
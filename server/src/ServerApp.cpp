@@ -1,5 +1,19 @@
 #include "ServerApp.h"
+#include "AsyncLog.h"
 #include "ChatConnection.h"
+#include "ReactorServer.h"
+#include "OutboundQueue.h"
+#include "IdGenerator.h"
+#include "UserManager.h"
+#include "AuthService.h"
+#include "ConnectionManager.h"
+#include "ConversationSequencer.h"
+#include "OfflineDelivery.h"
+#include "OfflineStore.h"
+#include "HistoryStore.h"
+#include "IdleReaper.h"
+#include "MetricsServer.h"
+#include "RoomRegistry.h"
 #include <Poco/Net/TCPServerParams.h>
 #include <Poco/Net/ServerSocket.h>
 #include <Poco/Util/PropertyFileConfiguration.h>
@@ -8,14 +22,21 @@
 #include <Poco/File.h>
 #include <iostream>
 
+void ChatConnectionHandler::run()
+{
+    auto connection = std::make_shared<ChatConnection>(socket());
+    connection->run();
+}
+
 // 连接工厂实现
 Poco::Net::TCPServerConnection *ChatConnectionFactory::createConnection(const Poco::Net::StreamSocket &socket)
 {
-    return new ChatConnection(socket);
+    return new ChatConnectionHandler(socket);
 }
 
 ServerApp::ServerApp()
-    : port_(9999), host_("0.0.0.0"), maxConnections_(100)
+    : port_(9999), host_("0.0.0.0"), maxConnections_(100), mode_("threaded"), ioThreads_(4), authWorkers_(4), authMaxQueue_(10000),
+      offlineWorkers_(2), logBufferSize_(65536), metricsPort_(9100), idleTimeout_(300)
 {
 }
 
@@ -28,20 +49,24 @@ void ServerApp::initialize(Poco::Util::Application &self)
     // 先调用父类初始化
     ServerApplication::initialize(self);
 
+    // 默认输出 information 及以上级别，配置文件中的 logging.level 在加载时覆盖
+    AsyncLog::getInstance().setLevel(Poco::Message::PRIO_INFORMATION);
+
     // 加载配置文件
     loadConfiguration();
 
-    // 简化日志设置
-    Poco::Logger::root().setLevel(Poco::Message::PRIO_INFORMATION);
+    // 用户目录只在启动时载入一次
+    auto &userManager = UserManager::getInstance();
+    userManager.load();
+    LOG_INFO("ServerApp", "已载入 " + std::to_string(userManager.getUserCount()) + " 个用户");
+    OfflineStore::getInstance().load();
 
-    auto &logger = Poco::Logger::get("ServerApp");
-    logger.information("服务器初始化完成");
+    LOG_INFO("ServerApp", "服务器初始化完成");
 }
 
 void ServerApp::uninitialize()
 {
-    auto &logger = Poco::Logger::get("ServerApp");
-    logger.information("服务器正在关闭...");
+    LOG_INFO("ServerApp", "服务器正在关闭...");
 
     ServerApplication::uninitialize();
 }
@@ -61,73 +86,160 @@ void ServerApp::loadConfiguration()
             Poco::Util::LayeredConfiguration &config = Poco::Util::Application::config();
             config.add(pConfig, "file", 100, false);
 
+            // 日志级别最先生效，之后的配置日志按新级别过滤
+            if (!config.getBool("logging.enabled", true))
+            {
+                AsyncLog::getInstance().setLevel(0);
+            }
+            else
+            {
+                try
+                {
+                    AsyncLog::getInstance().setLevel(Poco::Logger::parseLevel(config.getString("logging.level", "information")));
+                }
+                catch (const Poco::Exception &e)
+                {
+                    LOG_WARNING("ServerApp", "无效的日志级别，使用 information: " + e.displayText());
+                }
+            }
+            logBufferSize_ = static_cast<size_t>(config.getInt("logging.bufferSize", 65536));
+
             // 读取配置值
             port_ = config.getInt("server.port", 9999);
             host_ = config.getString("server.host", "0.0.0.0");
             maxConnections_ = config.getInt("server.maxConnections", 100);
-
-            auto &logger = Poco::Logger::get("ServerApp");
-            logger.information("配置文件加载成功");
+            mode_ = config.getString("server.mode", "threaded");
+            ioThreads_ = config.getInt("server.ioThreads", 4);
+            size_t registryShards = static_cast<size_t>(config.getInt("server.registryShards", 64));
+            ConnectionManager::getInstance().setShardCount(registryShards);
+            RoomRegistry::getInstance().setShardCount(registryShards);
+            authWorkers_ = config.getInt("auth.workers", 4);
+            authMaxQueue_ = config.getInt("auth.maxQueue", 10000);
+            metricsPort_ = config.getInt("metrics.port", 9100);
+            idleTimeout_ = config.getInt("server.timeout", 300);
+            offlineWorkers_ = config.getInt("offline.deliveryWorkers", 2);
+            auto &offlineStore = OfflineStore::getInstance();
+            offlineStore.setDirectory(config.getString("offline.directory", "config/offline"));
+            offlineStore.setRetentionMs(static_cast<uint64_t>(config.getInt("offline.retentionHours", 168)) * 3600 * 1000);
+            offlineStore.setMaxMessagesPerAccount(static_cast<size_t>(config.getInt("offline.maxMessages", 10000)));
+            auto &historyStore = HistoryStore::getInstance();
+            historyStore.setDirectory(config.getString("history.directory", "config/history"));
+            historyStore.setSegmentBytes(static_cast<size_t>(config.getInt("history.segmentMB", 64)) * 1024 * 1024);
+            ConversationSequencer::getInstance().setIdleMs(static_cast<int64_t>(config.getInt("history.sequenceIdleMinutes", 60)) * 60 * 1000);
+            IdGenerator::getInstance().setNodeId(static_cast<uint16_t>(config.getInt("server.nodeId", 0)));
+
+            OutboundLimits limits;
+            limits.highWatermark = static_cast<size_t>(config.getInt("outbound.highWatermark", static_cast<int>(limits.highWatermark)));
+            limits.lowWatermark = static_cast<size_t>(config.getInt("outbound.lowWatermark", static_cast<int>(limits.lowWatermark)));
+            limits.policy = OutboundLimits::parsePolicy(config.getString("outbound.slowConsumerPolicy", "drop_oldest"));
+            limits.blockTimeout = std::chrono::milliseconds(config.getInt("outbound.blockTimeoutMs", 1000));
+            limits.batchFrames = config.getBool("outbound.batchFrames", true);
+            limits.compressionThreshold = static_cast<size_t>(config.getInt("outbound.compressionThreshold", static_cast<int>(limits.compressionThreshold)));
+            OutboundQueue::setDefaultLimits(limits);
+
+            LOG_INFO("ServerApp", "配置文件加载成功");
         }
         else
         {
-            auto &logger = Poco::Logger::get("ServerApp");
-            logger.warning("配置文件未找到，使用默认设置");
+            LOG_WARNING("ServerApp", "配置文件未找到，使用默认设置");
         }
     }
     catch (const std::exception &e)
     {
-        auto &logger = Poco::Logger::get("ServerApp");
-        logger.warning("无法加载配置文件，使用默认设置: " + std::string(e.what()));
+        LOG_WARNING("ServerApp", "无法加载配置文件，使用默认设置: " + std::string(e.what()));
     }
 
-    auto &logger = Poco::Logger::get("ServerApp");
-    logger.information("监听地址: " + host_);
-    logger.information("端口: " + std::to_string(port_));
-    logger.information("最大连接数: " + std::to_string(maxConnections_));
+    LOG_INFO("ServerApp", "监听地址: " + host_);
+    LOG_INFO("ServerApp", "端口: " + std::to_string(port_));
+    LOG_INFO("ServerApp", "最大连接数: " + std::to_string(maxConnections_));
+    LOG_INFO("ServerApp", "运行模式: " + mode_);
 }
 
 int ServerApp::main(const std::vector<std::string> &args)
 {
-    auto &logger = Poco::Logger::get("ServerApp");
+    // 此后的日志由后台线程输出
+    AsyncLog::getInstance().start(logBufferSize_);
 
     try
     {
-        // 创建服务器套接字
-        Poco::Net::ServerSocket serverSocket(port_);
+        // 登录在独立的认证线程池中完成，先于接受连接启动
+        AuthService::getInstance().start(static_cast<size_t>(authWorkers_), static_cast<size_t>(authMaxQueue_));
+        OfflineDelivery::getInstance().start(static_cast<size_t>(offlineWorkers_));
+        if (!HistoryStore::getInstance().start())
+        {
+            LOG_WARNING("ServerApp", "聊天历史不可用，消息将不会被记录");
+        }
+        IdleReaper::getInstance().start(idleTimeout_);
 
-        // 设置服务器参数
-        Poco::AutoPtr<Poco::Net::TCPServerParams> params = new Poco::Net::TCPServerParams;
-        params->setMaxThreads(maxConnections_);
-        params->setThreadIdleTime(Poco::Timespan(10, 0)); // 10秒空闲时间
+        // 创建服务器套接字
+        // 事件驱动模式需要承接大量并发连接，加大 accept 队列
+        Poco::Net::ServerSocket serverSocket(port_, mode_ == "reactor" ? 1024 : 64);
 
-        // 创建服务器
-        server_ = std::make_unique<Poco::Net::TCPServer>(
-            new ChatConnectionFactory(),
-            serverSocket,
-            params);
+        if (mode_ == "reactor")
+        {
+            reactorServer_ = std::make_unique<ReactorServer>(serverSocket, static_cast<unsigned>(ioThreads_));
+            reactorServer_->start();
+        }
+        else
+        {
+            // 设置服务器参数
+            Poco::AutoPtr<Poco::Net::TCPServerParams> params = new Poco::Net::TCPServerParams;
+            params->setMaxThreads(maxConnections_);
+            params->setThreadIdleTime(Poco::Timespan(10, 0)); // 10秒空闲时间
+
+            // 创建服务器
+            server_ = std::make_unique<Poco::Net::TCPServer>(
+                new ChatConnectionFactory(),
+                serverSocket,
+                params);
+
+            // 启动服务器
+            server_->start();
+        }
 
-        // 启动服务器
-        server_->start();
+        if (metricsPort_ > 0)
+        {
+            metricsServer_ = std::make_unique<MetricsServer>(host_, metricsPort_);
+            metricsServer_->start();
+            LOG_INFO("ServerApp", "指标服务端口: " + std::to_string(metricsPort_) + " (/metrics, /stats)");
+        }
 
-        logger.information("聊天服务器启动成功");
-        logger.information("按 Ctrl+C 停止服务器");
+        LOG_INFO("ServerApp", "聊天服务器启动成功");
+        LOG_INFO("ServerApp", "按 Ctrl+C 停止服务器");
 
         // 等待终止信号
         waitForTerminationRequest();
 
-        logger.information("收到终止信号，正在关闭服务器...");
+        LOG_INFO("ServerApp", "收到终止信号，正在关闭服务器...");
 
         // 停止服务器
-        server_->stop();
+        if (metricsServer_)
+        {
+            metricsServer_->stop();
+        }
+        if (server_)
+        {
+            server_->stop();
+        }
+        if (reactorServer_)
+        {
+            reactorServer_->stop();
+        }
+        IdleReaper::getInstance().stop();
+        AuthService::getInstance().logStats();
+        AuthService::getInstance().stop();
+        OfflineDelivery::getInstance().stop();
+        HistoryStore::getInstance().stop();
 
-        logger.information("服务器已停止");
+        LOG_INFO("ServerApp", "服务器已停止");
     }
     catch (const std::exception &e)
     {
-        logger.fatal("服务器启动失败: " + std::string(e.what()));
+        LOG_FATAL("ServerApp", "服务器启动失败: " + std::string(e.what()));
+        AsyncLog::getInstance().stop();
         return Poco::Util::Application::EXIT_SOFTWARE;
     }
 
+    AsyncLog::getInstance().stop();
     return Poco::Util::Application::EXIT_OK;
 }
@@ -6,6 +6,16 @@
 #include <memory>
 
 class ChatConnection;
+class ReactorServer;
+class MetricsServer;
+
+// 线程模式下的连接：TCPServer 为每个连接分配一个线程运行 ChatConnection
+class ChatConnectionHandler : public Poco::Net::TCPServerConnection
+{
+public:
+    using TCPServerConnection::TCPServerConnection;
+    void run() override;
+};
 
 class ChatConnectionFactory : public Poco::Net::TCPServerConnectionFactory
 {
@@ -28,8 +38,18 @@ private:
     void loadConfiguration();
 
     std::unique_ptr<Poco::Net::TCPServer> server_;
+    std::unique_ptr<ReactorServer> reactorServer_;
+    std::unique_ptr<MetricsServer> metricsServer_;
     bool helpRequested_;
     int port_;
     std::string host_;
     int maxConnections_;
+    std::string mode_; // threaded 或 reactor
+    int ioThreads_;
+    int authWorkers_;
+    int authMaxQueue_;
+    int offlineWorkers_;   // 离线消息补发线程数
+    size_t logBufferSize_; // 异步日志缓冲区的记录数
+    int metricsPort_;      // 0 表示不启动指标服务
+    int idleTimeout_;      // 秒，0 表示不回收空闲连接
 };
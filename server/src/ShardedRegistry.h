@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// 按键哈希分片的映射表，每个分片有独立的读写锁。
+// 不同分片上的查找与修改互不竞争；遍历时逐个分片加共享锁，不存在全局停顿。
+// 回调在分片锁内执行，期间被引用的值不会被其他线程移除
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedRegistry
+{
+public:
+    using Map = std::unordered_map<Key, Value, Hash>;
+
+    explicit ShardedRegistry(size_t shardCount = 64)
+        : shardCount_(shardCount == 0 ? 1 : shardCount), shards_(new Shard[shardCount_])
+    {
+    }
+
+    size_t shardCount() const { return shardCount_; }
+    size_t shardIndex(const Key &key) const { return Hash{}(key) % shardCount_; }
+
+    // 在键所属分片的独占锁内修改
+    template <typename Fn>
+    decltype(auto) write(const Key &key, Fn &&fn)
+    {
+        Shard &shard = shards_[shardIndex(key)];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return fn(shard.map);
+    }
+
+    // 在键所属分片的共享锁内读取
+    template <typename Fn>
+    decltype(auto) read(const Key &key, Fn &&fn) const
+    {
+        const Shard &shard = shards_[shardIndex(key)];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return fn(static_cast<const Map &>(shard.map));
+    }
+
+    // 依次在每个分片的共享锁内遍历
+    template <typename Fn>
+    void forEachShard(Fn &&fn) const
+    {
+        for (size_t i = 0; i < shardCount_; ++i)
+        {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            fn(static_cast<const Map &>(shards_[i].map));
+        }
+    }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        forEachShard([&](const Map &map)
+                     { total += map.size(); });
+        return total;
+    }
+
+private:
+    // 每个分片独占缓存行，避免相邻分片的锁互相伪共享
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        Map map;
+    };
+
+    size_t shardCount_;
+    std::unique_ptr<Shard[]> shards_;
+};
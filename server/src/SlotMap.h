@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+// 槽位句柄：槽位下标加代号。槽位被释放时代号递增，
+// 旧句柄因代号不符而查找失败，不会误指向复用该槽位的新对象
+struct SlotHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0; // 0 表示空句柄，有效槽位的代号从 1 开始
+
+    bool isNull() const { return generation == 0; }
+    uint64_t pack() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+    static SlotHandle unpack(uint64_t value) { return {static_cast<uint32_t>(value), static_cast<uint32_t>(value >> 32)}; }
+
+    bool operator==(const SlotHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlotHandle &other) const { return !(*this == other); }
+};
+
+// 槽位表：插入、删除、查找都是 O(1)。
+// 空闲槽位串成链表复用，存储连续，不做哈希。非线程安全
+template <typename T>
+class SlotMap
+{
+public:
+    SlotHandle insert(T value)
+    {
+        uint32_t index;
+        if (freeHead_ != kNoFree)
+        {
+            index = freeHead_;
+            freeHead_ = slots_[index].nextFree;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        Slot &slot = slots_[index];
+        slot.value = std::move(value);
+        slot.occupied = true;
+        ++size_;
+        return {index, slot.generation};
+    }
+
+    bool erase(SlotHandle handle)
+    {
+        Slot *slot = find(handle);
+        if (!slot)
+        {
+            return false;
+        }
+        slot->value = T();
+        slot->occupied = false;
+        // 代号回绕时跳过 0，保持空句柄永远无效
+        if (++slot->generation == 0)
+        {
+            slot->generation = 1;
+        }
+        slot->nextFree = freeHead_;
+        freeHead_ = handle.index;
+        --size_;
+        return true;
+    }
+
+    // 句柄已失效时返回 nullptr
+    T *get(SlotHandle handle)
+    {
+        Slot *slot = find(handle);
+        return slot ? &slot->value : nullptr;
+    }
+
+    const T *get(SlotHandle handle) const
+    {
+        return const_cast<SlotMap *>(this)->get(handle);
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    static constexpr uint32_t kNoFree = UINT32_MAX;
+
+    struct Slot
+    {
+        T value{};
+        uint32_t generation = 1;
+        uint32_t nextFree = kNoFree;
+        bool occupied = false;
+    };
+
+    Slot *find(SlotHandle handle)
+    {
+        if (handle.index >= slots_.size())
+        {
+            return nullptr;
+        }
+        Slot &slot = slots_[handle.index];
+        return slot.occupied && slot.generation == handle.generation ? &slot : nullptr;
+    }
+
+    std::vector<Slot> slots_;
+    uint32_t freeHead_ = kNoFree;
+    size_t size_ = 0;
+};
+
+// 分片的槽位表，每个分片有独立的读写锁。
+// 新对象轮流放入各分片；分片号编码在句柄下标的低位（下标 = 分片内下标 * 分片数 + 分片号），
+// 由句柄即可定位分片，无需哈希。回调在分片锁内执行，期间槽位中的值不会被移除
+template <typename T>
+class ShardedSlotMap
+{
+public:
+    explicit ShardedSlotMap(size_t shardCount = 64)
+        : shardCount_(shardCount == 0 ? 1 : static_cast<uint32_t>(shardCount)), shards_(new Shard[shardCount_])
+    {
+    }
+
+    size_t shardCount() const { return shardCount_; }
+
+    SlotHandle insert(T value)
+    {
+        uint32_t shardIndex = nextShard_.fetch_add(1, std::memory_order_relaxed) % shardCount_;
+        Shard &shard = shards_[shardIndex];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        SlotHandle local = shard.slots.insert(std::move(value));
+        return {local.index * shardCount_ + shardIndex, local.generation};
+    }
+
+    // 句柄有效时在分片独占锁内调用 fn(T &)，否则返回 false
+    template <typename Fn>
+    bool write(SlotHandle handle, Fn &&fn)
+    {
+        Shard &shard = shards_[handle.index % shardCount_];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        T *value = shard.slots.get(toLocal(handle));
+        if (!value)
+        {
+            return false;
+        }
+        fn(*value);
+        return true;
+    }
+
+    // 句柄有效时在分片共享锁内调用 fn(const T &)，否则返回 false
+    template <typename Fn>
+    bool read(SlotHandle handle, Fn &&fn) const
+    {
+        const Shard &shard = shards_[handle.index % shardCount_];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        const T *value = shard.slots.get(toLocal(handle));
+        if (!value)
+        {
+            return false;
+        }
+        fn(*value);
+        return true;
+    }
+
+    // 句柄有效时在分片独占锁内先调用 fn(T &)，再释放槽位
+    template <typename Fn>
+    bool erase(SlotHandle handle, Fn &&fn)
+    {
+        Shard &shard = shards_[handle.index % shardCount_];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        SlotHandle local = toLocal(handle);
+        T *value = shard.slots.get(local);
+        if (!value)
+        {
+            return false;
+        }
+        fn(*value);
+        return shard.slots.erase(local);
+    }
+
+    bool erase(SlotHandle handle)
+    {
+        return erase(handle, [](T &) {});
+    }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        for (uint32_t i = 0; i < shardCount_; ++i)
+        {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            total += shards_[i].slots.size();
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        SlotMap<T> slots;
+    };
+
+    SlotHandle toLocal(SlotHandle handle) const { return {handle.index / shardCount_, handle.generation}; }
+
+    uint32_t shardCount_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint32_t> nextShard_{0};
+};
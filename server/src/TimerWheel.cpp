@@ -0,0 +1,68 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(uint64_t startTick) : current_(startTick)
+{
+}
+
+void TimerWheel::schedule(uint64_t id, uint64_t expiryTick)
+{
+    if (expiryTick <= current_)
+    {
+        expiryTick = current_ + 1;
+    }
+    else if (expiryTick - current_ > kMaxDelay)
+    {
+        expiryTick = current_ + kMaxDelay;
+    }
+    place({id, expiryTick});
+    ++size_;
+}
+
+void TimerWheel::place(const Entry &entry)
+{
+    uint64_t delay = entry.expiry - current_;
+    size_t level = 0;
+    while (level + 1 < kLevels && (delay >> (kSlotBits * (level + 1))) != 0)
+    {
+        ++level;
+    }
+    size_t slot = static_cast<size_t>(entry.expiry >> (kSlotBits * level)) & (kSlots - 1);
+    slots_[level][slot].push_back(entry);
+}
+
+void TimerWheel::cascade(size_t level)
+{
+    size_t slot = static_cast<size_t>(current_ >> (kSlotBits * level)) & (kSlots - 1);
+    std::vector<Entry> entries;
+    entries.swap(slots_[level][slot]);
+    for (const auto &entry : entries)
+    {
+        place(entry);
+    }
+}
+
+void TimerWheel::advance(uint64_t tick, std::vector<uint64_t> &expired)
+{
+    while (current_ < tick)
+    {
+        ++current_;
+
+        // 进入高层槽位对应的区间时，先从最高层开始把其中的定时器下沉
+        for (size_t level = kLevels - 1; level > 0; --level)
+        {
+            uint64_t mask = (uint64_t(1) << (kSlotBits * level)) - 1;
+            if ((current_ & mask) == 0)
+            {
+                cascade(level);
+            }
+        }
+
+        auto &due = slots_[0][static_cast<size_t>(current_) & (kSlots - 1)];
+        for (const auto &entry : due)
+        {
+            expired.push_back(entry.id);
+        }
+        size_ -= due.size();
+        due.clear();
+    }
+}
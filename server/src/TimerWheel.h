@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 分层时间轮：4 层，每层 64 个槽，以 tick 为单位可表示约 1600 万个 tick 之内的到期时间。
+// 登记和每个 tick 的推进都是 O(1)（高层槽位每 64 个 tick 才下沉一次，均摊到每个定时器上是常数），
+// 与定时器总数无关。不支持取消：调用方在到期时自行校验 id 是否仍然有效。非线程安全
+class TimerWheel
+{
+public:
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr size_t kSlots = size_t(1) << kSlotBits;
+    static constexpr size_t kLevels = 4;
+    // 超出该范围的到期时间被截断到最远可表示的 tick
+    static constexpr uint64_t kMaxDelay = (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+
+    explicit TimerWheel(uint64_t startTick = 0);
+
+    // 到期时间不晚于当前 tick 的定时器在下一个 tick 到期
+    void schedule(uint64_t id, uint64_t expiryTick);
+    // 推进到 tick（含），按到期顺序把到期的 id 追加到 expired
+    void advance(uint64_t tick, std::vector<uint64_t> &expired);
+
+    uint64_t currentTick() const { return current_; }
+    size_t size() const { return size_; }
+
+private:
+    struct Entry
+    {
+        uint64_t id;
+        uint64_t expiry;
+    };
+
+    // 按距离当前 tick 的远近选择层级，槽位由到期时间在该层的位决定
+    void place(const Entry &entry);
+    // 把高层槽位中的定时器重新放入更低的层
+    void cascade(size_t level);
+
+    std::vector<Entry> slots_[kLevels][kSlots];
+    uint64_t current_;
+    size_t size_ = 0;
+};
@@ -1,4 +1,5 @@
 #include "UserManager.h"
+#include "UserStore.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -11,53 +12,71 @@
 #include <Poco/DigestEngine.h>
 #include <Poco/Random.h>
 
-UserManager::UserManager() : usersFilePath_("config/users.json")
+UserManager::UserManager() : usersFilePath_("config/users.json"), storeDirectory_("config/userstore")
 {
     initializeRandomGenerator();
-    users_.clear();
-    accountIndex_.clear();
 }
 
+UserManager::~UserManager() = default;
+
 UserManager &UserManager::getInstance()
 {
     static UserManager instance;
     return instance;
 }
 
-User UserManager::loadUserFromFile(const std::string &account)
+bool UserManager::load()
 {
-    std::ifstream file(usersFilePath_);
-    if (!file.is_open())
+    std::lock_guard<std::mutex> storeLock(storeMutex_);
+    auto store = std::make_unique<UserStore>(storeDirectory_);
+    std::vector<User> users;
+    if (!store->load(users))
     {
-        return User{};
+        return false;
     }
 
-    try
+    if (!store->hasSnapshot())
     {
-        Poco::JSON::Parser parser;
-        Poco::Dynamic::Var result = parser.parse(file);
-        Poco::JSON::Object::Ptr json = result.extract<Poco::JSON::Object::Ptr>();
-
-        if (json->has("users"))
+        // 一次性迁移：旧 JSON 文件中的用户加上日志中已有的注册写成第一份快照（可能为空）。
+        // 快照落盘前崩溃或写入失败时下次启动会重新迁移，日志中的记录更新，覆盖同一账号
+        std::vector<User> migrated = loadAllUsersFromFile();
+        std::unordered_map<std::string, size_t> index;
+        for (size_t i = 0; i < migrated.size(); ++i)
         {
-            Poco::JSON::Array::Ptr usersArray = json->getArray("users");
-            for (const auto &userVar : *usersArray)
+            index[migrated[i].account] = i;
+        }
+        for (auto &user : users)
+        {
+            auto it = index.find(user.account);
+            if (it != index.end())
             {
-                Poco::JSON::Object::Ptr userJson = userVar.extract<Poco::JSON::Object::Ptr>();
-                User user = User::fromJson(userJson);
-                if (user.account == account)
-                {
-                    return user;
-                }
+                migrated[it->second] = std::move(user);
+            }
+            else
+            {
+                index.emplace(user.account, migrated.size());
+                migrated.push_back(std::move(user));
             }
         }
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Error loading user from file: " << e.what() << std::endl;
+        users = std::move(migrated);
+        if (!store->compact(users))
+        {
+            return false;
+        }
     }
 
-    return User{};
+    std::unique_lock<std::shared_mutex> lock(usersMutex_);
+    store_ = std::move(store);
+    users_ = std::move(users);
+    rebuildAccountIndex();
+    onlineAccounts_.clear();
+    return true;
+}
+
+size_t UserManager::getUserCount() const
+{
+    std::shared_lock<std::shared_mutex> lock(usersMutex_);
+    return users_.size();
 }
 
 std::vector<User> UserManager::loadAllUsersFromFile()
@@ -95,68 +114,6 @@ std::vector<User> UserManager::loadAllUsersFromFile()
     return allUsers;
 }
 
-void UserManager::appendUserToFile(const User &user)
-{
-    Poco::JSON::Object j;
-    Poco::JSON::Array::Ptr usersArray;
-
-    // 尝试读取现有文件
-    std::ifstream inFile(usersFilePath_);
-    if (inFile.is_open())
-    {
-        try
-        {
-            Poco::JSON::Parser parser;
-            Poco::Dynamic::Var result = parser.parse(inFile);
-            Poco::JSON::Object::Ptr existingJson = result.extract<Poco::JSON::Object::Ptr>();
-
-            if (existingJson->has("users"))
-            {
-                usersArray = existingJson->getArray("users");
-            }
-            else
-            {
-                usersArray = new Poco::JSON::Array;
-            }
-        }
-        catch (const std::exception &e)
-        {
-            std::cerr << "Error reading existing users file: " << e.what() << std::endl;
-            usersArray = new Poco::JSON::Array;
-        }
-        inFile.close();
-    }
-    else
-    {
-        usersArray = new Poco::JSON::Array;
-    }
-
-    // 添加新用户
-    usersArray->add(user.toJson());
-    j.set("users", usersArray);
-
-    // 写入文件
-    std::ofstream outFile(usersFilePath_);
-    if (outFile.is_open())
-    {
-        try
-        {
-            std::ostringstream oss;
-            j.stringify(oss, 2);
-            outFile << oss.str();
-            outFile.flush();
-        }
-        catch (const std::exception &e)
-        {
-            std::cerr << "Error saving user to file: " << e.what() << std::endl;
-        }
-    }
-    else
-    {
-        std::cerr << "Failed to open users file for writing: " << usersFilePath_ << std::endl;
-    }
-}
-
 void UserManager::initializeRandomGenerator()
 {
     // 使用当前时间作为随机种子
@@ -218,7 +175,7 @@ void UserManager::rebuildAccountIndex()
     }
 }
 
-User *UserManager::findUserByAccount(const std::string &account)
+const User *UserManager::findUserByAccount(const std::string &account) const
 {
     auto it = accountIndex_.find(account);
     if (it != accountIndex_.end() && it->second < users_.size())
@@ -228,153 +185,115 @@ User *UserManager::findUserByAccount(const std::string &account)
     return nullptr;
 }
 
-bool UserManager::accountExists(const std::string &account)
-{
-    return accountExistsInFile(account);
-}
-
-bool UserManager::accountExistsInFile(const std::string &account)
-{
-    User user = loadUserFromFile(account);
-    return !user.account.empty();
-}
-
-User *UserManager::findUserFromFile(const std::string &account)
+bool UserManager::accountExists(const std::string &account) const
 {
-    static User foundUser = loadUserFromFile(account);
-    if (!foundUser.account.empty())
-    {
-        return &foundUser;
-    }
-    return nullptr;
+    return accountIndex_.count(account) != 0;
 }
 
 std::string UserManager::registerUser(const std::string &username, const std::string &password)
 {
-    std::lock_guard<std::mutex> lock(usersMutex_);
-
     // 验证用户名和密码格式
     if (username.empty() || password.length() < 6)
     {
         return "";
     }
 
-    // 生成基于哈希的随机用户ID
-    std::string account = generateHashBasedAccount(username);
+    // 哈希计算不需要持有锁
+    std::string passwordHash = hashPassword(password);
 
-    if (account.empty())
+    // 注册之间由 storeMutex_ 串行化：生成的账号在写入目录之前不会被另一次注册占用
+    std::lock_guard<std::mutex> storeLock(storeMutex_);
+    if (!store_)
     {
-        std::cerr << "Failed to generate unique user ID" << std::endl;
         return "";
     }
 
-    // 创建新用户
     User newUser;
-    newUser.username = username;
-    newUser.account = account;
-    newUser.passwordHash = hashPassword(password);
-
-    // 向文件追加新用户
-    appendUserToFile(newUser);
+    {
+        std::unique_lock<std::shared_mutex> lock(usersMutex_);
 
-    return account;
-}
+        // 生成基于哈希的随机用户ID
+        newUser.account = generateHashBasedAccount(username);
+    }
+    if (newUser.account.empty())
+    {
+        std::cerr << "Failed to generate unique user ID" << std::endl;
+        return "";
+    }
+    newUser.username = username;
+    newUser.passwordHash = passwordHash;
+    std::string account = newUser.account;
 
-bool UserManager::authenticateUser(const std::string &account, const std::string &password)
-{
-    std::lock_guard<std::mutex> lock(usersMutex_);
+    // 先落盘再加入目录，写入失败时注册失败；落盘期间登录查询照常进行
+    if (!store_->append(newUser))
+    {
+        return "";
+    }
 
-    // 从文件中加载单个用户
-    User user = loadUserFromFile(account);
-    if (!user.account.empty())
+    std::vector<User> snapshot;
+    bool compact = store_->needsCompaction();
     {
-        std::string hashedPassword = hashPassword(password);
-        if (hashedPassword == user.passwordHash)
+        std::unique_lock<std::shared_mutex> lock(usersMutex_);
+        accountIndex_[account] = users_.size();
+        users_.push_back(std::move(newUser));
+        if (compact)
         {
-            // 验证成功，添加到在线用户列表
-            addUserToOnlineList(user);
-            return true;
+            // 只在锁内复制内存中的目录，重写快照在锁外进行
+            snapshot = users_;
         }
     }
 
-    return false;
-}
+    if (compact)
+    {
+        store_->compact(snapshot);
+    }
 
-void UserManager::addUserToOnlineList(const User &user)
-{
-    accountIndex_[user.account] = users_.size();
-    users_.push_back(user);
+    return account;
 }
 
-void UserManager::removeUserFromOnlineList(const std::string &account)
+bool UserManager::authenticateUser(const std::string &account, const std::string &password)
 {
-    auto it = accountIndex_.find(account);
-    if (it != accountIndex_.end())
-    {
-        size_t index = it->second;
+    std::string hashedPassword = hashPassword(password);
 
-        if (index < users_.size())
-        {
-            accountIndex_.erase(it);
-
-            if (index != users_.size() - 1)
-            {
-                users_[index] = users_.back();
-                accountIndex_[users_[index].account] = index;
-            }
-            users_.pop_back();
-        }
-        else
+    {
+        std::shared_lock<std::shared_mutex> lock(usersMutex_);
+        const User *user = findUserByAccount(account);
+        if (!user || hashedPassword != user->passwordHash)
         {
-            accountIndex_.erase(it);
+            return false;
         }
     }
+
+    // 验证成功，标记为在线
+    std::unique_lock<std::shared_mutex> lock(usersMutex_);
+    onlineAccounts_.insert(account);
+    return true;
 }
 
 User UserManager::getUserByAccount(const std::string &account)
 {
-    std::lock_guard<std::mutex> lock(usersMutex_);
-
-    // 首先在在线用户中查找
-    User *user = findUserByAccount(account);
-    if (user)
-    {
-        return *user;
-    }
+    std::shared_lock<std::shared_mutex> lock(usersMutex_);
 
-    // 如果不在线，从文件中加载
-    return loadUserFromFile(account);
+    const User *user = findUserByAccount(account);
+    return user ? *user : User{};
 }
 
 bool UserManager::setUserStatus(const std::string &account, bool online)
 {
-    std::lock_guard<std::mutex> lock(usersMutex_);
+    std::unique_lock<std::shared_mutex> lock(usersMutex_);
 
     if (online)
     {
-        User user = loadUserFromFile(account);
-        if (!user.account.empty())
-        {
-            // 检查是否已经在在线列表中
-            if (findUserByAccount(account) == nullptr)
-            {
-                addUserToOnlineList(user);
-            }
-            return true;
-        }
-    }
-    else
-    {
-        // 用户下线：从在线列表中移除
-        User *user = findUserByAccount(account);
-        if (user)
+        if (!accountExists(account))
         {
-            removeUserFromOnlineList(account);
-            return true;
+            return false;
         }
+        onlineAccounts_.insert(account);
+        return true;
     }
 
-    return false;
+    // 用户下线：从在线列表中移除
+    return onlineAccounts_.erase(account) != 0;
 }
 
 std::string UserManager::hashPassword(const std::string &password)
@@ -2,9 +2,12 @@
 #include <string>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
+#include <shared_mutex>
 #include <vector>
 #include <Poco/JSON/Object.h>
+#include <memory>
 #include <random>
 
 struct User
@@ -17,11 +20,22 @@ struct User
     static User fromJson(const Poco::JSON::Object::Ptr &j);
 };
 
+class UserStore;
+
+// 用户目录：启动时把全部用户一次性载入内存并按账号建立哈希索引，
+// 登录、查询都是 O(1) 查找，注册只向 UserStore 的日志追加一条记录
 class UserManager
 {
 public:
     static UserManager &getInstance();
 
+    // 从 UserStore 载入全部用户，替换当前目录。
+    // 存储还没有快照时从旧的 users.json 迁移，快照写成后不再读取该文件
+    bool load();
+    void setUsersFilePath(const std::string &path) { usersFilePath_ = path; }
+    void setStoreDirectory(const std::string &directory) { storeDirectory_ = directory; }
+    size_t getUserCount() const;
+
     // 用户认证
     bool authenticateUser(const std::string &account, const std::string &password);
 
@@ -37,24 +51,25 @@ public:
 
 private:
     UserManager();
-    std::vector<User> users_;                              // 只存储在线用户
-    std::unordered_map<std::string, size_t> accountIndex_; // account到users_索引的映射(仅在线用户)
-    std::mutex usersMutex_;
-    std::string usersFilePath_;
+    ~UserManager();
+    std::vector<User> users_;                              // 全部注册用户，按注册顺序
+    std::unordered_map<std::string, size_t> accountIndex_; // account到users_索引的映射
+    std::unordered_set<std::string> onlineAccounts_;
+    mutable std::shared_mutex usersMutex_;
+    // 串行化 store_ 的磁盘读写；落盘期间不持有 usersMutex_，登录查询不被注册的 fsync 阻塞。
+    // 需要同时持有时先取 storeMutex_
+    std::mutex storeMutex_;
+    std::string usersFilePath_; // 旧版 JSON 用户文件，仅用于迁移
+    std::string storeDirectory_;
+    std::unique_ptr<UserStore> store_;
 
     // 随机数生成器用于生成随机种子
     std::mt19937_64 randomGenerator_;
 
-    User loadUserFromFile(const std::string &account);
     std::vector<User> loadAllUsersFromFile();
-    void appendUserToFile(const User &user);
     std::string generateHashBasedAccount(const std::string &username);
-    bool accountExistsInFile(const std::string &account);
-    User *findUserFromFile(const std::string &account);
     void initializeRandomGenerator();
     void rebuildAccountIndex();
-    User *findUserByAccount(const std::string &account);
-    void addUserToOnlineList(const User &user);
-    void removeUserFromOnlineList(const std::string &account);
-    bool accountExists(const std::string &account);
-};
\ No newline at end of file
+    const User *findUserByAccount(const std::string &account) const;
+    bool accountExists(const std::string &account) const;
+};
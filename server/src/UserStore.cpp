@@ -0,0 +1,202 @@
+#include "UserStore.h"
+#include "AsyncLog.h"
+#include "UserManager.h"
+#include "BinaryCodec.h"
+#include "RecordIO.h"
+#include <Poco/File.h>
+#include <unordered_map>
+
+namespace
+{
+    constexpr uint8_t kUserRecord = 1;
+    // 日志至少积累这么多条记录才考虑压缩，避免用户很少时频繁重写快照
+    constexpr size_t kMinCompactRecords = 1024;
+
+    void encodeRecord(std::string &out, const User &user)
+    {
+        std::string payload;
+        BinaryWriter writer(payload);
+        writer.writeByte(kUserRecord);
+        writer.writeString(user.account);
+        writer.writeString(user.username);
+        writer.writeString(user.passwordHash);
+        RecordIO::appendRecord(out, payload);
+    }
+
+    // 重放一个文件中的全部记录，返回完整记录的字节数
+    size_t replay(const std::string &data, std::vector<User> &users, std::unordered_map<std::string, size_t> &index, size_t &records)
+    {
+        size_t offset = 0;
+        std::string_view payload;
+        while (true)
+        {
+            size_t next = offset;
+            if (!RecordIO::nextRecord(data, next, payload))
+            {
+                break;
+            }
+
+            BinaryReader reader(payload.data(), payload.size());
+            uint8_t type = 0;
+            User user;
+            if (!reader.readByte(type) || type != kUserRecord || !reader.readString(user.account) ||
+                !reader.readString(user.username) || !reader.readString(user.passwordHash))
+            {
+                break;
+            }
+
+            auto it = index.find(user.account);
+            if (it != index.end())
+            {
+                users[it->second] = std::move(user);
+            }
+            else
+            {
+                index.emplace(user.account, users.size());
+                users.push_back(std::move(user));
+            }
+            ++records;
+            offset = next;
+        }
+        return offset;
+    }
+}
+
+UserStore::UserStore(const std::string &directory)
+    : directory_(directory), snapshotPath_(directory + "/users.snapshot"), journalPath_(directory + "/users.journal")
+{
+}
+
+UserStore::~UserStore()
+{
+    closeJournal();
+}
+
+bool UserStore::hasSnapshot() const
+{
+    return Poco::File(snapshotPath_).exists();
+}
+
+bool UserStore::load(std::vector<User> &users)
+{
+    closeJournal();
+    Poco::File(directory_).createDirectories();
+
+    users.clear();
+    std::unordered_map<std::string, size_t> index;
+    snapshotRecords_ = 0;
+    journalRecords_ = 0;
+
+    std::string data;
+    if (RecordIO::readFile(snapshotPath_, data))
+    {
+        size_t valid = replay(data, users, index, snapshotRecords_);
+        if (valid != data.size())
+        {
+            // 快照总是先完整写入临时文件再改名，不应出现残缺
+            LOG_ERROR("UserStore", "用户快照已损坏，仅恢复了前 " + std::to_string(snapshotRecords_) + " 条记录");
+        }
+    }
+
+    if (RecordIO::readFile(journalPath_, data))
+    {
+        size_t valid = replay(data, users, index, journalRecords_);
+        if (valid != data.size())
+        {
+            LOG_WARNING("UserStore", "用户日志末尾有 " + std::to_string(data.size() - valid) + " 字节不完整记录，已截断");
+            Poco::File(journalPath_).setSize(valid);
+        }
+    }
+
+    return openJournal("ab");
+}
+
+bool UserStore::append(const User &user)
+{
+    if (!journal_)
+    {
+        return false;
+    }
+
+    std::string record;
+    encodeRecord(record, user);
+    if (std::fwrite(record.data(), 1, record.size(), journal_) != record.size() || !RecordIO::syncFile(journal_))
+    {
+        LOG_ERROR("UserStore", "写入用户日志失败: " + journalPath_);
+        return false;
+    }
+    ++journalRecords_;
+    return true;
+}
+
+bool UserStore::needsCompaction() const
+{
+    // 日志不超过快照大小时重放代价最多翻倍，压缩的总开销按注册次数均摊为常数
+    return journalRecords_ >= kMinCompactRecords && journalRecords_ > snapshotRecords_;
+}
+
+bool UserStore::compact(const std::vector<User> &users)
+{
+    std::string tempPath = snapshotPath_ + ".tmp";
+
+    std::FILE *file = std::fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        LOG_ERROR("UserStore", "无法创建用户快照: " + tempPath);
+        return false;
+    }
+
+    std::string buffer;
+    bool ok = true;
+    for (const auto &user : users)
+    {
+        encodeRecord(buffer, user);
+        if (buffer.size() >= 1024 * 1024)
+        {
+            ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            buffer.clear();
+        }
+    }
+    ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    ok = RecordIO::syncFile(file) && ok;
+    std::fclose(file);
+    if (!ok)
+    {
+        LOG_ERROR("UserStore", "写入用户快照失败: " + tempPath);
+        Poco::File(tempPath).remove();
+        return false;
+    }
+
+    // 改名之后、清空日志之前崩溃也没有问题：重放时日志中的记录会覆盖快照里的同一账号。
+    // 改名落盘之前不能清空日志，否则掉电后新快照和日志中的记录可能一起丢失
+    Poco::File(tempPath).renameTo(snapshotPath_);
+    if (!RecordIO::syncDirectory(directory_))
+    {
+        LOG_ERROR("UserStore", "无法把用户快照改名刷到磁盘，保留日志: " + directory_);
+        return false;
+    }
+    snapshotRecords_ = users.size();
+    journalRecords_ = 0;
+    closeJournal();
+    return openJournal("wb");
+}
+
+bool UserStore::openJournal(const char *mode)
+{
+    journal_ = std::fopen(journalPath_.c_str(), mode);
+    if (!journal_)
+    {
+        LOG_ERROR("UserStore", "无法打开用户日志: " + journalPath_);
+        return false;
+    }
+    return true;
+}
+
+void UserStore::closeJournal()
+{
+    if (journal_)
+    {
+        std::fclose(journal_);
+        journal_ = nullptr;
+    }
+}
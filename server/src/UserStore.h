@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct User;
+
+// 持久化用户存储：一个压缩后的快照文件 + 一个只追加的日志文件。
+// 每条记录为 4字节长度 + 4字节CRC32 + 二进制负载；注册只追加一条记录并落盘，
+// 日志记录数超过快照时把全部用户重写为新快照（先写临时文件再原子改名）并清空日志。
+// 重放时遇到不完整或校验失败的记录（写入中途崩溃）即停止，并把日志截断到最后一条完整记录。
+class UserStore
+{
+public:
+    explicit UserStore(const std::string &directory);
+    ~UserStore();
+
+    // 依次重放快照和日志；同一账号以最后一条记录为准
+    bool load(std::vector<User> &users);
+    // 快照只在完整写入并改名落盘后才出现，可作为旧数据迁移已完成的标志
+    bool hasSnapshot() const;
+
+    bool append(const User &user);
+    bool needsCompaction() const;
+    bool compact(const std::vector<User> &users);
+
+    size_t getSnapshotRecords() const { return snapshotRecords_; }
+    size_t getJournalRecords() const { return journalRecords_; }
+
+private:
+    UserStore(const UserStore &) = delete;
+    UserStore &operator=(const UserStore &) = delete;
+
+    bool openJournal(const char *mode);
+    void closeJournal();
+
+    std::string directory_;
+    std::string snapshotPath_;
+    std::string journalPath_;
+    std::FILE *journal_ = nullptr;
+    size_t snapshotRecords_ = 0;
+    size_t journalRecords_ = 0;
+};
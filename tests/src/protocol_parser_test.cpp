@@ -0,0 +1,170 @@
+// 协议解析器的回归测试：单遍 JSON 解析、按需解码的聊天信封和二进制格式
+// 用法: protocol_parser_test，全部通过时返回 0
+#include "BinaryCodec.h"
+#include "ChatEnvelope.h"
+#include "Message.h"
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    void testJsonFields()
+    {
+        auto parsed = Message::parseMessage(R"({"account":"alice","id":7,"password":"secret","timestamp":1,"type":3})");
+        check(parsed && parsed->getType() == MessageType::LOGIN_REQUEST, "JSON 登录请求在 type 之前的字段回放");
+        if (parsed && parsed->getType() == MessageType::LOGIN_REQUEST)
+        {
+            auto &login = static_cast<LoginRequest &>(*parsed);
+            check(login.getAccount() == "alice" && login.getPassword() == "secret" && login.getId() == 7,
+                  "JSON 登录请求字段");
+        }
+    }
+
+    void testBinaryRoundTrip()
+    {
+        ChatMessage message("123456789", "alice", "bob", "hi");
+        auto parsed = Message::parseMessage(message.serializeBinary());
+        check(parsed && parsed->getType() == MessageType::PRIVATE_MESSAGE, "二进制私聊消息往返");
+    }
+
+    // 重复的 "type" 不能把已构造的 RoomRequest 改成 LOGIN_REQUEST，否则处理方会按错误的类型转换
+    void testDuplicateTypeKey()
+    {
+        check(!Message::parseMessage(R"({"type":40,"type":3,"account":"a","password":"b","room":"r"})"),
+              "JSON 中类型不同的重复 type 被拒绝");
+        check(!Message::parseMessage(R"({"account":"a","type":3,"password":"b","type":40})"),
+              "JSON 中位于字段之后的重复 type 被拒绝");
+
+        auto same = Message::parseMessage(R"({"type":40,"room":"r","type":40})");
+        check(same && same->getType() == MessageType::ROOM_JOIN, "JSON 中相同的重复 type 仍可解析");
+
+        ChatEnvelope envelope;
+        check(!envelope.parse(R"({"type":11,"receiver":"bob","type":10,"content":"hi"})"),
+              "聊天信封拒绝类型不同的重复 type");
+        check(envelope.parse(R"({"type":11,"receiver":"bob","content":"hi"})") && envelope.isPrivateMessage(),
+              "聊天信封解析私聊消息");
+    }
+
+    // 重发标记只追加在顶层聊天消息末尾，不带标记的编码保持不变，服务器的信封解析能识别两种编码
+    void testRetransmitFlag()
+    {
+        ChatMessage message("123456789", "alice", "bob", "hi");
+        std::string plain = message.serializeBinary();
+        message.setRetransmit(true);
+        std::string marked = message.serializeBinary();
+        check(marked.size() == plain.size() + 1 && marked.compare(0, plain.size(), plain) == 0, "重发标记追加在二进制编码末尾");
+
+        auto parsed = Message::parseMessage(marked);
+        check(parsed && static_cast<ChatMessage &>(*parsed).isRetransmit(), "二进制消息往返保留重发标记");
+        parsed = Message::parseMessage(plain);
+        check(parsed && !static_cast<ChatMessage &>(*parsed).isRetransmit(), "不带标记的二进制消息不是重发");
+
+        ChatEnvelope envelope;
+        check(envelope.parse(marked) && envelope.isRetransmit(), "聊天信封识别二进制重发标记");
+        check(envelope.parse(plain) && !envelope.isRetransmit(), "聊天信封解析不带标记的二进制消息");
+        check(envelope.parse(R"({"type":11,"id":7,"receiver":"bob","content":"hi","retransmit":1})") && envelope.isRetransmit() &&
+                  envelope.getClientId() == 7,
+              "聊天信封识别 JSON 重发标记");
+        check(envelope.parse(R"({"type":11,"id":7,"receiver":"bob","content":"hi"})") && !envelope.isRetransmit(),
+              "聊天信封解析不带标记的 JSON 消息");
+    }
+
+    // 服务器在登录响应末尾声明能力，不声明时保持原来的编码，客户端据此决定是否发送 CAPABILITIES 和 HEARTBEAT
+    void testLoginCapabilities()
+    {
+        LoginResponse response(MessageStatus::SUCCESS, "123456789", "alice", "登录成功");
+        std::string plain = response.serializeBinary();
+        response.setCapabilities(kCapabilityRetransmit | kCapabilityHeartbeat);
+        std::string advertised = response.serializeBinary();
+        check(advertised.size() > plain.size() && advertised.compare(0, plain.size(), plain) == 0, "能力位追加在二进制登录响应末尾");
+
+        auto parsed = Message::parseMessage(advertised);
+        check(parsed && parsed->getType() == MessageType::LOGIN_RESPONSE &&
+                  static_cast<LoginResponse &>(*parsed).getCapabilities() == (kCapabilityRetransmit | kCapabilityHeartbeat),
+              "二进制登录响应往返保留能力位");
+        parsed = Message::parseMessage(plain);
+        check(parsed && static_cast<LoginResponse &>(*parsed).getCapabilities() == 0, "不带能力位的二进制登录响应视为旧服务器");
+
+        auto json = Message::parseMessage(R"({"type":4,"status":0,"account":"a","username":"u","message":"m","capabilities":10})");
+        check(json && json->getType() == MessageType::LOGIN_RESPONSE && static_cast<LoginResponse &>(*json).getCapabilities() == 10,
+              "JSON 登录响应解析能力位");
+        auto old = Message::parseMessage(R"({"type":4,"status":0,"account":"a","username":"u","message":"m"})");
+        check(old && static_cast<LoginResponse &>(*old).getCapabilities() == 0, "没有 capabilities 的 JSON 登录响应视为旧服务器");
+    }
+
+    // has_more 告诉客户端响应因大小上限被截断，两种编码都要保留
+    void testHistoryHasMore()
+    {
+        HistoryResponse response(MessageStatus::SUCCESS, "#r");
+        response.addMessage(ChatMessage(MessageType::ROOM_MESSAGE, "alice", "alice", "r", "hi"));
+        response.setHasMore(true);
+
+        auto binary = Message::parseMessage(response.serializeBinary());
+        check(binary && binary->getType() == MessageType::HISTORY_RESPONSE &&
+                  static_cast<HistoryResponse &>(*binary).hasMore() && static_cast<HistoryResponse &>(*binary).getMessages().size() == 1,
+              "二进制历史响应保留 has_more");
+
+        auto json = Message::parseMessage(R"({"type":14,"status":0,"target":"#r","messages":[],"has_more":1})");
+        check(json && json->getType() == MessageType::HISTORY_RESPONSE && static_cast<HistoryResponse &>(*json).hasMore(),
+              "JSON 历史响应解析 has_more");
+        auto complete = Message::parseMessage(R"({"type":14,"status":0,"target":"#r","messages":[]})");
+        check(complete && !static_cast<HistoryResponse &>(*complete).hasMore(), "没有 has_more 的历史响应视为完整");
+    }
+
+    // 10 字节变长整数的最后一个字节只能是 0 或 1，否则超出 64 位
+    void testVarUIntOverflow()
+    {
+        std::string max(9, '\xFF');
+        max.push_back('\x01');
+        uint64_t value = 0;
+        BinaryReader maxReader(max.data(), max.size());
+        check(maxReader.readVarUInt(value) && value == UINT64_MAX, "10 字节变长整数解析出 UINT64_MAX");
+
+        std::string overflow(9, '\xFF');
+        overflow.push_back('\x02');
+        BinaryReader overflowReader(overflow.data(), overflow.size());
+        check(!overflowReader.readVarUInt(value), "超出 64 位的变长整数被拒绝");
+
+        std::string tooLong(10, '\x80');
+        tooLong.push_back('\x00');
+        BinaryReader tooLongReader(tooLong.data(), tooLong.size());
+        check(!tooLongReader.readVarUInt(value), "超过 10 字节的变长整数被拒绝");
+    }
+
+    void testMalformed()
+    {
+        check(!Message::parseMessage(R"({"room":"r"})"), "缺少 type 的 JSON 被拒绝");
+        check(!Message::parseMessage(R"({"type":40,"room":"r")"), "未闭合的 JSON 被拒绝");
+        check(!Message::parseMessage(R"({"type":255})"), "未知类型被拒绝");
+    }
+}
+
+int main()
+{
+    testJsonFields();
+    testBinaryRoundTrip();
+    testDuplicateTypeKey();
+    testRetransmitFlag();
+    testLoginCapabilities();
+    testHistoryHasMore();
+    testVarUIntOverflow();
+    testMalformed();
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
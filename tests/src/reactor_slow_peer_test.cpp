@@ -0,0 +1,132 @@
+// 事件驱动模式的慢消费者回归测试：一个连接不停发送请求却从不读取回复，把服务器到它的发送缓冲区填满；
+// 同一反应器线程上的另一个连接仍应及时收到回复（连接套接字为非阻塞，反应器线程不会卡在写上）
+// 用法: reactor_slow_peer_test，通过时返回 0
+#include "AsyncLog.h"
+#include "Frame.h"
+#include "FrameDecoder.h"
+#include "Message.h"
+#include "ReactorServer.h"
+#include <Poco/Exception.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/StreamSocket.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void sendMessage(Poco::Net::StreamSocket &socket, const Message &message)
+    {
+        FramePtr frame = Frame::create(message, WireFormat::JSON);
+        size_t sent = 0;
+        while (sent < frame->size())
+        {
+            sent += static_cast<size_t>(socket.sendBytes(frame->data() + sent, static_cast<int>(frame->size() - sent)));
+        }
+    }
+
+    // 在 timeout 内等到一条 HISTORY_RESPONSE
+    bool receiveHistoryResponse(Poco::Net::StreamSocket &socket, std::chrono::milliseconds timeout)
+    {
+        FrameDecoder decoder;
+        auto deadline = Clock::now() + timeout;
+        socket.setReceiveTimeout(Poco::Timespan(0, 100 * 1000));
+        while (Clock::now() < deadline)
+        {
+            std::string_view payload;
+            while (decoder.nextFrame(payload))
+            {
+                auto message = Message::parseMessage(payload);
+                if (message && message->getType() == MessageType::HISTORY_RESPONSE)
+                {
+                    return true;
+                }
+            }
+            try
+            {
+                if (decoder.readFrom(socket) == FrameDecoder::ReadResult::CLOSED)
+                {
+                    return false;
+                }
+            }
+            catch (const Poco::TimeoutException &)
+            {
+            }
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    AsyncLog::getInstance().setLevel(Poco::Message::PRIO_ERROR);
+
+    Poco::Net::ServerSocket listener(Poco::Net::SocketAddress("127.0.0.1", 0));
+    Poco::Net::SocketAddress address("127.0.0.1", listener.address().port());
+    // 只有一个 I/O 反应器，两个连接由同一个线程服务
+    ReactorServer server(listener, 1);
+    server.start();
+
+    // 慢对端：接收缓冲区尽量小，只发未登录也会得到回复的历史请求，从不读取
+    Poco::Net::StreamSocket slow(Poco::Net::SocketAddress::IPv4);
+    slow.setReceiveBufferSize(4096);
+    slow.connect(address);
+
+    std::atomic<bool> flooding{true};
+    std::atomic<size_t> requests{0};
+    std::thread flooder([&]
+                        {
+        HistoryRequest request("", 1);
+        try
+        {
+            // 服务器不再读取时发送阻塞，测试结束时关闭套接字使其返回
+            while (flooding)
+            {
+                sendMessage(slow, request);
+                ++requests;
+            }
+        }
+        catch (const Poco::Exception &)
+        {
+        } });
+
+    Poco::Net::StreamSocket fast;
+    fast.connect(address);
+
+    // 先让回复在慢对端的连接上积压到超过套接字缓冲区
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+
+    int failures = 0;
+    for (int round = 0; round < 5; ++round)
+    {
+        auto start = Clock::now();
+        sendMessage(fast, HistoryRequest("", 1));
+        bool received = receiveHistoryResponse(fast, std::chrono::milliseconds(3000));
+        double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (!received)
+        {
+            std::fprintf(stderr, "FAILED: round %d: no reply on the reading connection within %.0f ms\n", round, elapsedMs);
+            ++failures;
+        }
+    }
+
+    flooding = false;
+    slow.shutdown();
+    flooder.join();
+    fast.close();
+    slow.close();
+    server.stop();
+
+    std::printf("slow peer sent %zu requests without reading\n", requests.load());
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d round(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}